@@ -0,0 +1,57 @@
+include(ExternalProject)
+
+# Builds a static fftw for loris to link against when no system package is
+# available. A release source tree checked out at dep/fftw is used when
+# present, otherwise the release tarball is fetched. Building from the fftw
+# git repository is not supported since it requires OCaml to generate the
+# codelets.
+
+set(FFTW_VERSION 3.3.10)
+set(fftw_PREFIX ${PROJECT_BINARY_DIR}/fftw-prefix)
+
+if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/dep/fftw/configure)
+    set(fftw_SOURCE SOURCE_DIR ${CMAKE_CURRENT_SOURCE_DIR}/dep/fftw)
+else()
+    set(fftw_SOURCE
+        URL https://www.fftw.org/fftw-${FFTW_VERSION}.tar.gz
+        URL_HASH MD5=8ccbf6a5ea78a16dbc3e1306e234cc5c
+    )
+endif()
+
+set(fftw_CONFIGURE_OPTIONS --enable-static --disable-shared --enable-threads --with-pic --disable-fortran --disable-doc)
+if(CMAKE_SYSTEM_PROCESSOR MATCHES "x86_64|AMD64")
+    list(APPEND fftw_CONFIGURE_OPTIONS --enable-sse2 --enable-avx)
+endif()
+
+set(fftw_LIBRARY
+    "${fftw_PREFIX}/lib/${CMAKE_STATIC_LIBRARY_PREFIX}fftw3${CMAKE_STATIC_LIBRARY_SUFFIX}"
+)
+set(fftw_THREADS_LIBRARY
+    "${fftw_PREFIX}/lib/${CMAKE_STATIC_LIBRARY_PREFIX}fftw3_threads${CMAKE_STATIC_LIBRARY_SUFFIX}"
+)
+
+ExternalProject_Add(fftw
+    ${fftw_SOURCE}
+    PREFIX ${fftw_PREFIX}
+    UPDATE_DISCONNECTED true # do not attempt to update source on rebuild
+    CONFIGURE_COMMAND <SOURCE_DIR>/configure --prefix=<INSTALL_DIR> ${fftw_CONFIGURE_OPTIONS}
+    BUILD_COMMAND make -j${Ncpu}
+    BUILD_BYPRODUCTS ${fftw_LIBRARY} ${fftw_THREADS_LIBRARY}
+)
+
+# HACK: create the install directories so that the target_include_directories function does not error during configure.
+file(MAKE_DIRECTORY ${fftw_PREFIX}/include)  # avoid race condition
+file(MAKE_DIRECTORY ${fftw_PREFIX}/lib)  # avoid race condition
+
+add_library(fftw::fftw3 STATIC IMPORTED GLOBAL)
+set_target_properties(fftw::fftw3 PROPERTIES
+    IMPORTED_LOCATION ${fftw_LIBRARY}
+    INTERFACE_INCLUDE_DIRECTORIES ${fftw_PREFIX}/include
+)
+add_dependencies(fftw::fftw3 fftw)
+
+# mirror the variables pkg_check_modules provides for a system fftw
+set(FFTW_FOUND TRUE)
+set(FFTW_STATIC_CFLAGS "-I${fftw_PREFIX}/include")
+set(FFTW_STATIC_LDFLAGS "-L${fftw_PREFIX}/lib")
+set(FFTW_THREADS_LIBRARY ${fftw_THREADS_LIBRARY})
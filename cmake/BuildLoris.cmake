@@ -6,7 +6,34 @@ set(loris_SOURCE_DIR ${CMAKE_CURRENT_SOURCE_DIR}/dep/loris)
 find_program(AUTOUPDATE_COMMAND NAMES autoupdate)
 find_program(AUTORECONF_COMMAND NAMES autoreconf)
 
-pkg_check_modules(FFTW fftw3 IMPORTED_TARGET)
+# Select the FFT used by loris, see ${PROJECT_NAME}_FFT_BACKEND. The loris
+# built in FFT is an order of magnitude slower than fftw so it is never
+# selected implicitly.
+set(fft_backend ${${PROJECT_NAME}_FFT_BACKEND})
+if(fft_backend STREQUAL "auto" OR fft_backend STREQUAL "system")
+    pkg_check_modules(FFTW fftw3 IMPORTED_TARGET)
+    if(FFTW_FOUND)
+        set(fft_backend "system")
+        # the fftw planner is only thread safe when the threads library is linked
+        find_library(FFTW_THREADS_LIBRARY fftw3_threads HINTS ${FFTW_LIBRARY_DIRS})
+        set(FFTW_TARGET PkgConfig::FFTW)
+    elseif(fft_backend STREQUAL "system")
+        message(FATAL_ERROR "fftw3 not found by pkg-config; install it or set ${PROJECT_NAME}_FFT_BACKEND to static")
+    else()
+        message(STATUS "fftw3 not found by pkg-config, building a static fftw")
+        set(fft_backend "static")
+    endif()
+endif()
+
+if(fft_backend STREQUAL "static")
+    include(cmake/BuildFFTW.cmake)
+    set(FFTW_TARGET fftw::fftw3)
+elseif(fft_backend STREQUAL "builtin")
+    message(WARNING "loris will use its built in FFT, analysis will be much slower than with fftw")
+elseif(NOT fft_backend STREQUAL "system")
+    message(FATAL_ERROR "unknown ${PROJECT_NAME}_FFT_BACKEND '${fft_backend}'; must be auto, system, static, or builtin")
+endif()
+message(STATUS "FFT backend: ${fft_backend}")
 
 # The following attempts to work around old crusty autotools, specifically
 #
@@ -15,8 +42,9 @@ pkg_check_modules(FFTW fftw3 IMPORTED_TARGET)
 # in order for the configure tests to find the needed bits.
 #
 # (2) Locating fftw is done via pkg-config which will work on macOS (homebrew)
-# and Linux, possibly Windows. If pkg-config finds fftw then we inject the
-# needed bits into the environment when configuring
+# and Linux, possibly Windows. If pkg-config finds fftw, or fftw is built by
+# BuildFFTW.cmake, then we inject the needed bits into the environment when
+# configuring
 #
 # (3) "cmake -E env" can't pass environment variables where the values contain
 # spaces to a subcommand. The suggested workaround was to generate a script and
@@ -31,6 +59,9 @@ if(FFTW_FOUND)
         BUILD_COMMAND make -j${Ncpu}
         BUILD_BYPRODUCTS ${loris_LIBRARY}
     )
+    if(fft_backend STREQUAL "static")
+        add_dependencies(loris fftw)
+    endif()
 else()
     ExternalProject_Add(loris
         SOURCE_DIR ${loris_SOURCE_DIR}
@@ -78,11 +109,30 @@ set(loris_libs
     "${PROJECT_BINARY_DIR}/loris-prefix/lib/${CMAKE_STATIC_LIBRARY_PREFIX}loris${CMAKE_STATIC_LIBRARY_SUFFIX}"
 )
 
-# TODO: Figure out how to force static linking of fftw
 if(FFTW_FOUND)
     # ensure consumers of the loris target link against the needed libraries
-    list(APPEND loris_libs PkgConfig::FFTW)
+    if(FFTW_THREADS_LIBRARY)
+        list(APPEND loris_libs ${FFTW_THREADS_LIBRARY})
+    endif()
+    list(APPEND loris_libs ${FFTW_TARGET})
 endif()
 target_link_libraries(loris::loris INTERFACE ${loris_libs})
 
+# reported by `utu --version` and the benchmarks
+target_compile_definitions(loris::loris INTERFACE UTU_FFT_BACKEND="${fft_backend}")
+
+# loris plans its transforms at the start of every analysis; the fftw planner
+# is only thread safe with fftw3_threads, without it analyses which would run
+# concurrently (serve, sweep, analysis bands) run one at a time
+if(FFTW_FOUND)
+    target_compile_definitions(loris::loris INTERFACE UTU_HAVE_FFTW)
+    if(FFTW_THREADS_LIBRARY)
+        target_compile_definitions(loris::loris INTERFACE UTU_HAVE_FFTW_THREADS)
+    else()
+        message(WARNING "fftw3_threads not found, concurrent analyses will run one at a time")
+    endif()
+else()
+    message(WARNING "the loris built in FFT is not known to be thread safe, concurrent analyses will run one at a time")
+endif()
+
 add_dependencies(loris::loris loris)
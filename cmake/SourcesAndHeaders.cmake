@@ -1,25 +1,79 @@
 set(lib_sources
+  lib/src/Analysis.cpp
+  lib/src/Base64.cpp
+  lib/src/Envelope.cpp
+  lib/src/Evaluation.cpp
+  lib/src/Grid.cpp
+  lib/src/Harmonic.cpp
+  lib/src/Marshal.cpp
+  lib/src/PartialHandler.cpp
   lib/src/PartialIO.cpp
+  lib/src/PartialLines.cpp
+  lib/src/PartialSdif.cpp
+  lib/src/Player.cpp
+  lib/src/Splice.cpp
+  lib/src/Synthesis.cpp
 )
 
 set(exe_sources
     cmd/src/AudioPlayer.h
     cmd/src/AudioFile.cpp
     cmd/src/AudioFile.h
-    cmd/src/Marshal.cpp
-    cmd/src/Marshal.h
+    cmd/src/Fingerprint.cpp
+    cmd/src/Fingerprint.h
+    cmd/src/NpyFile.cpp
+    cmd/src/NpyFile.h
+    cmd/src/PartialFile.cpp
+    cmd/src/PartialFile.h
+    cmd/src/Server.cpp
+    cmd/src/Server.h
+    cmd/src/Wisdom.cpp
+    cmd/src/Wisdom.h
 		cmd/src/main.cpp
 		${lib_sources}
 )
 
 set(lib_headers
     lib/include/utu/utu.h
+    lib/include/utu/Analysis.h
+    lib/include/utu/Envelope.h
+    lib/include/utu/Evaluation.h
+    lib/include/utu/Grid.h
+    lib/include/utu/Harmonic.h
     lib/include/utu/Partial.h
     lib/include/utu/PartialData.h
     lib/include/utu/PartialIO.h
+    lib/include/utu/Player.h
+    lib/include/utu/Synthesis.h
+    lib/src/Base64.h
+    lib/src/Marshal.h
+    lib/src/Parallel.h
+    lib/src/PartialHandler.h
     lib/src/SerializerImpl.h
+    lib/src/Splice.h
 )
 
 set(test_sources
+  src/test_envelope.cpp
+  src/test_evaluation.cpp
+  src/test_grid.cpp
+  src/test_harmonic.cpp
   src/test_json.cpp
+  src/test_lines.cpp
+  src/test_player.cpp
+  src/test_reader.cpp
+  src/test_sdif.cpp
+  src/test_splice.cpp
+  src/test_synthesis.cpp
+  src/test_writer.cpp
+)
+
+set(bench_sources
+  src/bench_analysis.cpp
+  src/bench_encoding.cpp
+  src/bench_envelope.cpp
+  src/bench_fft.cpp
+  src/bench_memory.cpp
+  src/bench_player.cpp
+  src/bench_precision.cpp
 )
@@ -6,6 +6,16 @@ option(${PROJECT_NAME}_BUILD_EXECUTABLE "Build the project as an executable, rat
 option(${PROJECT_NAME}_BUILD_HEADERS_ONLY "Build the project as a header-only library." OFF)
 option(${PROJECT_NAME}_USE_ALT_NAMES "Use alternative names for the project, such as naming the include directory all lowercase." ON)
 
+#
+# Dependencies
+#
+# The FFT used by loris: "auto" uses a system fftw found by pkg-config and
+# otherwise builds a static fftw, "system" and "static" force either, and
+# "builtin" uses the much slower loris FFT (for comparison only).
+
+set(${PROJECT_NAME}_FFT_BACKEND "auto" CACHE STRING "FFT backend used by loris: auto, system, static, or builtin.")
+set_property(CACHE ${PROJECT_NAME}_FFT_BACKEND PROPERTY STRINGS auto system static builtin)
+
 #
 # Compiler options
 #
@@ -32,6 +42,12 @@ option(${PROJECT_NAME}_USE_GOOGLE_MOCK "Use the GoogleMock project for extending
 
 option(${PROJECT_NAME}_USE_CATCH2 "Use the Catch2 project for creating unit tests." OFF)
 
+#
+# Benchmarks
+#
+
+option(${PROJECT_NAME}_ENABLE_BENCHMARKS "Build the benchmark programs (from the `bench` subfolder)." OFF)
+
 #
 # Static analyzers
 #
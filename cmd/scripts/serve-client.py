@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 Greg Wuller.
+#
+# SPDX-License-Identifier: GPL-2.0-or-later
+#
+
+"""Submit jobs to a running `utu serve --socket=<path>` and report results.
+
+Jobs are read one JSON object per line from the given file (or stdin), sent
+to the server, and each response line is echoed as it arrives. A latency
+summary is printed to stderr once every job has been answered.
+
+  utu serve --socket=/tmp/utu.sock &
+  ./serve-client.py /tmp/utu.sock jobs.ndjson
+"""
+
+import argparse
+import json
+import socket
+import sys
+import time
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("socket", help="path of the server's unix domain socket")
+    parser.add_argument("jobs", nargs="?", type=argparse.FileType("r"), default=sys.stdin,
+                        help="newline delimited JSON jobs (default: stdin)")
+    args = parser.parse_args()
+
+    jobs = [line.strip() for line in args.jobs if line.strip()]
+    if not jobs:
+        return 0
+
+    started = time.monotonic()
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+        s.connect(args.socket)
+        s.sendall(("\n".join(jobs) + "\n").encode("utf-8"))
+
+        responses = []
+        pending = b""
+        while len(responses) < len(jobs):
+            data = s.recv(65536)
+            if not data:
+                break
+            pending += data
+            *lines, pending = pending.split(b"\n")
+            for line in lines:
+                print(line.decode("utf-8"), flush=True)
+                responses.append(json.loads(line))
+    elapsed = time.monotonic() - started
+
+    failed = [r for r in responses if r.get("status") != "ok"]
+    latencies = sorted(r["latency_ms"] for r in responses)
+    if latencies:
+        p50 = latencies[len(latencies) // 2]
+        print(f"jobs: {len(responses)}/{len(jobs)} failed: {len(failed)} wall: {elapsed:.3f}s "
+              f"latency p50: {p50:.1f}ms max: {latencies[-1]:.1f}ms "
+              f"queue depth max: {max(r['queue_depth'] for r in responses)}", file=sys.stderr)
+
+    return 0 if len(responses) == len(jobs) and not failed else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
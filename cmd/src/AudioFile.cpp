@@ -7,9 +7,162 @@
 
 #include "AudioFile.h"
 
+#include <algorithm>
 #include <cassert>
+#include <cstdio>
 #include <cstring>
 #include <limits>
+#include <stdexcept>
+
+// In memory (stdin) or write through (stdout) backing for libsndfile virtual
+// I/O. Pipes can not seek so audio read from stdin is buffered completely,
+// which also allows libsndfile to sniff the format as it would for a file.
+struct AudioFile::Stream {
+  std::vector<char> data;
+  sf_count_t offset = 0;
+  bool toStdout = false;
+
+  static sf_count_t getFileLength(void* user)
+  {
+    auto* s = static_cast<Stream*>(user);
+    return s->toStdout ? s->offset : static_cast<sf_count_t>(s->data.size());
+  }
+
+  static sf_count_t seek(sf_count_t offset, int whence, void* user)
+  {
+    auto* s = static_cast<Stream*>(user);
+    if (s->toStdout) {
+      return s->offset;  // output only moves forward
+    }
+    switch (whence) {
+      case SEEK_SET:
+        break;
+      case SEEK_CUR:
+        offset += s->offset;
+        break;
+      case SEEK_END:
+        offset += static_cast<sf_count_t>(s->data.size());
+        break;
+    }
+    s->offset = std::clamp(offset, sf_count_t(0), static_cast<sf_count_t>(s->data.size()));
+    return s->offset;
+  }
+
+  static sf_count_t read(void* ptr, sf_count_t count, void* user)
+  {
+    auto* s = static_cast<Stream*>(user);
+    if (s->toStdout) {
+      return 0;
+    }
+    auto available = static_cast<sf_count_t>(s->data.size()) - s->offset;
+    count = std::min(count, available);
+    std::memcpy(ptr, s->data.data() + s->offset, static_cast<std::size_t>(count));
+    s->offset += count;
+    return count;
+  }
+
+  static sf_count_t write(const void* ptr, sf_count_t count, void* user)
+  {
+    auto* s = static_cast<Stream*>(user);
+    if (!s->toStdout) {
+      return 0;
+    }
+    auto wrote = static_cast<sf_count_t>(
+        std::fwrite(ptr, 1, static_cast<std::size_t>(count), stdout));
+    s->offset += wrote;
+    return wrote;
+  }
+
+  static sf_count_t tell(void* user) { return static_cast<Stream*>(user)->offset; }
+
+  static SF_VIRTUAL_IO io() { return {getFileLength, seek, read, write, tell}; }
+};
+
+namespace
+{
+
+int _encodingFormat(AudioFile::Encoding encoding)
+{
+  switch (encoding) {
+    case AudioFile::Encoding::PCM_16:
+      return SF_FORMAT_PCM_16;
+    case AudioFile::Encoding::PCM_24:
+      return SF_FORMAT_PCM_24;
+    case AudioFile::Encoding::PCM_32:
+      return SF_FORMAT_PCM_32;
+    case AudioFile::Encoding::FLOAT:
+      return SF_FORMAT_FLOAT;
+    case AudioFile::Encoding::DOUBLE:
+      return SF_FORMAT_DOUBLE;
+  }
+  return 0;
+}
+
+uint16_t _encodingBytes(AudioFile::Encoding encoding)
+{
+  switch (encoding) {
+    case AudioFile::Encoding::PCM_16:
+      return 2;
+    case AudioFile::Encoding::PCM_24:
+      return 3;
+    case AudioFile::Encoding::PCM_32:
+    case AudioFile::Encoding::FLOAT:
+      return 4;
+    case AudioFile::Encoding::DOUBLE:
+      return 8;
+  }
+  return 0;
+}
+
+void _putLE(std::vector<char>& out, uint32_t value, int bytes)
+{
+  for (int i = 0; i < bytes; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+// Canonical RIFF/WAVE header for PCM or IEEE float data of a given length.
+// Non-PCM formats such as IEEE float extend the fmt chunk with cbSize and
+// require a fact chunk holding the length in frames.
+std::vector<char> _wavHeader(uint32_t sampleRate, uint16_t channels, AudioFile::Encoding encoding,
+                             std::optional<int64_t> frames)
+{
+  bool isFloat =
+      encoding == AudioFile::Encoding::FLOAT || encoding == AudioFile::Encoding::DOUBLE;
+  uint16_t bytes = _encodingBytes(encoding);
+  uint32_t blockAlign = static_cast<uint32_t>(channels) * bytes;
+
+  // RIFF type, fmt chunk, fact chunk when float, data chunk header
+  uint32_t formatBytes = isFloat ? 18 : 16;
+  uint32_t headerBytes = 4 + 8 + formatBytes + (isFloat ? 12 : 0) + 8;
+  uint32_t dataBytes = std::numeric_limits<uint32_t>::max() - headerBytes;
+  if (frames && static_cast<uint64_t>(*frames) * blockAlign < dataBytes) {
+    dataBytes = static_cast<uint32_t>(static_cast<uint64_t>(*frames) * blockAlign);
+  }
+
+  std::vector<char> header;
+  header.insert(header.end(), {'R', 'I', 'F', 'F'});
+  _putLE(header, headerBytes + dataBytes, 4);
+  header.insert(header.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+  _putLE(header, formatBytes, 4);
+  _putLE(header, isFloat ? 3 /* IEEE float */ : 1 /* PCM */, 2);
+  _putLE(header, channels, 2);
+  _putLE(header, sampleRate, 4);
+  _putLE(header, sampleRate * blockAlign, 4);
+  _putLE(header, blockAlign, 2);
+  _putLE(header, bytes * 8u, 2);
+  if (isFloat) {
+    _putLE(header, 0, 2);  // cbSize
+    header.insert(header.end(), {'f', 'a', 'c', 't'});
+    _putLE(header, 4, 4);
+    _putLE(header, dataBytes / blockAlign, 4);
+  }
+  header.insert(header.end(), {'d', 'a', 't', 'a'});
+  _putLE(header, dataBytes, 4);
+  return header;
+}
+
+}  // namespace
 
 std::optional<AudioFile::Format> AudioFile::inferFormat(const std::filesystem::path& p)
 {
@@ -48,14 +201,31 @@ std::optional<AudioFile::Encoding> AudioFile::inferEncoding(const std::string& s
   return {};
 }
 
+AudioFile::AudioFile(const std::filesystem::path& p, Mode m) : _path(p), _mode(m), _file(nullptr)
+{
+  std::memset(&_info, 0, sizeof(SF_INFO));
+}
+
 AudioFile AudioFile::forRead(const std::filesystem::path& p)
 {
   AudioFile file(p, Mode::READ);
 
   file._info.format = 0;
-  file._file = sf_open(p.c_str(), SFM_READ, &file._info);
-  // FIXME: need proper error handling
-  assert(file._file != nullptr);
+  if (p == "-") {
+    file._stream = std::make_unique<Stream>();
+    char buffer[65536];
+    for (std::size_t count; (count = std::fread(buffer, 1, sizeof(buffer), stdin)) > 0;) {
+      file._stream->data.insert(file._stream->data.end(), buffer, buffer + count);
+    }
+
+    SF_VIRTUAL_IO io = Stream::io();
+    file._file = sf_open_virtual(&io, SFM_READ, &file._info, file._stream.get());
+  } else {
+    file._file = sf_open(p.c_str(), SFM_READ, &file._info);
+  }
+  if (file._file == nullptr) {
+    throw std::runtime_error("unable to open " + p.string() + ": " + sf_strerror(nullptr));
+  }
 
   return file;
 }
@@ -79,23 +249,7 @@ AudioFile AudioFile::forWrite(const std::filesystem::path& p, uint32_t sampleRat
       break;
   }
 
-  switch (encoding) {
-    case Encoding::PCM_16:
-      fmt |= SF_FORMAT_PCM_16;
-      break;
-    case Encoding::PCM_24:
-      fmt |= SF_FORMAT_PCM_24;
-      break;
-    case Encoding::PCM_32:
-      fmt |= SF_FORMAT_PCM_32;
-      break;
-    case Encoding::FLOAT:
-      fmt |= SF_FORMAT_FLOAT;
-      break;
-    case Encoding::DOUBLE:
-      fmt |= SF_FORMAT_DOUBLE;
-      break;
-  }
+  fmt |= _encodingFormat(encoding);
 
   assert(fmt != 0);
   file._info.format = fmt;
@@ -105,7 +259,37 @@ AudioFile AudioFile::forWrite(const std::filesystem::path& p, uint32_t sampleRat
   file._info.channels = channels;
 
   file._file = sf_open(p.c_str(), SFM_WRITE, &file._info);
-  assert(file._file != nullptr);
+  if (file._file == nullptr) {
+    throw std::runtime_error("unable to create " + p.string() + ": " + sf_strerror(nullptr));
+  }
+
+  return file;
+}
+
+AudioFile AudioFile::forStdout(uint32_t sampleRate, uint16_t channels, Encoding encoding, bool raw,
+                               std::optional<int64_t> frames)
+{
+  AudioFile file("-", Mode::WRITE);
+
+  file._stream = std::make_unique<Stream>();
+  file._stream->toStdout = true;
+
+  if (!raw) {
+    std::vector<char> header = _wavHeader(sampleRate, channels, encoding, frames);
+    Stream::write(header.data(), static_cast<sf_count_t>(header.size()), file._stream.get());
+  }
+
+  // libsndfile only encodes the sample data, any header was written above
+  assert(sampleRate <= std::numeric_limits<int>::max());
+  file._info.format = SF_FORMAT_RAW | SF_ENDIAN_LITTLE | _encodingFormat(encoding);
+  file._info.samplerate = static_cast<int>(sampleRate);
+  file._info.channels = channels;
+
+  SF_VIRTUAL_IO io = Stream::io();
+  file._file = sf_open_virtual(&io, SFM_WRITE, &file._info, file._stream.get());
+  if (file._file == nullptr) {
+    throw std::runtime_error(std::string("unable to write to stdout: ") + sf_strerror(nullptr));
+  }
 
   return file;
 }
@@ -119,6 +303,7 @@ AudioFile::AudioFile(AudioFile&& other)
   _file = other._file;
   _info = other._info;
   _samples = other._samples;
+  _stream = std::move(other._stream);
 
   other._file = nullptr;
   memset(&other._info, 0, sizeof(SF_INFO));
@@ -135,6 +320,7 @@ AudioFile& AudioFile::operator=(AudioFile&& other)
     _file = other._file;
     _info = other._info;
     _samples = other._samples;
+    _stream = std::move(other._stream);
 
     other._file = nullptr;
     memset(&other._info, 0, sizeof(SF_INFO));
@@ -173,6 +359,10 @@ void AudioFile::close()
   if (_file) {
     // FIXME: check for errors
     sf_close(_file);
+    _file = nullptr;
+  }
+  if (_stream && _stream->toStdout) {
+    std::fflush(stdout);
   }
 }
 
@@ -9,6 +9,7 @@
 #include <sndfile.h>
 
 #include <filesystem>
+#include <memory>
 #include <optional>
 #include <vector>
 
@@ -35,11 +36,20 @@ class AudioFile final
   static std::optional<Format> inferFormat(const std::filesystem::path& p);
   static std::optional<Encoding> inferEncoding(const std::string& s);
 
+  // A path of "-" reads the complete audio file from stdin.
   static AudioFile forRead(const std::filesystem::path& p);
   static AudioFile forWrite(const std::filesystem::path& p, uint32_t sampleRate,
                             uint16_t channels = 1, Format format = Format::WAV,
                             Encoding encoding = Encoding::PCM_24);
 
+  // Stream little endian PCM to stdout as it is written, preceded by a WAV
+  // header unless raw is set. Pipes can not be rewound to patch the header so
+  // the length must be known up front; if not given the header carries the
+  // maximum size as is conventional for streamed WAV data.
+  static AudioFile forStdout(uint32_t sampleRate, uint16_t channels = 1,
+                             Encoding encoding = Encoding::PCM_24, bool raw = false,
+                             std::optional<int64_t> frames = {});
+
   ~AudioFile();
 
   AudioFile(const AudioFile&) = delete;
@@ -62,7 +72,9 @@ class AudioFile final
   void close();
 
  private:
-  AudioFile(const std::filesystem::path& p, Mode m) : _path(p), _mode(m), _file(nullptr){};
+  struct Stream;
+
+  AudioFile(const std::filesystem::path& p, Mode m);
 
   void _loadSamples();
 
@@ -70,6 +82,9 @@ class AudioFile final
   Mode _mode;
   Samples _samples;
 
+  // backing for files opened with libsndfile virtual I/O (stdin/stdout)
+  std::unique_ptr<Stream> _stream;
+
   SNDFILE* _file;
   SF_INFO _info;
 };
@@ -0,0 +1,133 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include "Fingerprint.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+
+// FIPS 180-4 SHA-256
+class Sha256 final
+{
+ public:
+  void update(const unsigned char* data, std::size_t count)
+  {
+    _length += count;
+    while (count > 0) {
+      std::size_t n = std::min(count, _block.size() - _used);
+      std::copy(data, data + n, _block.begin() + static_cast<std::ptrdiff_t>(_used));
+      _used += n;
+      data += n;
+      count -= n;
+      if (_used == _block.size()) {
+        _compress();
+        _used = 0;
+      }
+    }
+  }
+
+  std::string hex()
+  {
+    std::uint64_t bits = _length * 8;
+    const unsigned char one = 0x80;
+    update(&one, 1);
+    const unsigned char zero = 0;
+    while (_used != 56) {
+      update(&zero, 1);
+    }
+    unsigned char size[8];
+    for (int i = 0; i < 8; ++i) {
+      size[i] = static_cast<unsigned char>(bits >> (56 - 8 * i));
+    }
+    update(size, 8);
+
+    static const char kDigits[] = "0123456789abcdef";
+    std::string result;
+    for (std::uint32_t h : _state) {
+      for (int shift = 28; shift >= 0; shift -= 4) {
+        result += kDigits[(h >> shift) & 0xf];
+      }
+    }
+    return result;
+  }
+
+ private:
+  static std::uint32_t _rotr(std::uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+  void _compress()
+  {
+    static const std::uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4,
+        0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe,
+        0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f,
+        0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+        0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+        0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116,
+        0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7,
+        0xc67178f2};
+
+    std::uint32_t w[64];
+    for (std::size_t i = 0; i < 16; ++i) {
+      w[i] = static_cast<std::uint32_t>(_block[i * 4]) << 24 |
+             static_cast<std::uint32_t>(_block[i * 4 + 1]) << 16 |
+             static_cast<std::uint32_t>(_block[i * 4 + 2]) << 8 |
+             static_cast<std::uint32_t>(_block[i * 4 + 3]);
+    }
+    for (std::size_t i = 16; i < 64; ++i) {
+      std::uint32_t s0 = _rotr(w[i - 15], 7) ^ _rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+      std::uint32_t s1 = _rotr(w[i - 2], 17) ^ _rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+      w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    std::array<std::uint32_t, 8> v = _state;
+    for (std::size_t i = 0; i < 64; ++i) {
+      std::uint32_t s1 = _rotr(v[4], 6) ^ _rotr(v[4], 11) ^ _rotr(v[4], 25);
+      std::uint32_t ch = (v[4] & v[5]) ^ (~v[4] & v[6]);
+      std::uint32_t t1 = v[7] + s1 + ch + k[i] + w[i];
+      std::uint32_t s0 = _rotr(v[0], 2) ^ _rotr(v[0], 13) ^ _rotr(v[0], 22);
+      std::uint32_t maj = (v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]);
+      std::uint32_t t2 = s0 + maj;
+      v = {t1 + t2, v[0], v[1], v[2], v[3] + t1, v[4], v[5], v[6]};
+    }
+    for (std::size_t i = 0; i < 8; ++i) {
+      _state[i] += v[i];
+    }
+  }
+
+  std::array<std::uint32_t, 8> _state = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                                         0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+  std::array<unsigned char, 64> _block = {};
+  std::size_t _used = 0;
+  std::uint64_t _length = 0;
+};
+
+}  // namespace
+
+std::string Fingerprint::of(const std::filesystem::path& p)
+{
+  std::ifstream is(p, std::ios::binary);
+  if (!is) {
+    throw std::runtime_error("unable to open " + p.string());
+  }
+
+  Sha256 hash;
+  std::vector<char> buffer(1 << 16);
+  while (is) {
+    is.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    hash.update(reinterpret_cast<const unsigned char*>(buffer.data()),
+                static_cast<std::size_t>(is.gcount()));
+  }
+  return hash.hex();
+}
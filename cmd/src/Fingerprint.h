@@ -0,0 +1,16 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <filesystem>
+#include <string>
+
+// The SHA-256 digest of a file's contents as lowercase hex, recorded as the
+// fingerprint of an analysis source so stale analyses can be detected.
+struct Fingerprint {
+  static std::string of(const std::filesystem::path& p);
+};
@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include "NpyFile.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+
+constexpr char kMagic[] = "\x93NUMPY";
+constexpr std::size_t kMagicLength = 6;
+
+// header length is padded so the data starts on a 64 byte boundary
+constexpr std::size_t kAlignment = 64;
+
+char _byteOrder()
+{
+  const std::uint16_t probe = 1;
+  unsigned char first;
+  std::memcpy(&first, &probe, 1);
+  return first == 1 ? '<' : '>';
+}
+
+void _write(const std::filesystem::path& p, const std::string& descr, const void* data,
+            std::size_t bytes, const std::vector<std::size_t>& shape)
+{
+  std::string header = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': (";
+  for (std::size_t dim : shape) {
+    header += std::to_string(dim) + ", ";
+  }
+  if (shape.size() > 1) {
+    // a tuple of one keeps its trailing comma, larger tuples do not need it
+    header.resize(header.size() - 2);
+  } else if (!shape.empty()) {
+    header.pop_back();
+  }
+  header += "), }";
+
+  // magic, version, and the 16 bit header length precede the header text
+  std::size_t prefix = kMagicLength + 2 + 2;
+  std::size_t padding = kAlignment - (prefix + header.size() + 1) % kAlignment;
+  header.append(padding % kAlignment, ' ');
+  header += '\n';
+
+  std::ofstream os(p, std::ios::binary);
+  if (!os) {
+    throw std::runtime_error("unable to open " + p.string());
+  }
+
+  auto length = static_cast<std::uint16_t>(header.size());
+  const unsigned char version[] = {1, 0};
+  const unsigned char lengthBytes[] = {static_cast<unsigned char>(length & 0xff),
+                                       static_cast<unsigned char>(length >> 8)};
+  os.write(kMagic, kMagicLength);
+  os.write(reinterpret_cast<const char*>(version), 2);
+  os.write(reinterpret_cast<const char*>(lengthBytes), 2);
+  os.write(header.data(), static_cast<std::streamsize>(header.size()));
+  os.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+
+  if (!os) {
+    throw std::runtime_error("unable to write " + p.string());
+  }
+}
+
+}  // namespace
+
+void NpyFile::write(const std::filesystem::path& p, const std::vector<double>& data,
+                    const std::vector<std::size_t>& shape)
+{
+  _write(p, std::string(1, _byteOrder()) + "f8", data.data(), data.size() * sizeof(double),
+         shape);
+}
+
+void NpyFile::write(const std::filesystem::path& p, const std::vector<std::uint8_t>& data,
+                    const std::vector<std::size_t>& shape)
+{
+  _write(p, "|u1", data.data(), data.size(), shape);
+}
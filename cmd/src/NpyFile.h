@@ -0,0 +1,22 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+// Writes arrays in the NumPy ".npy" format (version 1.0) so they can be
+// loaded, or memory mapped, with numpy.load. Data is written in native byte
+// order, which the header records, in C (row major) order.
+struct NpyFile {
+  static void write(const std::filesystem::path& p, const std::vector<double>& data,
+                    const std::vector<std::size_t>& shape);
+  static void write(const std::filesystem::path& p, const std::vector<std::uint8_t>& data,
+                    const std::vector<std::size_t>& shape);
+};
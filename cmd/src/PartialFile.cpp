@@ -0,0 +1,148 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include "PartialFile.h"
+
+#include <utu/PartialIO.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "Marshal.h"
+
+namespace
+{
+
+bool _isSdif(const std::string& path)
+{
+  return std::filesystem::path(path).extension() == ".sdif";
+}
+
+bool _isLines(const std::string& path)
+{
+  return std::filesystem::path(path).extension() == ".utul";
+}
+
+std::optional<utu::BinaryFormat> _binaryFormat(const std::string& path)
+{
+  auto extension = std::filesystem::path(path).extension();
+  if (extension == ".cbor") {
+    return utu::BinaryFormat::Cbor;
+  }
+  if (extension == ".msgpack") {
+    return utu::BinaryFormat::MessagePack;
+  }
+  return {};
+}
+
+}  // namespace
+
+std::optional<utu::PartialData> PartialFile::read(const std::string& path, unsigned threads)
+{
+  if (path == "-") {
+    return utu::PartialReader::read(std::cin);
+  }
+
+  std::ifstream is(path, std::ios::binary);
+  if (_isSdif(path)) {
+    return utu::PartialSdifReader::read(is);
+  }
+  if (_isLines(path)) {
+    return utu::PartialLineReader::read(is, utu::ReadOptions(), threads);
+  }
+  if (auto format = _binaryFormat(path)) {
+    return utu::PartialReader::read(is, *format);
+  }
+
+  // assume JSON format
+  return utu::PartialReader::read(is);
+}
+
+std::optional<utu::PartialHeader> PartialFile::readHeader(const std::string& path)
+{
+  std::optional<utu::PartialHeader> header;
+  if (!_isSdif(path)) {
+    std::ifstream is(path, std::ios::binary);
+    if (_isLines(path)) {
+      std::string line;
+      std::getline(is, line);
+      std::istringstream ls(line);
+      header = utu::PartialHeaderReader::read(ls);
+    } else if (auto format = _binaryFormat(path)) {
+      header = utu::PartialHeaderReader::read(is, *format);
+    } else {
+      header = utu::PartialHeaderReader::read(is);
+    }
+  }
+  if (header && header->summary) {
+    return header;
+  }
+
+  std::optional<utu::PartialData> data = read(path);
+  if (!data) {
+    return {};
+  }
+  if (!header) {
+    header = utu::PartialHeader();
+  }
+  header->fields = *data;
+  header->summary = utu::summarize(*data);
+  return header;
+}
+
+bool PartialFile::isPartialFile(const std::filesystem::path& path)
+{
+  auto extension = path.extension();
+  return extension == ".json" || extension == ".utul" || extension == ".sdif" ||
+         extension == ".cbor" || extension == ".msgpack";
+}
+
+bool PartialFile::isJson(const std::string& path)
+{
+  return path == "-" || (!_isSdif(path) && !_isLines(path) && !_binaryFormat(path));
+}
+
+void PartialFile::write(const std::string& path, const utu::PartialData& data,
+                        const utu::WriteOptions& options)
+{
+  if (path == "-") {
+    utu::PartialWriter::write(data, std::cout, options);
+    return;
+  }
+
+  std::ofstream os(path, std::ios::binary);
+  if (_isSdif(path)) {
+    // bandwidth enhanced partials as written by Loris
+    utu::PartialSdifWriter::write(data, os);
+  } else if (_isLines(path)) {
+    utu::PartialLineWriter::write(data, os, options);
+  } else if (auto format = _binaryFormat(path)) {
+    utu::PartialWriter::write(data, os, *format, options);
+  } else {
+    // output JSON format
+    utu::PartialWriter::write(data, os, options);
+  }
+}
+
+Loris::PartialList PartialFile::readList(const std::string& path)
+{
+  std::optional<utu::PartialData> data = read(path);
+  if (!data) {
+    throw std::runtime_error("unable to read partials from " + path);
+  }
+  return Marshal::from(*data);
+}
+
+void PartialFile::writeList(const std::string& path, const Loris::PartialList& partials,
+                            std::optional<utu::PartialData::Source> source)
+{
+  utu::PartialData data = Marshal::from(partials);
+  data.source = source;
+  write(path, data);
+}
@@ -0,0 +1,43 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <loris/PartialList.h>
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+#include <filesystem>
+#include <optional>
+#include <string>
+
+// Reads and writes partials choosing the file format based on the path
+// extension; ".sdif" files hold Loris style bandwidth enhanced partials, ".utul"
+// files are newline delimited utu JSON, ".cbor" and ".msgpack" files are the
+// utu JSON document in CBOR or MessagePack and everything else is treated as
+// utu JSON. A path of "-" refers to stdin/stdout and always uses utu JSON.
+struct PartialFile {
+  static std::optional<utu::PartialData> read(const std::string& path, unsigned threads = 0);
+
+  // The header of a file including its summary, read without parsing the
+  // partials when the writer stored a summary; otherwise, such as for SDIF,
+  // the file is read in full to compute one.
+  static std::optional<utu::PartialHeader> readHeader(const std::string& path);
+
+  // Whether the extension is that of a partial file format.
+  static bool isPartialFile(const std::filesystem::path& path);
+
+  // Whether the path is written as utu JSON, the only format which takes a
+  // sample encoding.
+  static bool isJson(const std::string& path);
+
+  static void write(const std::string& path, const utu::PartialData& data,
+                    const utu::WriteOptions& options = {});
+
+  static Loris::PartialList readList(const std::string& path);
+  static void writeList(const std::string& path, const Loris::PartialList& partials,
+                        std::optional<utu::PartialData::Source> source = {});
+};
@@ -0,0 +1,449 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include "Server.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utu/Analysis.h>
+#include <utu/Synthesis.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "AudioFile.h"
+#include "PartialFile.h"
+
+namespace
+{
+
+using json = nlohmann::json;
+
+constexpr std::size_t kMaxCachedAnalyzers = 16;
+constexpr int kPollIntervalMs = 250;
+
+// jobs already run in parallel so each reads and writes on its worker thread
+constexpr unsigned kJobThreads = 1;
+
+// held by workers while analyzing when fft planning is not thread safe, see
+// utu::concurrentAnalysis()
+std::mutex _analysisMutex;
+
+volatile std::sig_atomic_t _signalled = 0;
+
+void _onSignal(int /* signal */) { _signalled = 1; }
+
+// State owned by a single worker thread and reused across the jobs it runs.
+struct WorkerState {
+  // configured analyzers keyed by the serialized job options
+  std::unordered_map<std::string, std::unique_ptr<utu::Analyzer>> analyzers;
+};
+
+void _setIfPresent(const json& o, const char* key, std::optional<double>& field)
+{
+  auto it = o.find(key);
+  if (it != o.end()) {
+    field = it->get<double>();
+  }
+}
+
+std::string _path(const json& request, const char* key)
+{
+  std::string p = request.at(key).get<std::string>();
+  if (p == "-") {
+    // stdin/stdout carry the job protocol itself
+    throw std::invalid_argument(std::string(key) + " must be a file path");
+  }
+  return p;
+}
+
+utu::WriteOptions _writeOptions()
+{
+  utu::WriteOptions options;
+  options.threads = kJobThreads;
+  return options;
+}
+
+utu::AnalyzeOptions _analyzeOptions(const json& o)
+{
+  utu::AnalyzeOptions options;
+  options.threads = kJobThreads;
+
+  options.freqResolution = o.value("freq-res", options.freqResolution);
+  if (options.freqResolution <= 0) {
+    throw std::invalid_argument("freq-res must be greater than 0");
+  }
+  options.windowWidth = o.value("window-width", options.windowWidth);
+
+  _setIfPresent(o, "freq-drift", options.freqDrift);
+  _setIfPresent(o, "freq-floor", options.freqFloor);
+  _setIfPresent(o, "amp-floor", options.ampFloor);
+  _setIfPresent(o, "hop-time", options.hopTime);
+  _setIfPresent(o, "crop-time", options.cropTime);
+  _setIfPresent(o, "lobe-level", options.sidelobeLevel);
+  _setIfPresent(o, "max-freq", options.maxFrequency);
+  options.phaseCorrect = !o.value("no-phase-correct", false);
+
+  return options;
+}
+
+json _analyze(const json& request, WorkerState& state)
+{
+  const json options = request.value("options", json::object());
+
+  std::string input = _path(request, "input");
+  AudioFile f = AudioFile::forRead(input);
+  const AudioFile::Samples& samples = f.samples();
+
+  // without a thread safe fft planner workers take turns to configure and
+  // run analyzers, everything else still runs in parallel
+  std::unique_lock<std::mutex> lock(_analysisMutex, std::defer_lock);
+  if (!utu::concurrentAnalysis()) {
+    lock.lock();
+  }
+
+  std::string key = options.dump();
+  auto it = state.analyzers.find(key);
+  if (it == state.analyzers.end()) {
+    if (state.analyzers.size() >= kMaxCachedAnalyzers) {
+      state.analyzers.clear();
+    }
+    auto analyzer = std::make_unique<utu::Analyzer>(_analyzeOptions(options));
+    it = state.analyzers.emplace(key, std::move(analyzer)).first;
+  }
+
+  utu::PartialData data = it->second->analyze(samples.data(), samples.size(), f.sampleRate());
+  if (lock.owns_lock()) {
+    lock.unlock();
+  }
+  data.source = utu::PartialData::Source({std::filesystem::canonical(input), {}});
+
+  if (request.contains("output")) {
+    PartialFile::write(_path(request, "output"), data, _writeOptions());
+  }
+
+  return {{"partials", data.partials.size()}};
+}
+
+json _synth(const json& request, WorkerState& /* state */)
+{
+  const json options = request.value("options", json::object());
+
+  std::optional<utu::PartialData> data = PartialFile::read(_path(request, "input"), kJobThreads);
+  if (!data) {
+    throw std::runtime_error("unable to read partials");
+  }
+
+  auto sr = options.value("sample-rate", 44100u);
+  std::string output = _path(request, "output");
+
+  std::optional<AudioFile::Format> format = AudioFile::inferFormat(output);
+  if (!format) {
+    throw std::invalid_argument("unsupported output format; must be .wav, .aiff, or .caf");
+  }
+  std::optional<AudioFile::Encoding> encoding =
+      AudioFile::inferEncoding(options.value("sample-type", "24"));
+  if (!encoding) {
+    throw std::invalid_argument("unsupported sample type; must be 16, 24, 32, f32, or f64");
+  }
+
+  utu::SynthOptions synthOptions;
+  synthOptions.sampleRate = sr;
+  synthOptions.pitchShift = options.value("pitch-shift", 0.0);
+  synthOptions.frequencyScale = options.value("freq-scale", 1.0);
+  synthOptions.timeStretch = options.value("time-stretch", 1.0);
+  synthOptions.gain = options.value("gain", 0.0);
+  synthOptions.mutedLabels = options.value("mute", std::vector<std::string>());
+  std::vector<double> samples = utu::synthesize(*data, synthOptions);
+
+  AudioFile f = AudioFile::forWrite(output, sr, 1 /* channel */, *format, *encoding);
+  f.write(samples);
+
+  return {{"frames", samples.size()}};
+}
+
+json _convert(const json& request, WorkerState& /* state */)
+{
+  std::optional<utu::PartialData> data = PartialFile::read(_path(request, "input"), kJobThreads);
+  if (!data) {
+    throw std::runtime_error("unable to read partials");
+  }
+  PartialFile::write(_path(request, "output"), *data, _writeOptions());
+
+  return {{"partials", data->partials.size()}};
+}
+
+json _execute(const json& request, WorkerState& state)
+{
+  std::string command = request.at("command").get<std::string>();
+  if (command == "analyze") {
+    return _analyze(request, state);
+  }
+  if (command == "synth") {
+    return _synth(request, state);
+  }
+  if (command == "convert") {
+    return _convert(request, state);
+  }
+  throw std::invalid_argument("unknown command: " + command);
+}
+
+double _elapsedMs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+{
+  return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// A socket client; closed once the reader has finished and every job
+// submitted over the connection has been answered.
+class Connection final
+{
+ public:
+  explicit Connection(int fd) : _fd(fd) {}
+  ~Connection() { close(_fd); }
+
+  Connection(const Connection&) = delete;
+  Connection& operator=(const Connection&) = delete;
+
+  int fd() const { return _fd; }
+
+  void send(const std::string& line)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    const char* p = line.data();
+    std::size_t remaining = line.size();
+    while (remaining > 0) {
+      ssize_t wrote = ::write(_fd, p, remaining);
+      if (wrote <= 0) {
+        return;  // client went away, nothing left to do
+      }
+      p += wrote;
+      remaining -= static_cast<std::size_t>(wrote);
+    }
+  }
+
+ private:
+  int _fd;
+  std::mutex _mutex;
+};
+
+}  // namespace
+
+Server::Server(const Options& options)
+    : _options(options), _stopping(false), _completed(0), _failed(0)
+{
+}
+
+Server::~Server() { _stop(); }
+
+int Server::run()
+{
+  _start();
+  int status = _options.socketPath ? _serveSocket(*_options.socketPath) : _serveStdin();
+  _stop();
+
+  if (_options.verbose) {
+    std::cerr << "Completed: " << _completed << " jobs, failed: " << _failed << std::endl;
+  }
+  return status;
+}
+
+void Server::_start()
+{
+  for (unsigned i = 0; i < std::max(_options.jobs, 1u); ++i) {
+    _workers.emplace_back(&Server::_work, this);
+  }
+}
+
+void Server::_stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _ready.notify_all();
+
+  for (auto& w : _workers) {
+    w.join();
+  }
+  _workers.clear();
+}
+
+void Server::_enqueue(std::string request, Reply reply)
+{
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _queue.push_back({std::move(request), std::move(reply), Clock::now()});
+  }
+  _ready.notify_one();
+}
+
+void Server::_work()
+{
+  WorkerState state;
+
+  for (;;) {
+    Job job;
+    std::size_t depth;
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _ready.wait(lock, [this] { return _stopping || !_queue.empty(); });
+      if (_queue.empty()) {
+        return;  // stopping and fully drained
+      }
+      job = std::move(_queue.front());
+      _queue.pop_front();
+      depth = _queue.size();
+    }
+
+    auto started = Clock::now();
+    json response;
+    try {
+      json request = json::parse(job.request);
+      if (request.contains("id")) {
+        response["id"] = request["id"];
+      }
+      response["result"] = _execute(request, state);
+      response["status"] = "ok";
+    } catch (const std::exception& e) {
+      response["status"] = "error";
+      response["error"] = e.what();
+      _failed++;
+    }
+    auto finished = Clock::now();
+
+    response["queue_ms"] = _elapsedMs(job.enqueued, started);
+    response["run_ms"] = _elapsedMs(started, finished);
+    response["latency_ms"] = _elapsedMs(job.enqueued, finished);
+    response["queue_depth"] = depth;
+
+    _completed++;
+    job.reply(response.dump() + "\n");
+  }
+}
+
+int Server::_serveStdin()
+{
+  std::mutex outputMutex;
+  Reply reply = [&outputMutex](const std::string& line) {
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::flush;
+  };
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    if (!line.empty()) {
+      _enqueue(line, reply);
+    }
+  }
+
+  // replies reference the local output mutex, drain before returning
+  _stop();
+  return 0;
+}
+
+int Server::_serveSocket(const std::filesystem::path& p)
+{
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (p.native().size() >= sizeof(addr.sun_path)) {
+    std::cerr << "error: Socket path is too long: " << p << std::endl;
+    return -1;
+  }
+  std::strncpy(addr.sun_path, p.c_str(), sizeof(addr.sun_path) - 1);
+
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0) {
+    std::cerr << "error: Unable to create socket: " << std::strerror(errno) << std::endl;
+    return -1;
+  }
+
+  unlink(p.c_str());
+  if (bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+      listen(listener, SOMAXCONN) != 0) {
+    std::cerr << "error: Unable to listen on " << p << ": " << std::strerror(errno) << std::endl;
+    close(listener);
+    return -1;
+  }
+
+  std::signal(SIGINT, _onSignal);
+  std::signal(SIGTERM, _onSignal);
+  std::signal(SIGPIPE, SIG_IGN);
+
+  if (_options.verbose) {
+    std::cerr << "Listening: " << p.string() << " workers: " << _workers.size() << std::endl;
+  }
+
+  // readers are detached so that finished connections do not accumulate,
+  // track how many are active in order to wait for them on shutdown
+  std::mutex readersMutex;
+  std::condition_variable readersDone;
+  std::size_t activeReaders = 0;
+
+  auto readRequests = [&, this](std::shared_ptr<Connection> connection) {
+    Reply reply = [connection](const std::string& line) { connection->send(line); };
+
+    std::string pending;
+    char buffer[4096];
+    while (!_signalled) {
+      pollfd pfd = {connection->fd(), POLLIN, 0};
+      if (poll(&pfd, 1, kPollIntervalMs) <= 0) {
+        continue;
+      }
+      ssize_t count = ::read(connection->fd(), buffer, sizeof(buffer));
+      if (count <= 0) {
+        break;  // client closed its end
+      }
+      pending.append(buffer, static_cast<std::size_t>(count));
+
+      std::size_t start = 0;
+      for (auto end = pending.find('\n'); end != std::string::npos;
+           end = pending.find('\n', start)) {
+        if (end > start) {
+          _enqueue(pending.substr(start, end - start), reply);
+        }
+        start = end + 1;
+      }
+      pending.erase(0, start);
+    }
+
+    std::lock_guard<std::mutex> lock(readersMutex);
+    activeReaders--;
+    readersDone.notify_all();
+  };
+
+  while (!_signalled) {
+    pollfd pfd = {listener, POLLIN, 0};
+    if (poll(&pfd, 1, kPollIntervalMs) <= 0) {
+      continue;
+    }
+    int client = accept(listener, nullptr, nullptr);
+    if (client >= 0) {
+      {
+        std::lock_guard<std::mutex> lock(readersMutex);
+        activeReaders++;
+      }
+      std::thread(readRequests, std::make_shared<Connection>(client)).detach();
+    }
+  }
+
+  close(listener);
+  unlink(p.c_str());
+
+  std::unique_lock<std::mutex> lock(readersMutex);
+  readersDone.wait(lock, [&activeReaders] { return activeReaders == 0; });
+  return 0;
+}
@@ -0,0 +1,81 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Long running job server for `utu serve`.
+//
+// Jobs are newline delimited JSON objects read from stdin or from clients of a
+// unix domain socket, for example:
+//
+//   {"id": 1, "command": "analyze", "input": "a.wav", "output": "a.json",
+//    "options": {"freq-res": 200, "window-width": 400}}
+//
+// Each job is answered with a single JSON line (on stdout or the originating
+// socket connection) carrying the job id, status, latency, and queue depth.
+// Jobs run concurrently on a fixed pool of workers, each worker keeps the
+// analyzers it has configured so repeated jobs with the same options skip
+// setup.
+class Server final
+{
+ public:
+  struct Options {
+    unsigned jobs = 1;
+    std::optional<std::filesystem::path> socketPath;
+    bool verbose = true;
+  };
+
+  explicit Server(const Options& options);
+  ~Server();
+
+  Server(const Server&) = delete;
+  Server& operator=(const Server&) = delete;
+
+  // Serve until stdin is closed or, in socket mode, until SIGINT/SIGTERM is
+  // received. Queued jobs are always completed before returning.
+  int run();
+
+ private:
+  using Clock = std::chrono::steady_clock;
+  using Reply = std::function<void(const std::string&)>;
+
+  struct Job {
+    std::string request;
+    Reply reply;
+    Clock::time_point enqueued;
+  };
+
+  void _start();
+  void _stop();
+  void _enqueue(std::string request, Reply reply);
+  void _work();
+
+  int _serveStdin();
+  int _serveSocket(const std::filesystem::path& p);
+
+  Options _options;
+
+  std::mutex _mutex;
+  std::condition_variable _ready;
+  std::deque<Job> _queue;
+  bool _stopping;
+
+  std::vector<std::thread> _workers;
+  std::atomic<uint64_t> _completed;
+  std::atomic<uint64_t> _failed;
+};
@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include "Wisdom.h"
+
+#include <fcntl.h>
+#include <loris/KaiserWindow.h>
+#include <sys/file.h>
+#include <utu/Analysis.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <iostream>
+
+#ifdef UTU_HAVE_FFTW
+#include <fftw3.h>
+#endif
+
+namespace
+{
+
+#ifdef UTU_HAVE_FFTW
+std::string _exportWisdom()
+{
+  char* s = fftw_export_wisdom_to_string();
+  std::string result = s ? s : "";
+  std::free(s);
+  return result;
+}
+#endif
+
+// Holds an flock() on a side file for the lifetime of the instance, the
+// wisdom file itself is replaced by rename so it can not be locked directly.
+class FileLock final
+{
+ public:
+  explicit FileLock(const std::filesystem::path& p) : _fd(open(p.c_str(), O_CREAT | O_RDWR, 0644))
+  {
+    if (_fd >= 0) {
+      flock(_fd, LOCK_EX);
+    }
+  }
+
+  ~FileLock()
+  {
+    if (_fd >= 0) {
+      flock(_fd, LOCK_UN);
+      close(_fd);
+    }
+  }
+
+  FileLock(const FileLock&) = delete;
+  FileLock& operator=(const FileLock&) = delete;
+
+  bool locked() const { return _fd >= 0; }
+
+ private:
+  int _fd;
+};
+
+}  // namespace
+
+bool Wisdom::available()
+{
+#ifdef UTU_HAVE_FFTW
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::string Wisdom::backend()
+{
+#ifdef UTU_HAVE_FFTW
+  // version reported by the linked library rather than the headers
+  return std::string(fftw_version) + " (" UTU_FFT_BACKEND ")";
+#else
+  return "loris built in FFT";
+#endif
+}
+
+Wisdom::Wisdom(std::optional<std::filesystem::path> path) : _path(path)
+{
+  // loris plans transforms at the start of every analysis which may happen on
+  // several threads at once (serve, sweep, bands); make the planner thread
+  // safe before any of them start, without fftw3_threads those analyses run
+  // one at a time and configuration warns about it
+  utu::concurrentAnalysis();
+  load();
+}
+
+Wisdom::~Wisdom() { save(); }
+
+bool Wisdom::load()
+{
+#ifdef UTU_HAVE_FFTW
+  if (!_path || !std::filesystem::exists(*_path)) {
+    return false;
+  }
+
+  if (!fftw_import_wisdom_from_filename(_path->c_str())) {
+    std::cerr << "warning: Unable to import FFTW wisdom from " << *_path << std::endl;
+    return false;
+  }
+  _loaded = _exportWisdom();
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool Wisdom::save()
+{
+#ifdef UTU_HAVE_FFTW
+  if (!_path) {
+    return false;
+  }
+
+  std::string current = _exportWisdom();
+  if (current == _loaded) {
+    return true;  // nothing new learned
+  }
+
+  std::filesystem::path lockPath = *_path;
+  lockPath += ".lock";
+  FileLock lock(lockPath);
+  if (!lock.locked()) {
+    std::cerr << "warning: Unable to lock " << lockPath << ", FFTW wisdom not saved" << std::endl;
+    return false;
+  }
+
+  // merge with wisdom written by other processes since this one started
+  if (std::filesystem::exists(*_path)) {
+    fftw_import_wisdom_from_filename(_path->c_str());
+  }
+
+  std::filesystem::path tempPath = *_path;
+  tempPath += ".tmp." + std::to_string(getpid());
+  if (!fftw_export_wisdom_to_filename(tempPath.c_str())) {
+    std::cerr << "warning: Unable to write FFTW wisdom to " << tempPath << std::endl;
+    return false;
+  }
+
+  std::error_code ec;
+  std::filesystem::rename(tempPath, *_path, ec);
+  if (ec) {
+    std::cerr << "warning: Unable to replace " << *_path << ": " << ec.message() << std::endl;
+    std::filesystem::remove(tempPath, ec);
+    return false;
+  }
+
+  _loaded = _exportWisdom();
+  return true;
+#else
+  return false;
+#endif
+}
+
+void Wisdom::plan(std::size_t size, bool patient)
+{
+#ifdef UTU_HAVE_FFTW
+  unsigned flags = patient ? FFTW_PATIENT : FFTW_MEASURE;
+  int n = static_cast<int>(size);
+
+  auto* in = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * size));
+  auto* out = static_cast<fftw_complex*>(fftw_malloc(sizeof(fftw_complex) * size));
+
+  // wisdom is specific to the placement of the transform, cover both
+  fftw_destroy_plan(fftw_plan_dft_1d(n, in, out, FFTW_FORWARD, flags));
+  fftw_destroy_plan(fftw_plan_dft_1d(n, in, in, FFTW_FORWARD, flags));
+
+  fftw_free(in);
+  fftw_free(out);
+#else
+  (void)size;
+  (void)patient;
+#endif
+}
+
+std::size_t Wisdom::transformSize(double windowWidth, double sampleRate, double sidelobeLevel)
+{
+  // mirrors the window sizing done by Loris::Analyzer, the Kaiser window is
+  // made odd length and the spectrum zero pads it to twice the next power of
+  // two
+  double shape = Loris::KaiserWindow::computeShape(sidelobeLevel);
+  auto length = Loris::KaiserWindow::computeLength(windowWidth / sampleRate, shape);
+  if (length % 2 == 0) {
+    ++length;
+  }
+
+  std::size_t size = 1;
+  while (size < length) {
+    size <<= 1;
+  }
+  return size << 1;
+}
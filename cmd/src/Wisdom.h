@@ -0,0 +1,55 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <optional>
+#include <string>
+
+// Persistent FFTW wisdom.
+//
+// Wisdom is imported from the configured file when constructed and any newly
+// learned plans are merged back into the file when destroyed. Updates take an
+// exclusive lock on "<file>.lock", merge with whatever is currently on disk,
+// and atomically replace the file so concurrent utu processes can share a
+// single wisdom file.
+//
+// When utu is built without FFTW all operations are no-ops.
+class Wisdom final
+{
+ public:
+  // Environment variable consulted when no wisdom file is given explicitly
+  static constexpr char kPathVariable[] = "UTU_FFTW_WISDOM";
+
+  static bool available();
+
+  // Description of the FFT implementation loris was built against
+  static std::string backend();
+
+  explicit Wisdom(std::optional<std::filesystem::path> path);
+  ~Wisdom();
+
+  Wisdom(const Wisdom&) = delete;
+  Wisdom& operator=(const Wisdom&) = delete;
+
+  const std::optional<std::filesystem::path>& path() const { return _path; }
+
+  bool load();
+  bool save();
+
+  // Plan the transforms of the given size which the analyzer will request so
+  // the result is recorded as wisdom.
+  static void plan(std::size_t size, bool patient = false);
+
+  // Size of the transform used by the analyzer for the given configuration.
+  static std::size_t transformSize(double windowWidth, double sampleRate, double sidelobeLevel);
+
+ private:
+  std::optional<std::filesystem::path> _path;
+  std::string _loaded;
+};
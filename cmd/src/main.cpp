@@ -5,24 +5,39 @@
 //
 
 #include <docopt.h>
-#include <loris/Analyzer.h>
-#include <loris/Channelizer.h>
 #include <loris/Distiller.h>
-#include <loris/FrequencyReference.h>
+#include <loris/LinearEnvelope.h>
+#include <loris/Morpher.h>
 #include <loris/PartialList.h>
-#include <loris/SdifFile.h>
+#include <loris/Resampler.h>
 #include <loris/Synthesizer.h>
 #include <utu/utu.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <mutex>
+#include <nlohmann/json.hpp>
 #include <optional>
+#include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 
 #include "AudioFile.h"
 #include "AudioPlayer.h"
-#include "Marshal.h"
+#include "Fingerprint.h"
+#include "NpyFile.h"
+#include "PartialFile.h"
+#include "Server.h"
+#include "Wisdom.h"
 #include "utu/version.h"
 
 using Args = std::map<std::string, docopt::value>;
@@ -40,6 +55,24 @@ int AnalyzeCommand(Args& args);
 int SynthCommand(Args& args);
 int SynthCommandListOutputDevices(Args& args);
 int ConvertCommand(Args& args);
+int MorphCommand(Args& args);
+int ServeCommand(Args& args);
+int TuneCommand(Args& args, Wisdom& wisdom);
+int SweepCommand(Args& args);
+int EvaluateCommand(Args& args);
+int ExportCommand(Args& args);
+int InfoCommand(Args& args);
+
+utu::AnalyzeOptions analyzeOptions(Args& args);
+unsigned jobCount(Args& args);
+std::optional<utu::WriteOptions> partialWriteOptions(Args& args, const std::string& outputPath);
+std::optional<std::filesystem::path> wisdomPath(Args& args);
+std::vector<double> parseValues(const docopt::value& v, const char* message);
+std::vector<double> parseList(const docopt::value& v, const char* message);
+std::vector<utu::AnalysisBand> parseBands(const docopt::value& v);
+
+std::vector<double> renderPartials(const Loris::PartialList& partials, uint32_t sampleRate);
+std::filesystem::path morphStepPath(const std::filesystem::path& p, unsigned step, unsigned steps);
 
 static const char USAGE[] =
     R"(utu
@@ -48,15 +81,32 @@ static const char USAGE[] =
       utu analyze <audio_file> [options] [--output=<file>]
       utu synth <partial_file> [options] [--output=<file>]
       utu synth --list-devices
-      utu convert (<in_sdif> <out_json> | <in_json> <out_sdif>)
+      utu convert <in_file> <out_file> [options]
+      utu morph <source_file> <target_file> [options] [--output=<file>] [--render=<file>]
+      utu serve [options] [--socket=<path>]
+      utu tune [options] [--sample-rates=<list>] [--window-widths=<list>] [--patient]
+      utu sweep <audio_file> [options] [--output=<file>]
+      utu evaluate <audio_file> <partial_file> [options] [--output=<file>] [--residual=<file>]
+      utu export <partial_file> --grid=<hop> [options] [--output=<prefix>]
+      utu info <path>... [options]
       utu (-h | --help)
       utu --version
 
     General Options:
       -o, --output=<file>          write analysis/synthesis result
       -h --help                    Show this screen.
+      --jobs=<n>                   number of parallel jobs, 0 for one per
+                                   core [default: 0]
       --quiet                      Suppress normal output.
+      --wisdom=<file>              FFTW wisdom file to load at startup and
+                                   update on exit, defaults to the
+                                   UTU_FFTW_WISDOM environment variable
       --version                    Show version.
+      --encoding=<encoding>        sample encoding of written utu JSON; text,
+                                   or base64 float64 or float32, other
+                                   formats only take text [default: text]
+      --harmonic-relative          store frequencies of harmonic partials
+                                   relative to a shared fundamental track
 
     Analyze Options:
       --freq-res=<res_hz>          minimum instantaneous frequency
@@ -70,22 +120,82 @@ static const char USAGE[] =
       --lobe-level=<lobe_db>       sidelobe attenuation level for Kaiser analysis
                                    window in positive dB
       --window-width=<win_hz>      frequency domain lobe width [default: 664]
+      --max-freq=<max_hz>          highest frequency of interest, input is
+                                   decimated before analysis when possible
+      --band-resolution=<bands>    analyze bands with their own resolution,
+                                   comma separated res_hz:win_hz:max_hz in
+                                   ascending order, max_hz omitted for the
+                                   highest band; replaces --freq-res and
+                                   --window-width
       --no-phase-correct
+      --update=<partial_file>      update a previous analysis of the source,
+                                   only --region is analyzed; written back to
+                                   the partial file unless --output is given
+      --region=<start,end>         edited time range in seconds for --update
 
     Synth Options:
       --pitch-shift=<cents>        shift the pitch partials [default: 0]
+      --freq-scale=<factor>        scale partial frequencies [default: 1]
+      --time-stretch=<factor>      stretch partials in time [default: 1]
+      --gain=<db>                  adjust partial amplitudes [default: 0]
+      --mute=<labels>              comma separated labels of partials to
+                                   leave out
       --sample-rate=<rate>         sample rate [default: 44100]
       --sample-type=(16|24|32|f32|f64)  sample type [default: 24]
+      --raw                        with --output=-, write headerless little
+                                   endian samples rather than WAV
       --audition                   play result out given audio interface
       --device=<device_num>        play out device other than default output
       --list-devices               list output devices for auditioning
+
+    Morph Options:
+      --steps=<n>                  number of intermediate morphs [default: 8]
+      --resample=<interval>        resample source and target partials to a
+                                   common breakpoint interval before morphing
+      --render=<file>              synthesize each morph to an audio file
+
+    Serve Options:
+      --socket=<path>              accept jobs on a unix domain socket rather
+                                   than stdin
+
+    Tune Options:
+      --sample-rates=<list>        comma separated sample rates to plan for
+                                   [default: 44100,48000,88200,96000]
+      --window-widths=<list>       comma separated analysis window widths to
+                                   plan for [default: 166,332,664,1328]
+      --patient                    spend more time searching for faster plans
+
+    Sweep Options:
+      --sweep-freq-res=<list>      comma separated --freq-res values to try
+      --sweep-window-width=<list>  comma separated --window-width values to try
+      --sweep-freq-drift=<list>    comma separated --freq-drift values to try
+      --sweep-amp-floor=<list>     comma separated --amp-floor values to try
+      --sweep-hop-time=<list>      comma separated --hop-time values to try
+      --format=(csv|json)          sweep report format [default: csv]
+
+    Evaluate Options:
+      --residual=<file>            write the source minus the rendering
+      --block-time=<seconds>       error curve resolution [default: 0.01]
+      --fft-size=<n>               spectral error frame size [default: 2048]
+      --bands=<list>               comma separated band edges in Hz, octave
+                                   bands when not given
+      --min-snr=<snr_db>           fail when the SNR is below this level
+
+    Export Options:
+      --grid=<hop>                 time between frames in seconds, partials are
+                                   resampled to frames x partials matrices
+                                   written as <prefix>.<parameter>.npy
+      --grid-start=<time>          time of the first frame [default: 0]
+      --grid-end=<time>            time of the last frame, defaults to the end
+                                   of the last partial
 )";
 
 int main(int argc, const char** argv)
 {
+  std::string version = std::string(PROJECT_VERSION) + "\nfft: " + Wisdom::backend();
   Args args = docopt::docopt(USAGE, {argv + 1, argv + argc},
-                             true,              // show help if requested
-                             PROJECT_VERSION);  // version string
+                             true,      // show help if requested
+                             version);  // version string
 
 #if 0
   for (auto const& arg : args) {
@@ -93,12 +203,28 @@ int main(int argc, const char** argv)
   }
 #endif
 
+  Wisdom wisdom(wisdomPath(args));
+
   if (args["analyze"].asBool()) {
     return AnalyzeCommand(args);
   } else if (args["synth"].asBool()) {
     return SynthCommand(args);
   } else if (args["convert"].asBool()) {
     return ConvertCommand(args);
+  } else if (args["morph"].asBool()) {
+    return MorphCommand(args);
+  } else if (args["serve"].asBool()) {
+    return ServeCommand(args);
+  } else if (args["tune"].asBool()) {
+    return TuneCommand(args, wisdom);
+  } else if (args["sweep"].asBool()) {
+    return SweepCommand(args);
+  } else if (args["evaluate"].asBool()) {
+    return EvaluateCommand(args);
+  } else if (args["export"].asBool()) {
+    return ExportCommand(args);
+  } else if (args["info"].asBool()) {
+    return InfoCommand(args);
   }
 
   return -1;
@@ -118,48 +244,36 @@ int AnalyzeCommand(Args& args)
     quietOutput = true;
   }
 
-  double resolutionHz =
-      checkAboveZero(vtod(args["--freq-res"]), "--freq-res must be greater than 0");
-  double windowWidthHz = vtod(args["--window-width"]).value();
-
-  Loris::Analyzer a(resolutionHz, windowWidthHz);
-
-  //
-  // configure analysis options
-  //
-
-  auto freqDrift = args["--freq-drift"];
-  if (freqDrift) {
-    a.setFreqDrift(checkAboveZero(vtod(freqDrift), "--freq-drift must be greater than 0"));
-  }
-
-  auto freqFloor = args["--freq-floor"];
-  if (freqFloor) {
-    a.setFreqFloor(checkAboveZero(vtod(freqFloor), "--freq-floor must be greater than 0"));
-  }
-
-  auto ampFloor = args["--amp-floor"];
-  if (ampFloor) {
-    a.setAmpFloor(vtod(ampFloor).value());
-  }
-
-  auto hopTime = args["--hop-time"];
-  if (hopTime) {
-    a.setHopTime(vtod(hopTime).value());
-  }
-
-  auto cropTime = args["--crop-time"];
-  if (cropTime) {
-    a.setCropTime(vtod(cropTime).value());
+  utu::AnalyzeOptions options = analyzeOptions(args);
+  std::optional<utu::WriteOptions> writeOptions =
+      partialWriteOptions(args, outputPath ? outputPath.asString() : "");
+  if (!writeOptions) {
+    return -1;
   }
 
-  auto lobeLevel = args["--lobe-level"];
-  if (lobeLevel) {
-    a.setSidelobeLevel(vtod(lobeLevel).value());
-  }
+  // incremental update of a previous analysis
+  docopt::value updatePath = args["--update"];
+  std::optional<utu::PartialData> previous;
+  std::vector<double> region;
+  if (updatePath) {
+    if (!args["--region"]) {
+      std::cerr << "error: --update requires the edited --region\n";
+      return -1;
+    }
+    region = parseValues(args["--region"], "--region must be a start and end time");
+    if (region.size() != 2 || region[0] < 0 || region[1] < region[0]) {
+      std::cerr << "error: --region must be a start and end time\n";
+      return -1;
+    }
 
-  if (args["--no-phase-correct"]) {
-    a.setPhaseCorrect(false);
+    previous = PartialFile::read(updatePath.asString(), jobCount(args));
+    if (!previous) {
+      std::cerr << "error: Unable to read partials from " << updatePath.asString() << "\n";
+      return -1;
+    }
+    if (!outputPath) {
+      outputPath = updatePath;
+    }
   }
 
   std::string sourcePath = args["<audio_file>"].asString();
@@ -168,18 +282,33 @@ int AnalyzeCommand(Args& args)
     std::cout << "Source: " << sourcePath << " ch: " << f.channels() << " sr: " << f.sampleRate()
               << " frames: " << f.frames() << std::endl;
   }
+  if (previous && region[1] > static_cast<double>(f.frames()) / f.sampleRate()) {
+    std::cerr << "error: --region must be within the source\n";
+    return -1;
+  }
 
   //
   // perform analysis
   //
 
-  Loris::PartialList partials = a.analyze(f.samples(), f.sampleRate());
-  Loris::FrequencyReference partialsRef(partials.begin(), partials.end(), 415 * 0.8, 415 * 1.2, 50);
-  Loris::Channelizer::channelize(partials, partialsRef, 1);
-  Loris::Distiller::distill(partials, 0.001);
+  utu::PartialData data;
+  if (previous) {
+    if (!quietOutput) {
+      std::cout << "Updating: " << region[0] << "s to " << region[1] << "s" << std::endl;
+    }
+    const auto& samples = f.samples();
+    data = utu::reanalyze(*previous, samples.data(), samples.size(), f.sampleRate(), region[0],
+                          region[1], options);
+  } else {
+    data = utu::analyze(f.samples(), f.sampleRate(), options);
+  }
+  if (sourcePath != "-") {
+    data.source = utu::PartialData::Source(
+        {std::filesystem::canonical(sourcePath), Fingerprint::of(sourcePath)});
+  }
 
   if (!quietOutput) {
-    std::cout << "Partials: " << partials.size() << std::endl;
+    std::cout << "Partials: " << data.partials.size() << std::endl;
   }
 
   //
@@ -187,21 +316,7 @@ int AnalyzeCommand(Args& args)
   //
 
   if (outputPath) {
-    if (std::filesystem::path(outputPath.asString()).extension() == ".sdif") {
-      // output native Loris SDIF files
-      Loris::SdifFile::Export(outputPath.asString(), partials);
-    } else {
-      // output JSON format
-      utu::PartialData data = Marshal::from(partials);
-      data.source = utu::PartialData::Source({std::filesystem::canonical(sourcePath), {}});
-
-      if (outputPath.asString() == "-") {
-        utu::PartialWriter::write(data, std::cout);
-      } else {
-        std::ofstream os(outputPath.asString(), std::ios::binary);
-        utu::PartialWriter::write(data, os);
-      }
-    }
+    PartialFile::write(outputPath.asString(), data, *writeOptions);
 
     if (!quietOutput) {
       std::cout << "Wrote: " << outputPath << std::endl;
@@ -226,70 +341,85 @@ int SynthCommand(Args& args)
 
   bool quietOutput = args["--quiet"].asBool();
 
-  Loris::PartialList partials;
-  std::optional<utu::PartialData> data;
+  docopt::value outputPath = args["--output"];
+  if (outputPath && outputPath.asString() == "-") {
+    // if writing to std::out suppress any logging
+    quietOutput = true;
+  }
 
-  if (partialPath == "-") {
-    data = utu::PartialReader::read(std::cin);
-  } else if (std::filesystem::path(partialPath).extension() == ".sdif") {
-    Loris::SdifFile in(partialPath);
-    partials = in.partials();
-  } else {
-    // assume JSON format
-    std::ifstream is(partialPath, std::ios::binary);
-    data = utu::PartialReader::read(is);
-    partials = Marshal::from(*data);
+  std::optional<utu::PartialData> data = PartialFile::read(partialPath, jobCount(args));
+  if (!data) {
+    std::cerr << "error: Unable to read partials from " << partialPath << std::endl;
+    return -1;
   }
 
   if (!quietOutput) {
-    std::cout << "Partials: " << partials.size() << std::endl;
+    std::cout << "Partials: " << data->partials.size() << std::endl;
   }
 
-  std::optional<double> pitchShift = vtod(args["--pitch-shift"]);
-  if (pitchShift && *pitchShift != 0) {
+  auto sr = static_cast<uint32_t>(args["--sample-rate"].asLong());
+
+  utu::SynthOptions options;
+  options.sampleRate = sr;
+  // TODO: fade time
+
+  auto finite = [](double v) { return std::isfinite(v); };
+  double pitchShift =
+      check(vtod(args["--pitch-shift"]), finite, "--pitch-shift must be a number of cents");
+  if (pitchShift != 0) {
     if (!quietOutput) {
-      std::cout << "Shifting pitch by " << *pitchShift << " cents\n";
+      std::cout << "Shifting pitch by " << pitchShift << " cents\n";
     }
-    Loris::PartialUtils::shiftPitch(partials.begin(), partials.end(), *pitchShift);
+    options.pitchShift = pitchShift;
   }
 
-  auto sr = static_cast<uint32_t>(args["--sample-rate"].asLong());
-
-  // configure Loris synthesizer paramters
-  Loris::Synthesizer::Parameters params;
-  params.sampleRate = sr;
-  // TODO: fade time
+  options.frequencyScale =
+      checkAboveZero(vtod(args["--freq-scale"]), "--freq-scale must be greater than 0");
+  options.timeStretch =
+      checkAboveZero(vtod(args["--time-stretch"]), "--time-stretch must be greater than 0");
+  options.gain = check(vtod(args["--gain"]), finite, "--gain must be a number of dB");
+
+  docopt::value mute = args["--mute"];
+  if (mute) {
+    std::istringstream is(mute.asString());
+    for (std::string label; std::getline(is, label, ',');) {
+      options.mutedLabels.push_back(label);
+    }
+  }
 
   // perform synthesis
-  std::vector<double> samples;
-  Loris::Synthesizer synth(params, samples);
-  synth.synthesize(partials.begin(), partials.end());
+  std::vector<double> samples = utu::synthesize(*data, options);
 
   if (!quietOutput) {
     std::cout << "Calculated: " << samples.size() << " frames, sr: " << sr << std::endl;
   }
 
-  docopt::value outputPath = args["--output"];
   if (outputPath) {
-    std::optional<AudioFile::Format> format = AudioFile::inferFormat(outputPath.asString());
-    if (!format) {
-      std::cout << "error: Unsupported output format; must be .wav, .aiff, or .caf\n";
-      return -1;
-    }
-
     docopt::value sampleType = args["--sample-type"];
     std::optional<AudioFile::Encoding> encoding = AudioFile::inferEncoding(sampleType.asString());
     if (!encoding) {
-      std::cout << "error: Unsupported sample type; must be 16, 24, 32, f32, or f64\n";
+      std::cerr << "error: Unsupported sample type; must be 16, 24, 32, f32, or f64\n";
       return -1;
     }
 
-    AudioFile f =
-        AudioFile::forWrite(outputPath.asString(), sr, 1 /* channel */, *format, *encoding);
-    f.write(samples);
+    if (outputPath.asString() == "-") {
+      AudioFile f = AudioFile::forStdout(sr, 1 /* channel */, *encoding, args["--raw"].asBool(),
+                                         static_cast<int64_t>(samples.size()));
+      f.write(samples);
+    } else {
+      std::optional<AudioFile::Format> format = AudioFile::inferFormat(outputPath.asString());
+      if (!format) {
+        std::cout << "error: Unsupported output format; must be .wav, .aiff, or .caf\n";
+        return -1;
+      }
 
-    if (!quietOutput) {
-      std::cout << "Wrote: " << outputPath.asString() << std::endl;
+      AudioFile f =
+          AudioFile::forWrite(outputPath.asString(), sr, 1 /* channel */, *format, *encoding);
+      f.write(samples);
+
+      if (!quietOutput) {
+        std::cout << "Wrote: " << outputPath.asString() << std::endl;
+      }
     }
   }
 
@@ -330,42 +460,861 @@ int SynthCommandListOutputDevices(Args& /* args */)
 
 int ConvertCommand(Args& args)
 {
-  // NOTE: Conversion is lossy, the markers stored in SDIF files are not carried
-  // over to the JSON format.
+  std::string inPath = args["<in_file>"].asString();
+  std::string outPath = args["<out_file>"].asString();
 
-  docopt::value inSdif = args["<in_sdif>"];
-  docopt::value outJson = args["<out_json>"];
-  if (inSdif && outJson) {
-    Loris::SdifFile in(inSdif.asString());
+  std::optional<utu::WriteOptions> writeOptions = partialWriteOptions(args, outPath);
+  if (!writeOptions) {
+    return -1;
+  }
 
-    utu::PartialData data = Marshal::from(in.partials());
-    data.source = utu::PartialData::Source({std::filesystem::canonical(inSdif.asString()), {}});
-    std::ofstream os(outJson.asString(), std::ios::binary);
-    utu::PartialWriter::write(data, os);
+  std::optional<utu::PartialData> data = PartialFile::read(inPath, writeOptions->threads);
+  if (!data) {
+    std::cerr << "error: Unable to read partials from " << inPath << "\n";
+    return -1;
+  }
+  if (!data->source && inPath != "-") {
+    data->source = utu::PartialData::Source({std::filesystem::canonical(inPath), {}});
+  }
 
-    return 0;
+  PartialFile::write(outPath, *data, *writeOptions);
+
+  return 0;
+}
+
+//
+// morph subcommand
+//
+
+int MorphCommand(Args& args)
+{
+  bool quietOutput = args["--quiet"].asBool();
+
+  auto steps = static_cast<unsigned>(
+      checkAboveZero(vtod(args["--steps"]), "--steps must be greater than 0"));
+  auto jobs = std::min(jobCount(args), steps);
+
+  docopt::value outputPath = args["--output"];
+  docopt::value renderPath = args["--render"];
+  if (!outputPath && !renderPath) {
+    std::cout << "error: Expected --output and/or --render for morph results\n";
+    return -1;
   }
 
-  docopt::value inJson = args["<in_json>"];
-  docopt::value outSdif = args["<out_sdif>"];
-  if (inJson && outSdif) {
-    std::ifstream is(inJson.asString(), std::ios::binary);
-    std::optional<utu::PartialData> data = utu::PartialReader::read(is);
+  auto sr = static_cast<uint32_t>(args["--sample-rate"].asLong());
+  std::optional<AudioFile::Format> format;
+  std::optional<AudioFile::Encoding> encoding;
+  if (renderPath) {
+    format = AudioFile::inferFormat(renderPath.asString());
+    if (!format) {
+      std::cout << "error: Unsupported render format; must be .wav, .aiff, or .caf\n";
+      return -1;
+    }
+    encoding = AudioFile::inferEncoding(args["--sample-type"].asString());
+    if (!encoding) {
+      std::cout << "error: Unsupported sample type; must be 16, 24, 32, f32, or f64\n";
+      return -1;
+    }
+  }
+
+  std::optional<double> resampleInterval;
+  if (args["--resample"]) {
+    resampleInterval =
+        checkAboveZero(vtod(args["--resample"]), "--resample must be greater than 0");
+  }
+
+  //
+  // prepare the source and target once, every step morphs the same inputs
+  //
+
+  const std::string sourcePath = args["<source_file>"].asString();
+  const std::string targetPath = args["<target_file>"].asString();
+
+  Loris::PartialList source = PartialFile::readList(sourcePath);
+  Loris::PartialList target = PartialFile::readList(targetPath);
+
+  auto prepare = [&](const std::string& path, Loris::PartialList& partials) {
+    // the morpher pairs partials by label, collapse each label down to a single
+    // partial so that the pairing is one to one
+    Loris::Distiller::distill(partials, 0.001);
+
+    // resampling both sides to a common interval keeps the morpher from
+    // merging two unrelated sets of breakpoint times on every step
+    if (resampleInterval) {
+      Loris::Resampler resampler(*resampleInterval);
+      resampler.resample(partials.begin(), partials.end());
+    }
+
+    auto labeled = std::count_if(partials.begin(), partials.end(),
+                                 [](const Loris::Partial& p) { return p.label() != 0; });
+    if (labeled == 0) {
+      std::cerr << "warning: " << path << " has no labeled partials, morph will crossfade\n";
+    }
+    if (!quietOutput) {
+      std::cout << "Prepared: " << path << " partials: " << partials.size()
+                << " labeled: " << labeled << std::endl;
+    }
+  };
+
+  prepare(sourcePath, source);
+  prepare(targetPath, target);
+
+  //
+  // perform morphs, each worker claims the next unclaimed step
+  //
 
-    Loris::PartialList partials = Marshal::from(*data);
-    Loris::SdifFile::Export(outSdif.asString(), partials);
+  std::atomic<unsigned> nextStep(0);
+  std::atomic<bool> failed(false);
+  std::mutex outputMutex;
 
-    return 0;
+  auto morphStep = [&](unsigned step) {
+    double alpha = static_cast<double>(step + 1) / static_cast<double>(steps + 1);
+
+    Loris::Morpher morpher(Loris::LinearEnvelope{alpha});
+    morpher.morph(source.cbegin(), source.cend(), target.cbegin(), target.cend());
+    const Loris::PartialList& morphed = morpher.partials();
+
+    if (outputPath) {
+      auto p = morphStepPath(outputPath.asString(), step, steps);
+      PartialFile::writeList(p.string(), morphed);
+      if (!quietOutput) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "Wrote: " << p.string() << std::endl;
+      }
+    }
+
+    if (renderPath) {
+      auto p = morphStepPath(renderPath.asString(), step, steps);
+      AudioFile f = AudioFile::forWrite(p, sr, 1 /* channel */, *format, *encoding);
+      f.write(renderPartials(morphed, sr));
+      if (!quietOutput) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cout << "Wrote: " << p.string() << std::endl;
+      }
+    }
+  };
+
+  auto worker = [&]() {
+    for (unsigned step = nextStep++; step < steps && !failed; step = nextStep++) {
+      try {
+        morphStep(step);
+      } catch (const std::exception& e) {
+        std::lock_guard<std::mutex> lock(outputMutex);
+        std::cerr << "error: morph step " << step + 1 << " failed: " << e.what() << std::endl;
+        failed = true;
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned j = 0; j < jobs; ++j) {
+    workers.emplace_back(worker);
+  }
+  for (auto& w : workers) {
+    w.join();
   }
 
-  std::cout << "error: expected input/output file paths for partial data\n";
-  return -1;
+  return failed ? -1 : 0;
+}
+
+std::filesystem::path morphStepPath(const std::filesystem::path& p, unsigned step, unsigned steps)
+{
+  // foo.json => foo-01.json, foo-02.json, ...
+  int width = static_cast<int>(std::to_string(steps).size());
+  std::ostringstream name;
+  name << p.stem().string() << "-" << std::setw(width) << std::setfill('0') << step + 1
+       << p.extension().string();
+  return p.parent_path() / name.str();
+}
+
+//
+// serve subcommand
+//
+
+int ServeCommand(Args& args)
+{
+  Server::Options options;
+  options.jobs = jobCount(args);
+  options.verbose = !args["--quiet"].asBool();
+  if (args["--socket"]) {
+    options.socketPath = args["--socket"].asString();
+  }
+
+  Server server(options);
+  return server.run();
+}
+
+//
+// tune subcommand
+//
+
+int TuneCommand(Args& args, Wisdom& wisdom)
+{
+  bool quietOutput = args["--quiet"].asBool();
+
+  if (!Wisdom::available()) {
+    std::cerr << "error: utu was built without FFTW, there are no plans to tune\n";
+    return -1;
+  }
+  if (!wisdom.path()) {
+    std::cerr << "error: Expected --wisdom=<file> or " << Wisdom::kPathVariable << " to be set\n";
+    return -1;
+  }
+
+  std::vector<double> sampleRates =
+      parseList(args["--sample-rates"], "--sample-rates must be a list of numbers above 0");
+  std::vector<double> windowWidths =
+      parseList(args["--window-widths"], "--window-widths must be a list of numbers above 0");
+
+  // the analyzer sidelobe level follows the amplitude floor unless set
+  double sidelobeLevel = args["--lobe-level"] ? vtod(args["--lobe-level"]).value()
+                                              : -vtod(args["--amp-floor"]).value();
+
+  std::set<std::size_t> sizes;
+  for (double sr : sampleRates) {
+    for (double width : windowWidths) {
+      sizes.insert(Wisdom::transformSize(width, sr, sidelobeLevel));
+    }
+  }
+
+  for (std::size_t size : sizes) {
+    if (!quietOutput) {
+      std::cout << "Planning: " << size << std::endl;
+    }
+    Wisdom::plan(size, args["--patient"].asBool());
+  }
+
+  if (!wisdom.save()) {
+    return -1;
+  }
+  if (!quietOutput) {
+    std::cout << "Wrote: " << wisdom.path()->string() << std::endl;
+  }
+  return 0;
+}
+
+//
+// sweep subcommand
+//
+
+// An analysis configuration of a sweep along with its measurements.
+struct SweepResult {
+  utu::AnalyzeOptions options;
+  std::size_t partials = 0;
+  std::size_t breakpoints = 0;
+  double analysisMs = 0;
+  double snr = 0;
+  std::optional<std::string> error;
+};
+
+int SweepCommand(Args& args)
+{
+  bool quietOutput = args["--quiet"].asBool();
+
+  docopt::value outputPath = args["--output"];
+  if (outputPath && outputPath.asString() == "-") {
+    quietOutput = true;
+  }
+
+  std::string format = args["--format"].asString();
+  if (format != "csv" && format != "json") {
+    std::cerr << "error: Unsupported report format; must be csv or json\n";
+    return -1;
+  }
+
+  // every combination of the swept values, starting from the analyze options
+  std::vector<utu::AnalyzeOptions> configs = {analyzeOptions(args)};
+  // swept values have the same limits as the option they replace
+  auto sweep = [&](const char* flag, bool positive, auto apply) {
+    if (!args[flag]) {
+      return;
+    }
+    std::string message = std::string(flag) + " must be a list of numbers" +
+                          (positive ? " greater than 0" : "");
+    std::vector<double> values = positive ? parseList(args[flag], message.c_str())
+                                          : parseValues(args[flag], message.c_str());
+    std::vector<utu::AnalyzeOptions> expanded;
+    for (const auto& config : configs) {
+      for (double value : values) {
+        expanded.push_back(config);
+        apply(expanded.back(), value);
+      }
+    }
+    configs.swap(expanded);
+  };
+  sweep("--sweep-freq-res", true, [](utu::AnalyzeOptions& o, double v) { o.freqResolution = v; });
+  sweep("--sweep-window-width", true,
+        [](utu::AnalyzeOptions& o, double v) { o.windowWidth = v; });
+  sweep("--sweep-freq-drift", true, [](utu::AnalyzeOptions& o, double v) { o.freqDrift = v; });
+  sweep("--sweep-amp-floor", false, [](utu::AnalyzeOptions& o, double v) { o.ampFloor = v; });
+  sweep("--sweep-hop-time", true, [](utu::AnalyzeOptions& o, double v) { o.hopTime = v; });
+
+  // decode once, every configuration analyzes the same samples
+  std::string sourcePath = args["<audio_file>"].asString();
+  AudioFile f = AudioFile::forRead(sourcePath);
+  const AudioFile::Samples& samples = f.samples();
+  double sr = f.sampleRate();
+
+  // the job budget is shared between configurations and the bands of each
+  unsigned budget = jobCount(args);
+  auto jobs = std::min(budget, static_cast<unsigned>(configs.size()));
+  if (!utu::concurrentAnalysis()) {
+    // fft planning is not thread safe, see utu::concurrentAnalysis()
+    jobs = 1;
+  }
+  for (auto& config : configs) {
+    config.threads = std::max(budget / jobs, 1u);
+  }
+  if (!quietOutput) {
+    std::cout << "Sweeping: " << configs.size() << " configurations, " << jobs << " jobs"
+              << std::endl;
+  }
+
+  // NOTE: configurations run concurrently so analysis times include any
+  // contention between jobs; use --jobs=1 for isolated timings.
+  std::vector<SweepResult> results(configs.size());
+  std::atomic<std::size_t> nextConfig(0);
+  auto work = [&]() {
+    for (std::size_t i = nextConfig++; i < configs.size(); i = nextConfig++) {
+      SweepResult& r = results[i];
+      r.options = configs[i];
+      try {
+        auto start = std::chrono::steady_clock::now();
+        utu::PartialData data = utu::analyze(samples, sr, r.options);
+        r.analysisMs = std::chrono::duration<double, std::milli>(
+                           std::chrono::steady_clock::now() - start)
+                           .count();
+
+        r.partials = data.partials.size();
+        for (const auto& p : data.partials) {
+          auto t = p.parameters.find(kTimeName);
+          r.breakpoints += t == p.parameters.end() ? 0 : t->second.size();
+        }
+
+        utu::SynthOptions synthOptions;
+        synthOptions.sampleRate = sr;
+        std::vector<double> rendered(samples.size());
+        utu::synthesize(data, synthOptions, rendered.data(), rendered.size());
+        r.snr = utu::signalToNoise(samples.data(), rendered.data(), samples.size());
+      } catch (const std::exception& e) {
+        r.error = e.what();
+      }
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned j = 0; j < jobs; ++j) {
+    workers.emplace_back(work);
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  std::ofstream file;
+  if (outputPath && outputPath.asString() != "-") {
+    file.open(outputPath.asString());
+  }
+  std::ostream& os = file.is_open() ? file : std::cout;
+
+  auto optional = [](const std::optional<double>& v) { return v ? nlohmann::json(*v) : nullptr; };
+  if (format == "json") {
+    nlohmann::json report = nlohmann::json::array();
+    for (const auto& r : results) {
+      nlohmann::json row;
+      row["freq_res"] = r.options.freqResolution;
+      row["window_width"] = r.options.windowWidth;
+      row["freq_drift"] = optional(r.options.freqDrift);
+      row["amp_floor"] = optional(r.options.ampFloor);
+      row["hop_time"] = optional(r.options.hopTime);
+      row["partials"] = r.partials;
+      row["breakpoints"] = r.breakpoints;
+      row["analysis_ms"] = r.analysisMs;
+      row["snr_db"] = r.snr;
+      if (r.error) {
+        row["error"] = *r.error;
+      }
+      report.push_back(row);
+    }
+    os << std::setw(2) << report << std::endl;
+  } else {
+    auto field = [](const std::optional<double>& v) {
+      std::ostringstream ss;
+      if (v) {
+        ss << *v;
+      }
+      return ss.str();
+    };
+    os << "freq_res,window_width,freq_drift,amp_floor,hop_time,partials,breakpoints,analysis_ms,"
+          "snr_db,error\n";
+    for (const auto& r : results) {
+      os << r.options.freqResolution << ',' << r.options.windowWidth << ','
+         << field(r.options.freqDrift) << ',' << field(r.options.ampFloor) << ','
+         << field(r.options.hopTime) << ',' << r.partials << ',' << r.breakpoints << ','
+         << r.analysisMs << ',' << r.snr << ',' << std::quoted(r.error.value_or("")) << '\n';
+    }
+  }
+
+  if (file.is_open() && !quietOutput) {
+    std::cout << "Wrote: " << outputPath.asString() << std::endl;
+  }
+
+  bool failed = std::any_of(results.begin(), results.end(), [](auto& r) { return r.error; });
+  return failed ? -1 : 0;
+}
+
+//
+// evaluate subcommand
+//
+
+int EvaluateCommand(Args& args)
+{
+  bool quietOutput = args["--quiet"].asBool();
+
+  docopt::value outputPath = args["--output"];
+  if (outputPath && outputPath.asString() == "-") {
+    quietOutput = true;
+  }
+
+  utu::EvaluateOptions options;
+  options.threads = jobCount(args);
+  options.blockTime =
+      checkAboveZero(vtod(args["--block-time"]), "--block-time must be greater than 0");
+  options.fftSize = static_cast<std::size_t>(args["--fft-size"].asLong());
+  if (options.fftSize < 2 || (options.fftSize & (options.fftSize - 1)) != 0) {
+    std::cerr << "error: --fft-size must be a power of two\n";
+    return -1;
+  }
+  if (args["--bands"]) {
+    options.bandEdges = parseValues(args["--bands"], "--bands must be a list of frequencies");
+  }
+
+  std::optional<double> minSnr;
+  if (args["--min-snr"]) {
+    minSnr = check(
+        vtod(args["--min-snr"]), [](double) { return true; }, "--min-snr must be a number");
+  }
+
+  std::string partialPath = args["<partial_file>"].asString();
+  std::optional<utu::PartialData> data = PartialFile::read(partialPath, jobCount(args));
+  if (!data) {
+    std::cerr << "error: Unable to read partials from " << partialPath << "\n";
+    return -1;
+  }
+
+  AudioFile f = AudioFile::forRead(args["<audio_file>"].asString());
+  const AudioFile::Samples& source = f.samples();
+  int sr = f.sampleRate();
+
+  // render at the source rate over exactly the source duration; the Loris
+  // synthesizer renders a whole buffer so both signals are held in memory and
+  // evaluated by block from there
+  utu::SynthOptions synthOptions;
+  synthOptions.sampleRate = sr;
+  std::vector<double> rendered(source.size());
+  utu::synthesize(*data, synthOptions, rendered.data(), rendered.size());
+
+  utu::Evaluation e = utu::evaluate(source.data(), rendered.data(), source.size(), sr, options);
+
+  if (!quietOutput) {
+    std::cout << "SNR: " << e.snr << " dB\n";
+    for (const auto& band : e.bands) {
+      std::cout << "  " << std::setw(8) << band.lowFrequency << " - " << std::setw(8)
+                << band.highFrequency << " Hz: " << band.error << " dB\n";
+    }
+  }
+
+  if (outputPath) {
+    nlohmann::json report;
+    report["snr_db"] = e.snr;
+    report["bands"] = nlohmann::json::array();
+    for (const auto& band : e.bands) {
+      report["bands"].push_back({{"low_hz", band.lowFrequency},
+                                 {"high_hz", band.highFrequency},
+                                 {"source_db", band.sourceLevel},
+                                 {"error_db", band.error}});
+    }
+    report["block_time"] = e.blockTime;
+    report["error_curve_db"] = e.errorCurve;
+
+    if (outputPath.asString() == "-") {
+      std::cout << std::setw(2) << report << std::endl;
+    } else {
+      std::ofstream os(outputPath.asString());
+      os << std::setw(2) << report << std::endl;
+      if (!quietOutput) {
+        std::cout << "Wrote: " << outputPath.asString() << std::endl;
+      }
+    }
+  }
+
+  docopt::value residualPath = args["--residual"];
+  if (residualPath) {
+    std::optional<AudioFile::Format> format = AudioFile::inferFormat(residualPath.asString());
+    std::optional<AudioFile::Encoding> encoding =
+        AudioFile::inferEncoding(args["--sample-type"].asString());
+    if (!format || !encoding) {
+      std::cerr << "error: Unsupported residual format; must be .wav, .aiff, or .caf\n";
+      return -1;
+    }
+
+    // the rendering is no longer needed, reuse it for the residual
+    std::vector<double>& residual = rendered;
+    for (std::size_t i = 0; i < residual.size(); ++i) {
+      residual[i] = source[i] - rendered[i];
+    }
+
+    AudioFile r = AudioFile::forWrite(residualPath.asString(), static_cast<uint32_t>(sr),
+                                      1 /* channel */, *format, *encoding);
+    r.write(residual);
+    if (!quietOutput) {
+      std::cout << "Wrote: " << residualPath.asString() << std::endl;
+    }
+  }
+
+  if (minSnr && e.snr < *minSnr) {
+    std::cerr << "error: SNR of " << e.snr << " dB is below " << *minSnr << " dB\n";
+    return -1;
+  }
+
+  return 0;
+}
+
+//
+// export subcommand
+//
+
+int ExportCommand(Args& args)
+{
+  bool quietOutput = args["--quiet"].asBool();
+
+  utu::GridOptions options;
+  options.threads = jobCount(args);
+  options.hop = checkAboveZero(vtod(args["--grid"]), "--grid must be greater than 0");
+  options.startTime = check(
+      vtod(args["--grid-start"]), [](double v) { return v >= 0; },
+      "--grid-start must be a time of 0 or more");
+  if (args["--grid-end"]) {
+    options.endTime = check(
+        vtod(args["--grid-end"]), [&](double v) { return v >= options.startTime; },
+        "--grid-end must be a time after --grid-start");
+  }
+
+  std::string partialPath = args["<partial_file>"].asString();
+  std::optional<utu::PartialData> data = PartialFile::read(partialPath, options.threads);
+  if (!data) {
+    std::cerr << "error: Unable to read partials from " << partialPath << "\n";
+    return -1;
+  }
+
+  // <prefix>.<parameter>.npy, alongside the partial file by default
+  std::filesystem::path prefix = std::filesystem::path(partialPath).replace_extension();
+  if (args["--output"]) {
+    prefix = args["--output"].asString();
+  }
+
+  utu::Grid grid = utu::grid(*data, options);
+  if (!quietOutput) {
+    std::cout << "Resampled: " << grid.partials << " partials, " << grid.frames << " frames"
+              << std::endl;
+  }
+
+  auto path = [&](const char* name) {
+    std::filesystem::path p = prefix;
+    p += std::string(".") + name;
+    return p;
+  };
+
+  std::vector<double> times(grid.frames);
+  for (std::size_t f = 0; f < grid.frames; ++f) {
+    times[f] = grid.startTime + static_cast<double>(f) * grid.hop;
+  }
+
+  std::vector<std::size_t> shape = {grid.frames, grid.partials};
+  NpyFile::write(path("time.npy"), times, {grid.frames});
+  NpyFile::write(path("frequency.npy"), grid.frequency, shape);
+  NpyFile::write(path("amplitude.npy"), grid.amplitude, shape);
+  NpyFile::write(path("bandwidth.npy"), grid.bandwidth, shape);
+  NpyFile::write(path("phase.npy"), grid.phase, shape);
+  NpyFile::write(path("active.npy"), grid.active, shape);
+
+  // the label of each column, blank for partials without one
+  std::ofstream labels(path("labels.txt"));
+  for (const auto& p : data->partials) {
+    labels << p.label.value_or("") << '\n';
+  }
+
+  if (!quietOutput) {
+    std::cout << "Wrote: " << path("*.npy").string() << std::endl;
+  }
+
+  return 0;
+}
+
+//
+// info subcommand
+//
+
+int InfoCommand(Args& args)
+{
+  // directories are expanded to the partial files they hold
+  std::vector<std::filesystem::path> paths;
+  for (const auto& p : args["<path>"].asStringList()) {
+    if (!std::filesystem::is_directory(p)) {
+      paths.emplace_back(p);
+      continue;
+    }
+    std::vector<std::filesystem::path> found;
+    for (const auto& entry : std::filesystem::directory_iterator(p)) {
+      if (entry.is_regular_file() && PartialFile::isPartialFile(entry.path())) {
+        found.push_back(entry.path());
+      }
+    }
+    std::sort(found.begin(), found.end());
+    paths.insert(paths.end(), found.begin(), found.end());
+  }
+
+  // only the headers are read so each file costs little regardless of size
+  std::vector<std::optional<utu::PartialHeader>> headers(paths.size());
+  std::vector<std::string> errors(paths.size());
+  std::atomic<std::size_t> nextPath(0);
+  auto work = [&]() {
+    for (std::size_t i = nextPath++; i < paths.size(); i = nextPath++) {
+      try {
+        headers[i] = PartialFile::readHeader(paths[i].string());
+        if (!headers[i]) {
+          errors[i] = "Unable to read partials";
+        }
+      } catch (const std::exception& e) {
+        errors[i] = e.what();
+      }
+    }
+  };
+
+  auto jobs = std::min(jobCount(args), static_cast<unsigned>(paths.size()));
+  std::vector<std::thread> workers;
+  for (unsigned j = 0; j < jobs; ++j) {
+    workers.emplace_back(work);
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+
+  auto range = [](const utu::Summary& s, const char* name, bool max, int precision) {
+    auto it = s.ranges.find(name);
+    if (it == s.ranges.end()) {
+      return std::string("-");
+    }
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(precision) << (max ? it->second.max : it->second.min);
+    return os.str();
+  };
+
+  std::cout << std::left << std::setw(32) << "file" << std::right << std::setw(10) << "partials"
+            << std::setw(13) << "breakpoints" << std::setw(10) << "start" << std::setw(10)
+            << "end" << std::setw(11) << "min_freq" << std::setw(11) << "max_freq"
+            << "  fingerprint\n";
+
+  int result = 0;
+  for (std::size_t i = 0; i < paths.size(); ++i) {
+    if (!headers[i]) {
+      std::cerr << "error: " << errors[i] << " from " << paths[i].string() << "\n";
+      result = -1;
+      continue;
+    }
+
+    const utu::Summary& s = *headers[i]->summary;
+    std::optional<std::string> fingerprint = s.fingerprint;
+    if (!fingerprint && headers[i]->fields.source) {
+      fingerprint = headers[i]->fields.source->fingerprint;
+    }
+    std::cout << std::left << std::setw(32) << paths[i].filename().string() << std::right
+              << std::setw(10) << s.partials << std::setw(13) << s.breakpoints << std::setw(10)
+              << range(s, kTimeName, false, 3) << std::setw(10) << range(s, kTimeName, true, 3)
+              << std::setw(11) << range(s, kFrequencyName, false, 1) << std::setw(11)
+              << range(s, kFrequencyName, true, 1) << "  " << fingerprint.value_or("-") << "\n";
+  }
+
+  return result;
 }
 
 //
 // Helpers
 //
 
+std::optional<std::filesystem::path> wisdomPath(Args& args)
+{
+  if (args["--wisdom"]) {
+    return args["--wisdom"].asString();
+  }
+  if (const char* p = std::getenv(Wisdom::kPathVariable)) {
+    return std::filesystem::path(p);
+  }
+  return {};
+}
+
+utu::AnalyzeOptions analyzeOptions(Args& args)
+{
+  utu::AnalyzeOptions options;
+  options.freqResolution =
+      checkAboveZero(vtod(args["--freq-res"]), "--freq-res must be greater than 0");
+  options.windowWidth =
+      checkAboveZero(vtod(args["--window-width"]), "--window-width must be greater than 0");
+
+  auto freqDrift = args["--freq-drift"];
+  if (freqDrift) {
+    options.freqDrift = checkAboveZero(vtod(freqDrift), "--freq-drift must be greater than 0");
+  }
+
+  auto freqFloor = args["--freq-floor"];
+  if (freqFloor) {
+    options.freqFloor = checkAboveZero(vtod(freqFloor), "--freq-floor must be greater than 0");
+  }
+
+  auto ampFloor = args["--amp-floor"];
+  if (ampFloor) {
+    options.ampFloor = vtod(ampFloor).value();
+  }
+
+  auto hopTime = args["--hop-time"];
+  if (hopTime) {
+    options.hopTime = checkAboveZero(vtod(hopTime), "--hop-time must be greater than 0");
+  }
+
+  auto cropTime = args["--crop-time"];
+  if (cropTime) {
+    options.cropTime = vtod(cropTime).value();
+  }
+
+  auto lobeLevel = args["--lobe-level"];
+  if (lobeLevel) {
+    options.sidelobeLevel = vtod(lobeLevel).value();
+  }
+
+  if (args["--no-phase-correct"]) {
+    options.phaseCorrect = false;
+  }
+
+  auto maxFreq = args["--max-freq"];
+  if (maxFreq) {
+    options.maxFrequency = checkAboveZero(vtod(maxFreq), "--max-freq must be greater than 0");
+  }
+
+  auto bands = args["--band-resolution"];
+  if (bands) {
+    options.bands = parseBands(bands);
+  }
+  options.threads = jobCount(args);
+
+  return options;
+}
+
+std::vector<double> parseValues(const docopt::value& v, const char* message)
+{
+  std::vector<double> values;
+  std::istringstream is(v.asString());
+  for (std::string item; std::getline(is, item, ',');) {
+    std::optional<double> value;
+    try {
+      value = std::stod(item);
+    } catch (...) {
+    }
+    values.push_back(check(value, [](double) { return true; }, message));
+  }
+  return values;
+}
+
+std::vector<double> parseList(const docopt::value& v, const char* message)
+{
+  std::vector<double> values = parseValues(v, message);
+  for (double value : values) {
+    checkAboveZero(std::optional<double>(value), message);
+  }
+  return values;
+}
+
+std::vector<utu::AnalysisBand> parseBands(const docopt::value& v)
+{
+  const char* message =
+      "--band-resolution must be a list of res_hz:win_hz:max_hz above 0 with ascending max_hz, omitted "
+      "only for the last band";
+
+  std::vector<utu::AnalysisBand> bands;
+  std::istringstream is(v.asString());
+  for (std::string item; std::getline(is, item, ',');) {
+    std::vector<double> values;
+    std::istringstream fields(item);
+    for (std::string field; std::getline(fields, field, ':');) {
+      std::optional<double> value;
+      try {
+        value = std::stod(field);
+      } catch (...) {
+      }
+      values.push_back(checkAboveZero(value, message));
+    }
+    // only the last band may extend to the top of the spectrum
+    std::optional<double> previous = bands.empty() ? 0.0 : bands.back().maxFrequency;
+    bool valid = (values.size() == 2 || values.size() == 3) && previous &&
+                 (values.size() == 2 || values[2] > *previous);
+    if (!valid) {
+      std::cerr << message << std::endl;
+      exit(-1);
+    }
+
+    utu::AnalysisBand band{values[0], values[1], {}};
+    if (values.size() == 3) {
+      band.maxFrequency = values[2];
+    }
+    bands.push_back(band);
+  }
+  return bands;
+}
+
+unsigned jobCount(Args& args)
+{
+  auto jobs = static_cast<unsigned>(
+      check(vtod(args["--jobs"]), [](double v) { return v >= 0; }, "--jobs must be 0 or more"));
+  if (jobs == 0) {
+    jobs = std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  return jobs;
+}
+
+std::optional<utu::WriteOptions> partialWriteOptions(Args& args, const std::string& outputPath)
+{
+  utu::WriteOptions options;
+  options.threads = jobCount(args);
+  options.harmonicRelative = args["--harmonic-relative"].asBool();
+
+  std::string encoding = args["--encoding"].asString();
+  if (encoding == "float64") {
+    options.encoding = utu::SampleEncoding::Base64Float64;
+  } else if (encoding == "float32") {
+    options.encoding = utu::SampleEncoding::Base64Float32;
+  } else if (encoding != "text") {
+    std::cerr << "error: Unsupported sample encoding; must be text, float64, or float32\n";
+    return {};
+  }
+  if (options.encoding != utu::SampleEncoding::Text && !outputPath.empty() &&
+      !PartialFile::isJson(outputPath)) {
+    std::cerr << "error: --encoding only applies to utu JSON output\n";
+    return {};
+  }
+  return options;
+}
+
+std::vector<double> renderPartials(const Loris::PartialList& partials, uint32_t sampleRate)
+{
+  // configure Loris synthesizer paramters
+  Loris::Synthesizer::Parameters params;
+  params.sampleRate = sampleRate;
+  // TODO: fade time
+
+  std::vector<double> samples;
+  Loris::Synthesizer synth(params, samples);
+  synth.synthesize(partials.begin(), partials.end());
+  return samples;
+}
+
 std::optional<double> vtod(const docopt::value& v) noexcept
 {
   try {
@@ -0,0 +1,85 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <string>
+#include <utu/PartialData.h>
+#include <vector>
+
+// Minimal timing helpers shared by the benchmark programs.
+namespace bench
+{
+
+// Run fn the given number of times returning the median wall time in
+// milliseconds.
+template <typename F>
+double medianMs(F&& fn, std::size_t repetitions = 5)
+{
+  std::vector<double> times;
+  for (std::size_t i = 0; i < repetitions; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+  std::sort(times.begin(), times.end());
+  return times[times.size() / 2];
+}
+
+// A harmonic test tone with 1/k amplitudes; every harmonic below maxFrequency
+// is present.
+inline std::vector<double> harmonicTone(double fundamental, double maxFrequency, double duration,
+                                        double sampleRate)
+{
+  constexpr double kTwoPi = 2.0 * 3.14159265358979323846;
+  auto frames = static_cast<std::size_t>(duration * sampleRate);
+  std::vector<double> samples(frames, 0.0);
+  for (int k = 1; k * fundamental < maxFrequency; ++k) {
+    double f = k * fundamental;
+    double a = 0.5 / k;
+    for (std::size_t n = 0; n < frames; ++n) {
+      samples[n] += a * std::sin(kTwoPi * f * static_cast<double>(n) / sampleRate);
+    }
+  }
+  return samples;
+}
+
+// Partial data shaped like an analysis result: the given number of partials
+// with staggered onsets, each with a fixed number of breakpoints.
+inline utu::PartialData syntheticPartials(std::size_t count, std::size_t breakpoints)
+{
+  utu::PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName, kBandwidthName, kPhaseName};
+  data.partials.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    utu::Partial& p = data.partials.emplace_back();
+    if (i % 4 != 0) {
+      p.label = std::to_string(i % 32 + 1);
+    }
+    double onset = 0.01 * static_cast<double>(i % 500);
+    double f = 55.0 * static_cast<double>(i % 64 + 1);
+    for (const char* name : {kTimeName, kFrequencyName, kAmplitudeName, kBandwidthName,
+                             kPhaseName}) {
+      p.parameters[name].reserve(breakpoints);
+    }
+    for (std::size_t b = 0; b < breakpoints; ++b) {
+      double x = static_cast<double>(b);
+      p.parameters[kTimeName].push_back(onset + 0.001 * x);
+      p.parameters[kFrequencyName].push_back(f + std::sin(0.1 * x));
+      p.parameters[kAmplitudeName].push_back(0.25 / static_cast<double>(i % 64 + 1));
+      p.parameters[kBandwidthName].push_back(0.01 * static_cast<double>(b % 10));
+      p.parameters[kPhaseName].push_back(std::fmod(0.37 * x, 6.283185307179586));
+    }
+  }
+  return data;
+}
+
+}  // namespace bench
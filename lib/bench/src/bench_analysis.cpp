@@ -0,0 +1,118 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+// Analysis cost and accuracy with and without decimating the input ahead of
+// analysis (AnalyzeOptions::maxFrequency), and of a single analysis against
+// concurrent band analyses (AnalyzeOptions::bands). The input is a synthetic
+// harmonic tone so accuracy is measured against the known harmonic
+// frequencies and amplitudes.
+
+#include <utu/Analysis.h>
+
+#include <cmath>
+#include <cstdio>
+#include <optional>
+#include <vector>
+
+#include "Bench.h"
+
+namespace
+{
+
+constexpr double kFundamental = 220;
+constexpr double kToneCeiling = 4000;
+constexpr double kDuration = 2.0;
+
+struct Accuracy {
+  int harmonics = 0;
+  double frequencyError = 0;  // mean absolute, Hz
+  double amplitudeError = 0;  // mean absolute, dB
+};
+
+Accuracy measure(const utu::PartialData& data)
+{
+  Accuracy result;
+  for (const auto& p : data.partials) {
+    const auto& freq = p.parameters.at(kFrequencyName);
+    const auto& amp = p.parameters.at(kAmplitudeName);
+    if (freq.empty()) {
+      continue;
+    }
+
+    // use the middle of each partial to avoid onset/release effects
+    std::size_t i = freq.size() / 2;
+    int k = static_cast<int>(std::lround(freq[i] / kFundamental));
+    if (k < 1 || k * kFundamental >= kToneCeiling) {
+      continue;
+    }
+
+    result.harmonics++;
+    result.frequencyError += std::abs(freq[i] - k * kFundamental);
+    result.amplitudeError += std::abs(20.0 * std::log10(amp[i] / (0.5 / k)));
+  }
+
+  if (result.harmonics > 0) {
+    result.frequencyError /= result.harmonics;
+    result.amplitudeError /= result.harmonics;
+  }
+  return result;
+}
+
+}  // namespace
+
+int main()
+{
+  std::printf("%8s %9s %10s %9s %10s %13s %12s\n", "sr", "max_freq", "time_ms", "partials",
+              "harmonics", "freq_err_hz", "amp_err_db");
+
+  for (double sr : {48000.0, 96000.0, 192000.0}) {
+    std::vector<double> tone = bench::harmonicTone(kFundamental, kToneCeiling, kDuration, sr);
+
+    for (std::optional<double> maxFreq : {std::optional<double>(), std::optional<double>(5000)}) {
+      utu::AnalyzeOptions options;
+      options.fundamental = kFundamental;
+      options.maxFrequency = maxFreq;
+
+      utu::PartialData data;
+      double ms = bench::medianMs([&] { data = utu::analyze(tone, sr, options); }, 3);
+      Accuracy a = measure(data);
+
+      std::printf("%8.0f %9.0f %10.1f %9zu %10d %13.4f %12.4f\n", sr, maxFreq.value_or(0), ms,
+                  data.partials.size(), a.harmonics, a.frequencyError, a.amplitudeError);
+    }
+  }
+
+  // long windows below 1 kHz, the default up to 3 kHz, short windows above
+  const std::vector<utu::AnalysisBand> bands = {
+      {150, 300, 1000},
+      {332, 664, 3000},
+      {800, 1600, {}},
+  };
+
+  std::printf("\n%8s %6s %10s %9s %10s %13s %12s\n", "sr", "bands", "time_ms", "partials",
+              "harmonics", "freq_err_hz", "amp_err_db");
+
+  for (double sr : {48000.0, 96000.0}) {
+    std::vector<double> tone = bench::harmonicTone(kFundamental, kToneCeiling, kDuration, sr);
+
+    for (bool split : {false, true}) {
+      utu::AnalyzeOptions options;
+      options.fundamental = kFundamental;
+      if (split) {
+        options.bands = bands;
+      }
+
+      utu::PartialData data;
+      double ms = bench::medianMs([&] { data = utu::analyze(tone, sr, options); }, 3);
+      Accuracy a = measure(data);
+
+      std::printf("%8.0f %6zu %10.1f %9zu %10d %13.4f %12.4f\n", sr, options.bands.size(), ms,
+                  data.partials.size(), a.harmonics, a.frequencyError, a.amplitudeError);
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,65 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+// Size and load time of the same partials written with each sample encoding
+// of the JSON format and in the binary formats.
+
+#include <utu/PartialIO.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "Bench.h"
+
+namespace
+{
+
+constexpr std::size_t kPartials = 2000;
+constexpr std::size_t kBreakpoints = 500;
+
+void run(const char* name, const utu::PartialData& data, utu::SampleEncoding encoding)
+{
+  utu::WriteOptions options;
+  options.encoding = encoding;
+  std::string text = *utu::PartialWriter::write(data, options);
+
+  double writeMs = bench::medianMs([&] { utu::PartialWriter::write(data, options); }, 3);
+  double loadMs = bench::medianMs([&] { utu::PartialReader::read(text); }, 3);
+  double floatLoadMs = bench::medianMs([&] { utu::FloatPartialReader::read(text); }, 3);
+
+  std::printf("%8s %12zu %10.1f %10.1f %14.1f\n", name, text.size(), writeMs, loadMs,
+              floatLoadMs);
+}
+
+void run(const char* name, const utu::PartialData& data, utu::BinaryFormat format)
+{
+  std::vector<std::uint8_t> bytes = utu::PartialWriter::write(data, format);
+
+  double writeMs = bench::medianMs([&] { utu::PartialWriter::write(data, format); }, 3);
+  double loadMs = bench::medianMs([&] { utu::PartialReader::read(bytes, format); }, 3);
+  double floatLoadMs = bench::medianMs([&] { utu::FloatPartialReader::read(bytes, format); }, 3);
+
+  std::printf("%8s %12zu %10.1f %10.1f %14.1f\n", name, bytes.size(), writeMs, loadMs,
+              floatLoadMs);
+}
+
+}  // namespace
+
+int main()
+{
+  utu::PartialData data = bench::syntheticPartials(kPartials, kBreakpoints);
+
+  std::printf("%8s %12s %10s %10s %14s\n", "encoding", "bytes", "write_ms", "load_ms",
+              "float_load_ms");
+  run("text", data, utu::SampleEncoding::Text);
+  run("float64", data, utu::SampleEncoding::Base64Float64);
+  run("float32", data, utu::SampleEncoding::Base64Float32);
+  run("cbor", data, utu::BinaryFormat::Cbor);
+  run("msgpack", data, utu::BinaryFormat::MessagePack);
+
+  return 0;
+}
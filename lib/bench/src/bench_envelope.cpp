@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+// Evaluating every partial at control rate through EnvelopeCursor, against a
+// binary search per query and parameter.
+
+#include <utu/Envelope.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+#include "Bench.h"
+
+namespace
+{
+
+constexpr std::size_t kPartials = 500;
+constexpr std::size_t kBreakpoints = 2000;
+constexpr std::size_t kBlock = 64;
+constexpr double kRate = 1000.0;
+
+double searched(const utu::Partial::Samples& time, const utu::Partial::Samples& values, double t)
+{
+  auto it = std::upper_bound(time.begin(), time.end(), t);
+  if (it == time.begin()) {
+    return values.front();
+  }
+  if (it == time.end()) {
+    return values.back();
+  }
+  auto i = static_cast<std::size_t>(it - time.begin());
+  double alpha = (t - time[i - 1]) / (time[i] - time[i - 1]);
+  return values[i - 1] + alpha * (values[i] - values[i - 1]);
+}
+
+}  // namespace
+
+int main()
+{
+  utu::PartialData data = bench::syntheticPartials(kPartials, kBreakpoints);
+  const char* names[] = {kFrequencyName, kAmplitudeName, kBandwidthName};
+
+  std::vector<double> times(static_cast<std::size_t>(7.0 * kRate));
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    times[i] = static_cast<double>(i) / kRate;
+  }
+
+  std::vector<double> frequency(kBlock);
+  std::vector<double> amplitude(kBlock);
+  std::vector<double> bandwidth(kBlock);
+  double* outputs[] = {frequency.data(), amplitude.data(), bandwidth.data()};
+
+  double sum = 0;
+  double searchMs = bench::medianMs([&] {
+    for (const auto& p : data.partials) {
+      const auto& time = p.parameters.at(kTimeName);
+      for (std::size_t i = 0; i < times.size(); i += kBlock) {
+        std::size_t n = std::min(kBlock, times.size() - i);
+        for (std::size_t k = 0; k < 3; ++k) {
+          const auto& values = p.parameters.at(names[k]);
+          for (std::size_t j = 0; j < n; ++j) {
+            outputs[k][j] = searched(time, values, times[i + j]);
+          }
+        }
+        sum += amplitude[0];
+      }
+    }
+  });
+
+  std::vector<utu::EnvelopeCursor> cursors;
+  for (const auto& p : data.partials) {
+    cursors.emplace_back(p, std::vector<std::string>(std::begin(names), std::end(names)));
+  }
+  double cursorMs = bench::medianMs([&] {
+    for (auto& cursor : cursors) {
+      cursor.reset();
+      for (std::size_t i = 0; i < times.size(); i += kBlock) {
+        cursor.evaluate(times.data() + i, std::min(kBlock, times.size() - i), outputs);
+        sum += amplitude[0];
+      }
+    }
+  });
+
+  double queries = static_cast<double>(kPartials * times.size() * 3);
+  std::printf("%8s %10s %12s\n", "method", "ms", "ns/query");
+  std::printf("%8s %10.1f %12.2f\n", "search", searchMs, 1e6 * searchMs / queries);
+  std::printf("%8s %10.1f %12.2f\n", "cursor", cursorMs, 1e6 * cursorMs / queries);
+  std::printf("(checksum %g)\n", sum);
+
+  return 0;
+}
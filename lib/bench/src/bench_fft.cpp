@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+// Cost of the FFT loris was built against, alone and as part of a complete
+// analysis. Build with each ${PROJECT_NAME}_FFT_BACKEND (system, static,
+// builtin) and compare the results to see the difference between backends.
+
+#include <loris/FourierTransform.h>
+#include <utu/Analysis.h>
+
+#include <cmath>
+#include <cstdio>
+
+#include "Bench.h"
+
+#ifndef UTU_FFT_BACKEND
+#define UTU_FFT_BACKEND "unknown"
+#endif
+
+namespace
+{
+
+constexpr std::size_t kTransformsPerRun = 256;
+
+}  // namespace
+
+int main()
+{
+  std::printf("backend: %s\n\n", UTU_FFT_BACKEND);
+
+  std::printf("%8s %14s\n", "size", "transform_us");
+  for (std::size_t size : {512u, 1024u, 2048u, 4096u, 8192u, 16384u}) {
+    Loris::FourierTransform ft(size);
+    double ms = bench::medianMs([&] {
+      for (std::size_t r = 0; r < kTransformsPerRun; ++r) {
+        for (std::size_t i = 0; i < size; ++i) {
+          ft[i] = std::sin(0.1 * static_cast<double>(i * (r + 1)));
+        }
+        ft.transform();
+      }
+    });
+    std::printf("%8zu %14.2f\n", size, 1000.0 * ms / kTransformsPerRun);
+  }
+
+  std::printf("\n%8s %10s\n", "sr", "analyze_ms");
+  for (double sr : {48000.0, 96000.0}) {
+    std::vector<double> tone = bench::harmonicTone(220, 4000, 2.0, sr);
+    utu::AnalyzeOptions options;
+    options.fundamental = 220;
+    double ms = bench::medianMs([&] { utu::analyze(tone, sr, options); }, 3);
+    std::printf("%8.0f %10.1f\n", sr, ms);
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+// Heap allocation counts and load/free times when reading partial data with
+// the default allocator compared to a monotonic arena.
+
+#include <utu/PartialIO.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <optional>
+#include <string>
+
+#include "Bench.h"
+
+namespace
+{
+
+std::atomic<std::size_t> gAllocations(0);
+
+struct Result {
+  std::size_t allocations;
+  double loadMs;
+  double freeMs;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+Result measure(const std::string& json, bool useArena)
+{
+  Result result;
+
+  auto start = std::chrono::steady_clock::now();
+  std::size_t before = gAllocations.load();
+  std::optional<std::pmr::monotonic_buffer_resource> arena;
+  if (useArena) {
+    // size the first block from the document so most files fit in one chunk
+    arena.emplace(json.size());
+  }
+  std::optional<utu::PartialData> data = utu::PartialReader::read(
+      json, utu::ReadOptions(), arena ? &*arena : std::pmr::get_default_resource());
+  result.allocations = gAllocations.load() - before;
+  result.loadMs = elapsedMs(start);
+
+  start = std::chrono::steady_clock::now();
+  data.reset();
+  arena.reset();
+  result.freeMs = elapsedMs(start);
+
+  return result;
+}
+
+}  // namespace
+
+// count every global allocation, including the aligned forms used by
+// std::pmr::new_delete_resource
+void* operator new(std::size_t size)
+{
+  gAllocations++;
+  if (void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align)
+{
+  gAllocations++;
+  auto alignment = static_cast<std::size_t>(align);
+  if (void* p = std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t /* size */) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t /* align */) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t /* size */, std::align_val_t /* align */) noexcept
+{
+  std::free(p);
+}
+
+int main()
+{
+  std::printf("%9s %12s %8s %13s %10s %10s\n", "partials", "breakpoints", "arena", "allocations",
+              "load_ms", "free_ms");
+
+  constexpr std::size_t kBreakpoints = 64;
+
+  for (std::size_t count : {1000u, 10000u, 50000u}) {
+    std::string json = *utu::PartialWriter::write(bench::syntheticPartials(count, kBreakpoints));
+
+    for (bool useArena : {false, true}) {
+      // discard the first run so both modes start from a warm heap
+      measure(json, useArena);
+      Result r = measure(json, useArena);
+      std::printf("%9zu %12zu %8s %13zu %10.1f %10.1f\n", count, kBreakpoints, useArena ? "yes" : "no",
+                  r.allocations, r.loadMs, r.freeMs);
+    }
+  }
+
+  return 0;
+}
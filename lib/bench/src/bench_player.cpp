@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+// Worst case block render time of PartialPlayer with every voice sounding,
+// against the real time budget of a block.
+//
+//   bench_player [voices] [block_size]
+
+#include <utu/Player.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "Bench.h"
+
+namespace
+{
+
+constexpr std::size_t kPartials = 100;
+constexpr std::size_t kBreakpoints = 1000;
+constexpr double kSampleRate = 48000;
+constexpr double kDuration = 4;
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::size_t voices = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+  std::size_t blockSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256;
+
+  utu::PartialData data = bench::syntheticPartials(kPartials, kBreakpoints);
+  utu::PlayerOptions options;
+  options.sampleRate = kSampleRate;
+  options.voices = voices;
+  options.blockSize = blockSize;
+  utu::PartialPlayer player(data, options);
+
+  // staggered positions and transpositions so voices do not share cursors
+  for (std::size_t v = 0; v < voices; ++v) {
+    utu::VoiceParameters parameters;
+    parameters.position = 0.01 * static_cast<double>(v);
+    parameters.pitchShift = 100.0 * static_cast<double>(v % 12) - 600.0;
+    parameters.timeStretch = 1.0 + 0.05 * static_cast<double>(v % 5);
+    player.noteOn(static_cast<int>(v), parameters, v % blockSize);
+  }
+
+  auto blocks = static_cast<std::size_t>(kDuration * kSampleRate) / blockSize;
+  std::vector<double> output(blockSize);
+  std::vector<double> times;
+  times.reserve(blocks);
+
+  for (std::size_t b = 0; b < blocks; ++b) {
+    if (b == blocks / 2) {
+      player.set(0, utu::VoiceParameter::Position, 0.0, blockSize / 2);
+    }
+    auto start = std::chrono::steady_clock::now();
+    player.render(output.data(), blockSize);
+    auto end = std::chrono::steady_clock::now();
+    times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+
+  std::sort(times.begin(), times.end());
+  double budget = 1e6 * static_cast<double>(blockSize) / kSampleRate;
+  double worst = times.back();
+  std::printf("%8s %8s %10s %10s %10s %10s %8s\n", "voices", "block", "budget_us", "median_us",
+              "p99_us", "worst_us", "load");
+  std::printf("%8zu %8zu %10.1f %10.1f %10.1f %10.1f %8.3f\n", voices, blockSize, budget,
+              times[times.size() / 2], times[times.size() * 99 / 100], worst, worst / budget);
+
+  return 0;
+}
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+// Loading, iterating, and synthesizing the same partials held as double
+// (PartialData) and float (FloatPartialData) samples.
+
+#include <utu/PartialIO.h>
+#include <utu/Synthesis.h>
+
+#include <cstdio>
+#include <string>
+
+#include "Bench.h"
+
+namespace
+{
+
+constexpr std::size_t kPartials = 2000;
+constexpr std::size_t kBreakpoints = 500;
+
+template <typename T>
+std::size_t sampleBytes(const T& data)
+{
+  std::size_t bytes = 0;
+  for (const auto& p : data.partials) {
+    for (const auto& entry : p.parameters) {
+      bytes += entry.second.size() * sizeof(typename T::Partial::Sample);
+    }
+  }
+  return bytes;
+}
+
+// Peak amplitude over all partials, touching every amplitude sample.
+template <typename T>
+double peakAmplitude(const T& data)
+{
+  typename T::Partial::Sample peak = 0;
+  for (const auto& p : data.partials) {
+    for (auto a : p.parameters.at(kAmplitudeName)) {
+      peak = a > peak ? a : peak;
+    }
+  }
+  return static_cast<double>(peak);
+}
+
+template <typename Reader>
+void run(const char* name, const std::string& json)
+{
+  auto data = *Reader::read(json);
+
+  double loadMs = bench::medianMs([&] { Reader::read(json); }, 3);
+  double peak = 0;
+  double iterateMs = bench::medianMs([&] { peak = peakAmplitude(data); });
+  double synthMs = bench::medianMs([&] { utu::synthesize(data); }, 3);
+
+  std::printf("%8s %12zu %10.1f %12.3f %10.1f %8.3f\n", name, sampleBytes(data), loadMs,
+              iterateMs, synthMs, peak);
+}
+
+}  // namespace
+
+int main()
+{
+  std::string json = *utu::PartialWriter::write(bench::syntheticPartials(kPartials, kBreakpoints));
+
+  std::printf("%8s %12s %10s %12s %10s %8s\n", "type", "sample_bytes", "load_ms", "iterate_ms",
+              "synth_ms", "peak");
+  run<utu::PartialReader>("double", json);
+  run<utu::FloatPartialReader>("float", json);
+
+  return 0;
+}
@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <utu/PartialData.h>
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace Loris
+{
+class Analyzer;
+}
+
+namespace utu
+{
+
+// A region of the spectrum analyzed with its own resolution, see
+// AnalyzeOptions::bands.
+struct AnalysisBand {
+  double freqResolution;
+  double windowWidth;
+
+  // Upper edge of the band in Hz, the lower edge is the upper edge of the
+  // previous band. Unset for the highest band which extends to maxFrequency
+  // or the Nyquist frequency.
+  std::optional<double> maxFrequency;
+};
+
+// Analysis configuration, field defaults mirror the defaults of the `utu
+// analyze` command line options.
+struct AnalyzeOptions {
+  double freqResolution = 332;  // --freq-res
+  double windowWidth = 664;     // --window-width
+
+  std::optional<double> freqDrift = 30;     // --freq-drift
+  std::optional<double> freqFloor;          // --freq-floor
+  std::optional<double> ampFloor = -90;     // --amp-floor
+  std::optional<double> hopTime;            // --hop-time
+  std::optional<double> cropTime;           // --crop-time
+  std::optional<double> sidelobeLevel;      // --lobe-level
+  bool phaseCorrect = true;                 // --no-phase-correct
+
+  // Highest frequency of interest, when set the input is low-pass filtered
+  // and decimated to the lowest sample rate which preserves it before
+  // analysis. Times and frequencies still refer to the original input.
+  std::optional<double> maxFrequency;  // --max-freq
+
+  // Split the spectrum into bands analyzed with their own resolution and
+  // window, in place of freqResolution and windowWidth, so low partials can
+  // use long windows without smearing transients in the upper bands. Bands
+  // are in ascending order and analyzed concurrently, each on a copy of the
+  // input decimated to just above its upper edge. Partials tracked by both
+  // bands near an edge are joined into one, taking breakpoints from the band
+  // on their side of the edge. Empty for a single analysis.
+  std::vector<AnalysisBand> bands;  // --band-resolution
+
+  // Threads analyzing bands, 0 for one per core. Bands run one at a time when
+  // concurrentAnalysis() is false.
+  unsigned threads = 0;  // --jobs
+
+  // Partials are channelized against the strongest fundamental found within
+  // +/- 20% of this frequency then distilled; leave unset to skip both steps.
+  std::optional<double> fundamental = 415;
+  double distillFadeTime = 0.001;
+};
+
+// A configured analyzer which can be reused for any number of analyses,
+// avoiding the cost of reconfiguration when processing many sources with the
+// same settings. Instances are not thread safe.
+class Analyzer final
+{
+ public:
+  explicit Analyzer(const AnalyzeOptions& options = {});
+  ~Analyzer();
+
+  Analyzer(const Analyzer&) = delete;
+  Analyzer& operator=(const Analyzer&) = delete;
+
+  const AnalyzeOptions& options() const { return _options; }
+
+  PartialData analyze(const double* samples, std::size_t count, double sampleRate);
+
+  // Update the analysis of a source after [startTime, endTime] was edited.
+  // Only that region, padded by the analysis window on each side, is
+  // analyzed. Partials of previous within the region are replaced and those
+  // crossing its boundaries are cut there and spliced onto new partials which
+  // continue them; everything else is copied unchanged. The header fields of
+  // previous are kept. The region must be within the samples.
+  PartialData reanalyze(const PartialData& previous, const double* samples, std::size_t count,
+                        double sampleRate, double startTime, double endTime);
+
+ private:
+  AnalyzeOptions _options;
+  std::unique_ptr<Loris::Analyzer> _analyzer;
+  std::vector<std::unique_ptr<Loris::Analyzer>> _bandAnalyzers;
+};
+
+// Whether analyses may run on several threads at once. Loris plans its
+// transforms at the start of every analysis which is only thread safe when
+// built against fftw with fftw3_threads; the planner is made thread safe on
+// the first call. When false concurrent analyses must be serialized, the
+// bands of a single analysis already are.
+bool concurrentAnalysis();
+
+// Analyze mono samples at the given sample rate returning the resulting
+// partials with the standard time, frequency, amplitude, bandwidth, and phase
+// parameters.
+PartialData analyze(const double* samples, std::size_t count, double sampleRate,
+                    const AnalyzeOptions& options = {});
+
+inline PartialData analyze(const std::vector<double>& samples, double sampleRate,
+                           const AnalyzeOptions& options = {})
+{
+  return analyze(samples.data(), samples.size(), sampleRate, options);
+}
+
+// See Analyzer::reanalyze; samples is the complete edited source.
+PartialData reanalyze(const PartialData& previous, const double* samples, std::size_t count,
+                      double sampleRate, double startTime, double endTime,
+                      const AnalyzeOptions& options = {});
+
+}  // namespace utu
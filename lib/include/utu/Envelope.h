@@ -0,0 +1,62 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <utu/Partial.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace utu
+{
+
+// Evaluates parameter envelopes of a partial at batches of ascending query
+// times by linear interpolation between breakpoints, holding the first and
+// last values outside the partial.
+//
+// A cursor into the time envelope advances with the queries instead of
+// searching for each one, and persists between calls so consecutive blocks of
+// a playback or modulation stream cost no more than a single pass over the
+// breakpoints. Breakpoint positions are located once per query and shared by
+// every requested parameter; the interpolation itself runs over contiguous
+// arrays and vectorizes. evaluate() does not allocate.
+//
+// The partial must outlive the cursor and not be modified while in use. The
+// frequency envelope of a harmonic partial of relative data holds deviations
+// rather than frequencies, see absoluteFrequencies() in Harmonic.h.
+template <typename SampleType>
+class BasicEnvelopeCursor final
+{
+ public:
+  using Partial = BasicPartial<SampleType>;
+
+  // Parameters are evaluated in the given order; missing parameters evaluate
+  // to 0.
+  BasicEnvelopeCursor(const Partial& partial, const std::vector<std::string>& parameters);
+
+  std::size_t parameterCount() const { return _values.size(); }
+
+  // Evaluate at count ascending times writing parameter k at times[i] to
+  // outputs[k][i]. A batch which starts before the previous one relocates the
+  // cursor with a single search.
+  void evaluate(const double* times, std::size_t count, SampleType* const* outputs);
+
+  // Move the cursor back to the start of the partial.
+  void reset() { _cursor = 0; }
+
+ private:
+  const typename Partial::Samples* _time;
+  std::vector<const SampleType*> _values;
+  std::size_t _size;
+  std::size_t _cursor;
+};
+
+using EnvelopeCursor = BasicEnvelopeCursor<double>;
+using FloatEnvelopeCursor = BasicEnvelopeCursor<float>;
+
+}  // namespace utu
@@ -0,0 +1,59 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace utu
+{
+
+// Evaluation configuration, field defaults mirror the defaults of the `utu
+// evaluate` command line options.
+struct EvaluateOptions {
+  double blockTime = 0.01;     // --block-time, error curve resolution in seconds
+  std::size_t fftSize = 2048;  // --fft-size, a power of two
+
+  // Edges of the spectral error bands in Hz, ascending. When empty octave
+  // bands from 62.5 Hz up to the Nyquist frequency are used.
+  std::vector<double> bandEdges;  // --bands
+
+  // number of threads used to evaluate blocks, 0 uses all cores; results are
+  // identical regardless of the thread count
+  unsigned threads = 0;
+};
+
+// Levels below this are reported as this, in dB
+constexpr double kEvaluationFloorDb = -200;
+
+struct Evaluation {
+  struct Band {
+    double lowFrequency;
+    double highFrequency;
+    double sourceLevel;  // mean source power per frame, dB; for comparing bands
+    double error;        // residual power relative to the source power, dB
+  };
+
+  double snr;  // source power relative to the residual power, dB
+
+  // residual level in dBFS of each consecutive block of blockTime seconds
+  double blockTime;
+  std::vector<double> errorCurve;
+
+  std::vector<Band> bands;
+};
+
+// Compare `count` frames of a rendering against the source they were analyzed
+// from. The residual is the source minus the rendering.
+Evaluation evaluate(const double* source, const double* rendered, std::size_t count,
+                    double sampleRate, const EvaluateOptions& options = {});
+
+// Source power relative to the residual power in dB, the overall SNR of
+// evaluate() without the block and spectral measurements.
+double signalToNoise(const double* source, const double* rendered, std::size_t count);
+
+}  // namespace utu
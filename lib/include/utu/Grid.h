@@ -0,0 +1,58 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <utu/PartialData.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace utu
+{
+
+struct GridOptions {
+  double hop = 0.01;  // --grid, time between frames in seconds
+
+  // Time of the first and last frame; by default from 0 to the end of the
+  // last partial.
+  double startTime = 0;
+  std::optional<double> endTime;
+
+  // number of threads used to fill frames, 0 uses all cores
+  unsigned threads = 0;
+};
+
+// Partials resampled onto a common frame grid as dense, frame major,
+// frames x partials matrices; the value of partial p at frame f is at index
+// f * partials + p. Frame f is at time startTime + f * hop.
+//
+// Frequency, amplitude and bandwidth are linearly interpolated between
+// breakpoints, phase is advanced from the nearest earlier breakpoint by the
+// average frequency. Outside the span of a partial all values are 0 and
+// active is 0.
+struct Grid {
+  std::size_t frames = 0;
+  std::size_t partials = 0;
+  double startTime = 0;
+  double hop = 0;
+
+  std::vector<double> frequency;
+  std::vector<double> amplitude;
+  std::vector<double> bandwidth;
+  std::vector<double> phase;
+  std::vector<std::uint8_t> active;
+};
+
+// Partials without a time envelope are never active; missing frequency,
+// amplitude, bandwidth or phase envelopes read as 0. Harmonic relative data
+// is sampled at absolute frequencies.
+template <typename SampleType>
+Grid grid(const BasicPartialData<SampleType>& data, const GridOptions& options = {});
+
+}  // namespace utu
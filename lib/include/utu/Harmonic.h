@@ -0,0 +1,73 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <utu/PartialData.h>
+
+#include <optional>
+#include <vector>
+
+namespace utu
+{
+
+//
+// Harmonic relative frequencies. Channelized partials are labeled with their
+// harmonic number k and their frequencies lie close to k times a fundamental
+// shared by every harmonic. In the relative form the fundamental track is
+// stored once, in PartialDataHeader::fundamental, and the frequency envelope
+// of each harmonic partial holds its deviation d relative to it:
+//
+//   frequency = k * f0(time) * (1 + d)
+//
+// where f0 is linearly interpolated between the breakpoints of the track and
+// held beyond them. Deviations are small and change slowly so they compress
+// far better than absolute frequencies, and scaling the track transposes every
+// harmonic at once. Partials which are unlabeled, or labeled with anything
+// other than a positive integer, keep absolute frequencies.
+//
+// Readers restore absolute frequencies unless asked not to, see
+// ReadOptions::harmonicRelative. Synthesis, grids, analysis updates and the
+// Loris conversions restore them as they go; the player and envelope cursors
+// read envelopes in place and require absolute data.
+//
+
+// Default time between breakpoints of an estimated fundamental track.
+constexpr double kFundamentalHopTime = 0.005;
+
+// The harmonic number of a partial, its label when that is a positive integer.
+template <typename SampleType>
+std::optional<unsigned> harmonicNumber(const BasicPartial<SampleType>& partial);
+
+// Estimate the fundamental track as the amplitude weighted mean of
+// frequency / k over the harmonic partials every hopTime seconds, then store
+// the frequencies of harmonic partials relative to it. Data which is already
+// relative, or has no harmonic partials, is left unchanged.
+template <typename SampleType>
+void makeHarmonicRelative(BasicPartialData<SampleType>& data,
+                          double hopTime = kFundamentalHopTime);
+
+// Restore absolute frequencies and remove the fundamental track. Throws
+// std::invalid_argument if a harmonic partial has a frequency envelope but no
+// time envelope.
+template <typename SampleType>
+void makeHarmonicAbsolute(BasicPartialData<SampleType>& data);
+
+// Scale every frequency by 2^(cents / 1200). In the relative form only the
+// fundamental track and the partials which are not harmonic are scaled, the
+// deviations of the harmonics are left as they are.
+template <typename SampleType>
+void transpose(BasicPartialData<SampleType>& data, double cents);
+
+// The absolute frequencies of a partial of harmonic relative data without
+// modifying it. Returns false, leaving frequencies unchanged, if the partial
+// is not harmonic or lacks a time or frequency envelope.
+template <typename SampleType>
+bool absoluteFrequencies(const PartialDataHeader::Fundamental& fundamental,
+                         const BasicPartial<SampleType>& partial,
+                         std::vector<double>& frequencies);
+
+}  // namespace utu
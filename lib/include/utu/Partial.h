@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory_resource>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -20,12 +22,87 @@ constexpr char kPhaseName[] = "phase";
 namespace utu
 {
 
-struct Partial {
-  using Samples = std::vector<double>;
-  using Parameters = std::unordered_map<std::string, Samples>;
+// Envelopes and their map nodes are allocated from the memory resource given at
+// construction, which is propagated when partials are stored in a PartialData.
+// Since 0.2.0 Samples and Parameters are std::pmr containers rather than
+// std::vector and std::unordered_map, which breaks the API and ABI of code
+// naming the std types; see toStdSamples() and friends below to convert.
+// Labels and parameter names are short enough to fit in the small string
+// buffer so they remain plain strings.
+//
+// Envelope samples are of SampleType; see Partial and FloatPartial.
+template <typename SampleType>
+struct BasicPartial {
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+  using Sample = SampleType;
+  using Samples = std::pmr::vector<SampleType>;
+  using Parameters = std::pmr::unordered_map<std::string, Samples>;
+
+  BasicPartial() = default;
+  explicit BasicPartial(const allocator_type& alloc) : parameters(alloc) {}
+  BasicPartial(const BasicPartial& other, const allocator_type& alloc)
+      : label(other.label), parameters(other.parameters, alloc)
+  {
+  }
+  BasicPartial(BasicPartial&& other, const allocator_type& alloc)
+      : label(std::move(other.label)), parameters(std::move(other.parameters), alloc)
+  {
+  }
+
+  BasicPartial(const BasicPartial&) = default;
+  BasicPartial(BasicPartial&&) = default;
+  BasicPartial& operator=(const BasicPartial&) = default;
+  BasicPartial& operator=(BasicPartial&&) = default;
 
   std::optional<std::string> label;
   Parameters parameters;
 };
 
+// Conversions between envelopes and the std containers used before 0.2.0.
+// Envelopes converted from std containers use the given memory resource.
+template <typename SampleType>
+std::vector<SampleType> toStdSamples(const std::pmr::vector<SampleType>& samples)
+{
+  return {samples.begin(), samples.end()};
+}
+
+template <typename SampleType>
+std::pmr::vector<SampleType> toSamples(
+    const std::vector<SampleType>& samples,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+  return std::pmr::vector<SampleType>(samples.begin(), samples.end(), resource);
+}
+
+template <typename SampleType>
+std::unordered_map<std::string, std::vector<SampleType>> toStdParameters(
+    const typename BasicPartial<SampleType>::Parameters& parameters)
+{
+  std::unordered_map<std::string, std::vector<SampleType>> result;
+  for (const auto& [name, samples] : parameters) {
+    result.emplace(name, toStdSamples(samples));
+  }
+  return result;
+}
+
+template <typename SampleType>
+typename BasicPartial<SampleType>::Parameters toParameters(
+    const std::unordered_map<std::string, std::vector<SampleType>>& parameters,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+  typename BasicPartial<SampleType>::Parameters result(resource);
+  for (const auto& [name, samples] : parameters) {
+    result.emplace(name, toSamples(samples, resource));
+  }
+  return result;
+}
+
+// Double precision samples, as produced by analysis.
+using Partial = BasicPartial<double>;
+
+// Single precision samples, half the memory and bandwidth of Partial. Times
+// keep about a microsecond of resolution over the first ten seconds and
+// proportionally less after.
+using FloatPartial = BasicPartial<float>;
+
 }  // namespace utu
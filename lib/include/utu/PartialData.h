@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <cstddef>
+#include <memory_resource>
 #include <optional>
 #include <string>
 #include <unordered_map>
@@ -16,21 +18,58 @@
 namespace utu
 {
 
-struct PartialData {
+// The fields of partial data which do not depend on the sample type.
+struct PartialDataHeader {
   using Parameters = std::vector<std::string>;
-  using Partials = std::vector<Partial>;
 
   struct Source {
     std::string location;
     std::optional<std::string> fingerprint;
   };
 
+  // A named point in time such as an onset, as found in SDIF files.
+  struct Marker {
+    double time;
+    std::string name;
+  };
+  using Markers = std::vector<Marker>;
+
+  // Fundamental frequency track of harmonic relative data, see Harmonic.h.
+  struct Fundamental {
+    std::vector<double> time;
+    std::vector<double> frequency;
+  };
+
   std::optional<std::string> description;
   std::optional<Source> source;
+  Markers markers;
+
+  // When present the frequency envelopes of harmonic partials are relative
+  // to it; absent for absolute frequencies.
+  std::optional<Fundamental> fundamental;
 
   Parameters parameters;
+};
+
+// Partials are allocated from the memory resource given at construction so
+// that a large file can be loaded into an arena and released in one step. The
+// resource must outlive the data; copies use the default resource.
+template <typename SampleType>
+struct BasicPartialData : PartialDataHeader {
+  using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+  using Partial = BasicPartial<SampleType>;
+  using Partials = std::pmr::vector<Partial>;
+
   Partials partials;
 
+  BasicPartialData() = default;
+  explicit BasicPartialData(const allocator_type& alloc) : partials(alloc) {}
+
+  BasicPartialData(const BasicPartialData&) = default;
+  BasicPartialData(BasicPartialData&&) = default;
+  BasicPartialData& operator=(const BasicPartialData&) = default;
+  BasicPartialData& operator=(BasicPartialData&&) = default;
+
   bool push_back(Partial& partial)
   {
     // Ensure the incoming partial has all the expected parameters
@@ -44,4 +83,38 @@ struct PartialData {
   }
 };
 
+using PartialData = BasicPartialData<double>;
+using FloatPartialData = BasicPartialData<float>;
+
+// Convert count samples between precisions. A plain loop over contiguous
+// memory so the compiler emits packed conversions.
+template <typename To, typename From>
+void convertSamples(const From* in, std::size_t count, To* out)
+{
+  for (std::size_t i = 0; i < count; ++i) {
+    out[i] = static_cast<To>(in[i]);
+  }
+}
+
+// Copy partial data converting the samples to the precision of To, for
+// example to a FloatPartialData once analysis is complete.
+template <typename To, typename From>
+BasicPartialData<To> convert(const BasicPartialData<From>& data,
+                             const typename BasicPartialData<To>::allocator_type& alloc = {})
+{
+  BasicPartialData<To> result(alloc);
+  static_cast<PartialDataHeader&>(result) = data;
+  result.partials.reserve(data.partials.size());
+  for (const auto& p : data.partials) {
+    auto& q = result.partials.emplace_back();
+    q.label = p.label;
+    for (const auto& [name, samples] : p.parameters) {
+      auto& converted = q.parameters[name];
+      converted.resize(samples.size());
+      convertSamples(samples.data(), samples.size(), converted.data());
+    }
+  }
+  return result;
+}
+
 }  // namespace utu
\ No newline at end of file
@@ -8,18 +8,115 @@
 
 #include <utu/PartialData.h>
 
+#include <cstdint>
 #include <iostream>
+#include <map>
+#include <memory_resource>
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace utu
 {
 
+// Selects the subset of partial data to load. Anything excluded is skipped
+// while parsing rather than loaded and then discarded.
+struct ReadOptions {
+  // names of the parameters to load, all parameters when empty
+  std::vector<std::string> parameters;
+
+  // labels of the partials to load, all partials (labeled or not) when empty
+  std::vector<std::string> labels;
+
+  // only load partials which overlap the time range
+  std::optional<double> startTime;
+  std::optional<double> endTime;
+
+  // only load partials whose amplitude reaches this level
+  std::optional<double> minPeakAmplitude;
+
+  // keep the frequencies of harmonic partials relative to the fundamental
+  // track of documents which store them that way, rather than restoring
+  // absolute frequencies; see Harmonic.h
+  bool harmonicRelative = false;
+};
+
+// Encoding of envelope samples in the JSON format. Readers detect the encoding
+// from the file_info of the document.
+enum class SampleEncoding {
+  // arrays of numbers
+  Text,
+  // base64 strings of little endian float64 or float32 samples; documents
+  // remain valid JSON but load at close to the speed of a binary format
+  Base64Float64,
+  Base64Float32,
+};
+
+struct WriteOptions {
+  // number of threads used to serialize large documents, 0 uses all cores;
+  // the output is identical regardless of the thread count
+  unsigned threads = 0;
+
+  SampleEncoding encoding = SampleEncoding::Text;
+
+  // store a Summary of the data in the file_info
+  bool summary = true;
+
+  // store the frequencies of harmonic partials relative to an estimated
+  // fundamental track, see makeHarmonicRelative(); data which is already
+  // relative is written as is
+  bool harmonicRelative = false;
+};
+
+// Totals and bounds of partial data. Writers store one in the file_info so
+// files can be inspected with PartialHeaderReader without reading the
+// partials.
+struct Summary {
+  struct Range {
+    double min;
+    double max;
+  };
+
+  std::size_t partials = 0;
+  std::size_t breakpoints = 0;  // time samples over all partials
+
+  // smallest and largest sample of each parameter with samples; the time
+  // range is the span of the data and the frequency range is absolute for
+  // harmonic relative data
+  std::map<std::string, Range> ranges;
+
+  // of the source, which follows the partials in documents
+  std::optional<std::string> fingerprint;
+};
+
+template <typename T>
+Summary summarize(const T& data);
+
+// Binary encodings of the JSON document, conventionally ".cbor" and
+// ".msgpack". Envelopes are plain byte strings (CBOR byte strings, MessagePack
+// bin) of little endian samples in the precision of the data, which the file
+// info encoding gives as "float64le" or "float32le". No tags or extension
+// types are used so any CBOR or MessagePack decoder reads the documents.
+enum class BinaryFormat { Cbor, MessagePack };
+
 template <typename T>
 struct Reader {
   using ValueType = T;
   static std::optional<T> read(const std::string& jsonData);
   static std::optional<T> read(std::istream& is);
+  static std::optional<T> read(const std::string& jsonData, const ReadOptions& options);
+  static std::optional<T> read(std::istream& is, const ReadOptions& options);
+
+  // Allocate the result from the given memory resource, which must outlive it.
+  static std::optional<T> read(const std::string& jsonData, const ReadOptions& options,
+                               std::pmr::memory_resource* resource);
+  static std::optional<T> read(std::istream& is, const ReadOptions& options,
+                               std::pmr::memory_resource* resource);
+
+  static std::optional<T> read(const std::vector<std::uint8_t>& data, BinaryFormat format,
+                               const ReadOptions& options = {});
+  static std::optional<T> read(std::istream& is, BinaryFormat format,
+                               const ReadOptions& options = {});
 };
 
 template <typename T>
@@ -27,9 +124,108 @@ struct Writer {
   using ValueType = T;
   static std::optional<std::string> write(const T& value);
   static void write(const T& value, std::ostream& os);
+  static std::optional<std::string> write(const T& value, const WriteOptions& options);
+  static void write(const T& value, std::ostream& os, const WriteOptions& options);
+
+  // Samples are always binary, other than text the encoding option throws
+  // std::invalid_argument.
+  static std::vector<std::uint8_t> write(const T& value, BinaryFormat format,
+                                         const WriteOptions& options = {});
+  static void write(const T& value, std::ostream& os, BinaryFormat format,
+                    const WriteOptions& options = {});
 };
 
+// Implemented for PartialData and FloatPartialData; floats are written with
+// the shortest representation which reads back to the same float.
 typedef Reader<PartialData> PartialReader;
 typedef Writer<PartialData> PartialWriter;
+typedef Reader<FloatPartialData> FloatPartialReader;
+typedef Writer<FloatPartialData> FloatPartialWriter;
+
+// The fields of a document preceding its partials.
+struct PartialHeader {
+  std::string kind;
+  std::uint16_t version = 0;
+
+  // description, markers and parameters; the source follows the partials so
+  // is only present for line delimited files
+  PartialDataHeader fields;
+
+  // when stored by the writer
+  std::optional<Summary> summary;
+};
+
+// Parses a document, or the first line of a line delimited file, up to the
+// start of the partials and stops.
+struct PartialHeaderReader {
+  static std::optional<PartialHeader> read(std::istream& is);
+  static std::optional<PartialHeader> read(std::istream& is, BinaryFormat format);
+};
+
+//
+// Newline delimited variant of the JSON format, conventionally ".utul". The
+// first line holds the file_info, description, source and parameters; every
+// following line holds a single partial. Files can be appended to a partial at
+// a time and the lines are parsed in parallel.
+//
+
+struct PartialLineReader {
+  static std::optional<PartialData> read(std::istream& is);
+  // threads is the number of threads used to parse large files, 0 uses all
+  // cores
+  static std::optional<PartialData> read(std::istream& is, const ReadOptions& options,
+                                         unsigned threads = 0);
+  static std::optional<PartialData> read(const std::string& lineData, const ReadOptions& options,
+                                         unsigned threads = 0);
+};
+
+class PartialLineWriter final
+{
+ public:
+  // Begin a document with the header fields of data; its partials are not
+  // written.
+  PartialLineWriter(std::ostream& os, const PartialData& header);
+
+  // Append to a document previously started on the stream.
+  explicit PartialLineWriter(std::ostream& os);
+
+  void append(const Partial& partial);
+
+  // The header includes a Summary of data unless disabled. Lines are always
+  // text, other encodings throw std::invalid_argument.
+  static void write(const PartialData& data, std::ostream& os, const WriteOptions& options = {});
+
+ private:
+  void _writeHeader(const PartialData& header, const std::optional<Summary>& summary);
+
+  std::ostream& _os;
+};
+
+//
+// SDIF files holding "RBEP" reassigned bandwidth-enhanced partials, as written
+// by Loris, or standard "1TRC" sinusoidal tracks. Frames are read one at a
+// time; an index which reappears after its track ended starts a new partial.
+// Partial labels are carried in an "RBEL" matrix and markers in an "RBEM"
+// frame; SDIF labels are integers so labels which are not numeric are
+// dropped.
+//
+
+struct PartialSdifReader {
+  static std::optional<PartialData> read(std::istream& is);
+};
+
+struct PartialSdifWriter {
+  enum class Type {
+    // "RBEP" frames including bandwidth (noise) and exact breakpoint times
+    BandwidthEnhanced,
+    // "1TRC" frames spaced by the median interval between breakpoints, each
+    // listing every live partial with interpolated parameters; bandwidth is
+    // discarded
+    Sinusoidal,
+  };
+
+  static void write(const PartialData& data, std::ostream& os,
+                    Type type = Type::BandwidthEnhanced);
+};
 
 }  // namespace utu
\ No newline at end of file
@@ -0,0 +1,136 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <utu/Envelope.h>
+#include <utu/PartialData.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace utu
+{
+
+struct PlayerOptions {
+  double sampleRate = 44100;
+  std::size_t voices = 16;      // simultaneous notes, the oldest is stolen when exceeded
+  std::size_t blockSize = 512;  // frames rendered per internal block
+  std::size_t events = 256;     // capacity of the event queue between renders
+  double rampTime = 0.005;      // voice fade in and release time in seconds
+};
+
+// Playback parameters of a voice; see SynthOptions for the equivalent offline
+// transforms.
+struct VoiceParameters {
+  double position = 0;     // source time in seconds at which playback starts
+  double pitchShift = 0;   // in cents
+  double timeStretch = 1;  // factor applied to source times
+  double gain = 0;         // in dB
+};
+
+enum class VoiceParameter { Position, PitchShift, TimeStretch, Gain };
+
+// Plays the same partials as any number of simultaneous voices, for using an
+// analysis as an instrument.
+//
+// Voices, their oscillator state, the event queue and all scratch buffers are
+// allocated at construction; queueing events and render() neither allocate
+// nor lock. The player is not internally synchronized so events must be
+// queued from the thread calling render(), typically the audio callback.
+//
+// A stolen voice is released over the ramp time while its replacement fades
+// in on another voice, so twice the number of voices are allocated. Only
+// when every voice is busy is the quietest releasing one cut short.
+//
+// Events take effect at a frame offset into the next render() call, offsets
+// beyond it carry over to later calls. Voices are rendered as sinusoids with
+// linearly interpolated frequency and amplitude, starting at zero phase;
+// bandwidth and phase envelopes are not used.
+//
+// The partial data must outlive the player and not be modified while in use.
+// Voices read its envelopes in place so harmonic relative data, see
+// Harmonic.h, is rejected with std::invalid_argument.
+template <typename SampleType>
+class BasicPartialPlayer final
+{
+ public:
+  using Data = BasicPartialData<SampleType>;
+
+  explicit BasicPartialPlayer(const Data& data, const PlayerOptions& options = {});
+
+  const PlayerOptions& options() const { return _options; }
+
+  // Start a voice tagged with id. Returns false when the event queue is full.
+  bool noteOn(int id, const VoiceParameters& parameters = {}, std::size_t offset = 0);
+
+  // Release every voice tagged with id.
+  bool noteOff(int id, std::size_t offset = 0);
+
+  // Change a parameter of every voice tagged with id.
+  bool set(int id, VoiceParameter parameter, double value, std::size_t offset = 0);
+
+  // Render frames to output, replacing its contents.
+  void render(double* output, std::size_t frames);
+
+  std::size_t activeVoices() const;
+
+ private:
+  struct Event {
+    enum class Type { NoteOn, NoteOff, Set };
+
+    std::size_t offset;
+    Type type;
+    int id;
+    VoiceParameters parameters;
+    VoiceParameter parameter;
+    double value;
+  };
+
+  struct Voice {
+    bool active = false;
+    bool releasing = false;
+    int id = 0;
+    std::uint64_t serial = 0;
+
+    double position = 0;  // source time of the next frame
+    double step = 0;      // source time per frame
+    double ratio = 1;     // frequency ratio
+    double gain = 1;
+    double level = 0;  // fade in and release ramp
+
+    std::vector<double> phases;
+    std::vector<BasicEnvelopeCursor<SampleType>> cursors;
+  };
+
+  bool _queue(const Event& event);
+  void _apply(const Event& event);
+  void _set(Voice& voice, VoiceParameter parameter, double value) const;
+  void _renderVoice(Voice& voice, double* output, std::size_t frames);
+
+  PlayerOptions _options;
+  double _rampStep;
+  std::uint64_t _serial;
+
+  // span of each partial in source time
+  std::vector<double> _startTimes;
+  std::vector<double> _endTimes;
+  double _endTime;
+
+  std::vector<Voice> _voices;
+  std::vector<Event> _events;  // ordered by offset
+
+  std::vector<double> _times;
+  std::vector<double> _levels;
+  std::vector<SampleType> _frequency;
+  std::vector<SampleType> _amplitude;
+};
+
+using PartialPlayer = BasicPartialPlayer<double>;
+using FloatPartialPlayer = BasicPartialPlayer<float>;
+
+}  // namespace utu
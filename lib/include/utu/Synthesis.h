@@ -0,0 +1,50 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#pragma once
+
+#include <utu/PartialData.h>
+
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace utu
+{
+
+// Synthesis configuration, field defaults mirror the defaults of the `utu
+// synth` command line options.
+//
+// Each partial is converted into one transformed Loris::Partial at a time
+// which is rendered before the next is converted, the source data is never
+// modified.
+struct SynthOptions {
+  double sampleRate = 44100;             // --sample-rate
+  double pitchShift = 0;                 // --pitch-shift, in cents
+  double frequencyScale = 1;             // --freq-scale, applied with pitchShift
+  double timeStretch = 1;                // --time-stretch, factor applied to times
+  double gain = 0;                       // --gain, in dB
+  std::vector<std::string> mutedLabels;  // --mute, partials to leave out
+  std::optional<double> fadeTime;        // partial fade in/out time in seconds
+};
+
+// Render the partials to a mono buffer; the buffer length is determined by
+// the end time of the last partial. Harmonic relative frequencies are
+// restored as each partial is rendered. Every partial which is not muted must
+// have time, frequency and amplitude envelopes, and all of its envelopes must
+// have the same length, otherwise std::invalid_argument is thrown; missing
+// bandwidth and phase are zero.
+std::vector<double> synthesize(const PartialData& data, const SynthOptions& options = {});
+std::vector<double> synthesize(const FloatPartialData& data, const SynthOptions& options = {});
+
+// Render the partials into the caller provided buffer, output beyond `count`
+// frames is discarded and any remaining frames are zeroed. Returns the full
+// length of the rendering in frames.
+std::size_t synthesize(const PartialData& data, const SynthOptions& options, double* output,
+                       std::size_t count);
+
+}  // namespace utu
@@ -6,6 +6,13 @@
 
 #pragma once
 
+#include <utu/Analysis.h>
+#include <utu/Envelope.h>
+#include <utu/Evaluation.h>
+#include <utu/Grid.h>
+#include <utu/Harmonic.h>
 #include <utu/Partial.h>
 #include <utu/PartialData.h>
-#include <utu/PartialIO.h>
\ No newline at end of file
+#include <utu/PartialIO.h>
+#include <utu/Player.h>
+#include <utu/Synthesis.h>
\ No newline at end of file
@@ -0,0 +1,267 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include <loris/Analyzer.h>
+#include <loris/Channelizer.h>
+#include <loris/Distiller.h>
+#include <loris/FrequencyReference.h>
+#include <loris/KaiserWindow.h>
+#include <samplerate.h>
+#include <utu/Analysis.h>
+#include <utu/Harmonic.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#ifdef UTU_HAVE_FFTW_THREADS
+#include <fftw3.h>
+#endif
+
+#include "Marshal.h"
+#include "Parallel.h"
+#include "Splice.h"
+
+namespace
+{
+
+// Fraction of the decimated Nyquist frequency which the resampler passes
+// without attenuation, the remainder is the filter transition band.
+constexpr double kDecimationPassband = 0.9;
+
+// Returns the decimated sample rate needed to preserve content up to
+// maxFrequency, or no value if the input rate is already at or below it.
+std::optional<double> _decimatedRate(double sampleRate, double maxFrequency)
+{
+  double rate = std::ceil(2.0 * maxFrequency / kDecimationPassband);
+  if (rate >= sampleRate) {
+    return {};
+  }
+  return rate;
+}
+
+std::vector<double> _decimate(const double* samples, std::size_t count, double ratio)
+{
+  // NOTE: libsamplerate only operates on single precision samples
+  std::vector<float> input(samples, samples + count);
+  std::vector<float> output(static_cast<std::size_t>(std::ceil(static_cast<double>(count) * ratio)));
+
+  SRC_DATA params;
+  params.data_in = input.data();
+  params.data_out = output.data();
+  params.input_frames = static_cast<long>(input.size());
+  params.output_frames = static_cast<long>(output.size());
+  params.src_ratio = ratio;
+
+  int status = src_simple(&params, SRC_SINC_BEST_QUALITY, 1);
+  if (status != 0) {
+    throw std::runtime_error(std::string("decimation failed: ") + src_strerror(status));
+  }
+
+  return std::vector<double>(output.begin(), output.begin() + params.output_frames_gen);
+}
+
+// Bands are decimated this fraction above their upper edge so partials near
+// the edge are resolved by both neighbours and can be deduplicated.
+constexpr double kBandOverlap = 0.1;
+
+std::unique_ptr<Loris::Analyzer> _makeAnalyzer(const utu::AnalyzeOptions& options,
+                                               double freqResolution, double windowWidth)
+{
+  auto analyzer = std::make_unique<Loris::Analyzer>(freqResolution, windowWidth);
+  if (options.freqDrift) {
+    analyzer->setFreqDrift(*options.freqDrift);
+  }
+  if (options.freqFloor) {
+    analyzer->setFreqFloor(*options.freqFloor);
+  }
+  if (options.ampFloor) {
+    analyzer->setAmpFloor(*options.ampFloor);
+  }
+  if (options.hopTime) {
+    analyzer->setHopTime(*options.hopTime);
+  }
+  if (options.cropTime) {
+    analyzer->setCropTime(*options.cropTime);
+  }
+  if (options.sidelobeLevel) {
+    analyzer->setSidelobeLevel(*options.sidelobeLevel);
+  }
+  analyzer->setPhaseCorrect(options.phaseCorrect);
+  return analyzer;
+}
+
+// Analyze with the input decimated to preserve content up to maxFrequency
+Loris::PartialList _analyze(Loris::Analyzer& analyzer, const double* samples, std::size_t count,
+                            double sampleRate, std::optional<double> maxFrequency)
+{
+  std::vector<double> decimated;
+  if (maxFrequency) {
+    if (auto rate = _decimatedRate(sampleRate, *maxFrequency)) {
+      decimated = _decimate(samples, count, *rate / sampleRate);
+      samples = decimated.data();
+      count = decimated.size();
+      sampleRate = *rate;
+    }
+  }
+  return analyzer.analyze(samples, samples + count, sampleRate);
+}
+
+}  // namespace
+
+namespace utu
+{
+
+bool concurrentAnalysis()
+{
+#ifdef UTU_HAVE_FFTW_THREADS
+  static std::once_flag once;
+  std::call_once(once, [] { fftw_make_planner_thread_safe(); });
+  return true;
+#else
+  return false;
+#endif
+}
+
+Analyzer::Analyzer(const AnalyzeOptions& options)
+    : _options(options),
+      _analyzer(_makeAnalyzer(options, options.freqResolution, options.windowWidth))
+{
+  double edge = 0;
+  for (std::size_t i = 0; i < options.bands.size(); ++i) {
+    const AnalysisBand& band = options.bands[i];
+    if (!(band.freqResolution > 0 && band.windowWidth > 0)) {
+      throw std::invalid_argument("band resolution and window width must be greater than 0");
+    }
+    if (band.maxFrequency) {
+      if (!(*band.maxFrequency > edge)) {
+        throw std::invalid_argument("band edges must be ascending and greater than 0");
+      }
+      edge = *band.maxFrequency;
+    } else if (i + 1 < options.bands.size()) {
+      throw std::invalid_argument("only the highest band may omit its upper edge");
+    }
+    _bandAnalyzers.push_back(_makeAnalyzer(options, band.freqResolution, band.windowWidth));
+  }
+}
+
+Analyzer::~Analyzer() = default;
+
+PartialData Analyzer::analyze(const double* samples, std::size_t count, double sampleRate)
+{
+  Loris::PartialList partials;
+  if (_bandAnalyzers.empty()) {
+    partials = _analyze(*_analyzer, samples, count, sampleRate, _options.maxFrequency);
+  } else {
+    const auto& bands = _options.bands;
+    std::vector<BandPartials> found(bands.size());
+    unsigned threads = concurrentAnalysis() ? _options.threads : 1;
+    parallelFor(bands.size(), threads, [&](std::size_t i) {
+      BandPartials& band = found[i];
+      band.lower = i == 0 ? 0.0 : *bands[i - 1].maxFrequency;
+      band.upper = bands[i].maxFrequency.value_or(std::numeric_limits<double>::infinity());
+      band.freqResolution = bands[i].freqResolution;
+
+      std::optional<double> maxFrequency = _options.maxFrequency;
+      if (bands[i].maxFrequency) {
+        double limit = band.upper * (1.0 + kBandOverlap);
+        maxFrequency = maxFrequency ? std::min(*maxFrequency, limit) : limit;
+      }
+
+      Loris::PartialList list =
+          _analyze(*_bandAnalyzers[i], samples, count, sampleRate, maxFrequency);
+      band.partials = Marshal::from(list).partials;
+    });
+
+    PartialData merged;
+    merged.partials = mergeBands(found, kBandOverlap);
+    partials = Marshal::from(merged);
+  }
+
+  if (_options.fundamental) {
+    double f = *_options.fundamental;
+    Loris::FrequencyReference partialsRef(partials.begin(), partials.end(), f * 0.8, f * 1.2, 50);
+    Loris::Channelizer::channelize(partials, partialsRef, 1);
+    Loris::Distiller::distill(partials, _options.distillFadeTime);
+  }
+
+  return Marshal::from(partials);
+}
+
+PartialData Analyzer::reanalyze(const PartialData& previous, const double* samples,
+                                std::size_t count, double sampleRate, double startTime,
+                                double endTime)
+{
+  if (!(startTime <= endTime)) {
+    throw std::invalid_argument("reanalysis region must not end before it starts");
+  }
+  if (!(startTime >= 0 && endTime <= static_cast<double>(count) / sampleRate)) {
+    throw std::invalid_argument("reanalysis region must be within the samples");
+  }
+  if (previous.fundamental) {
+    PartialData absolute = previous;
+    makeHarmonicAbsolute(absolute);
+    return reanalyze(absolute, samples, count, sampleRate, startTime, endTime);
+  }
+
+  // the analysis window reaches this far either side of a breakpoint so
+  // breakpoints within the region only depend on samples within the padding;
+  // with bands the narrowest window width gives the longest window
+  std::vector<Loris::Analyzer*> analyzers;
+  if (_bandAnalyzers.empty()) {
+    analyzers.push_back(_analyzer.get());
+  }
+  for (auto& a : _bandAnalyzers) {
+    analyzers.push_back(a.get());
+  }
+  double window = 0;
+  double hopTime = 0;
+  for (auto* a : analyzers) {
+    double shape = Loris::KaiserWindow::computeShape(a->sidelobeLevel());
+    double length = static_cast<double>(
+                        Loris::KaiserWindow::computeLength(a->windowWidth() / sampleRate, shape)) /
+                    sampleRate;
+    window = std::max(window, length);
+    hopTime = std::max(hopTime, a->hopTime());
+  }
+
+  auto frame = [&](double t) {
+    return static_cast<std::size_t>(std::clamp(t * sampleRate, 0.0, static_cast<double>(count)));
+  };
+  std::size_t first = frame(startTime - window);
+  std::size_t last = frame(endTime + window);
+  double offset = static_cast<double>(first) / sampleRate;
+
+  PartialData region = analyze(samples + first, last - first, sampleRate);
+  for (auto& p : region.partials) {
+    for (auto& time : p.parameters[kTimeName]) {
+      time += offset;
+    }
+  }
+
+  double maxGap = hopTime + 1.0 / sampleRate;
+  return spliceRegion(previous, region.partials, startTime, endTime, maxGap,
+                      _analyzer->freqDrift());
+}
+
+PartialData analyze(const double* samples, std::size_t count, double sampleRate,
+                    const AnalyzeOptions& options)
+{
+  Analyzer a(options);
+  return a.analyze(samples, count, sampleRate);
+}
+
+PartialData reanalyze(const PartialData& previous, const double* samples, std::size_t count,
+                      double sampleRate, double startTime, double endTime,
+                      const AnalyzeOptions& options)
+{
+  Analyzer a(options);
+  return a.reanalyze(previous, samples, count, sampleRate, startTime, endTime);
+}
+
+}  // namespace utu
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "Base64.h"
+
+namespace
+{
+
+constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Characters outside the alphabet map to a value with the high bit set; the
+// decoder ORs every looked up value together and checks the bit once at the
+// end rather than branching on each character.
+constexpr std::uint8_t kInvalid = 0xff;
+
+struct _DecodeTable {
+  std::uint8_t values[256];
+
+  constexpr _DecodeTable() : values()
+  {
+    for (auto& v : values) {
+      v = kInvalid;
+    }
+    for (std::uint8_t i = 0; i < 64; ++i) {
+      values[static_cast<std::uint8_t>(kAlphabet[i])] = i;
+    }
+  }
+};
+
+constexpr _DecodeTable kDecode;
+
+}  // namespace
+
+namespace utu
+{
+
+void base64Encode(const std::uint8_t* data, std::size_t size, std::string& out)
+{
+  std::size_t offset = out.size();
+  out.resize(offset + (size + 2) / 3 * 4);
+  char* dst = out.data() + offset;
+
+  std::size_t whole = size - size % 3;
+  for (std::size_t i = 0; i < whole; i += 3) {
+    std::uint32_t v = static_cast<std::uint32_t>(data[i]) << 16 |
+                      static_cast<std::uint32_t>(data[i + 1]) << 8 | data[i + 2];
+    dst[0] = kAlphabet[v >> 18];
+    dst[1] = kAlphabet[(v >> 12) & 0x3f];
+    dst[2] = kAlphabet[(v >> 6) & 0x3f];
+    dst[3] = kAlphabet[v & 0x3f];
+    dst += 4;
+  }
+
+  if (whole < size) {
+    std::uint32_t v = static_cast<std::uint32_t>(data[whole]) << 16;
+    if (whole + 1 < size) {
+      v |= static_cast<std::uint32_t>(data[whole + 1]) << 8;
+    }
+    dst[0] = kAlphabet[v >> 18];
+    dst[1] = kAlphabet[(v >> 12) & 0x3f];
+    dst[2] = whole + 1 < size ? kAlphabet[(v >> 6) & 0x3f] : '=';
+    dst[3] = '=';
+  }
+}
+
+bool base64Decode(std::string_view text, std::vector<std::uint8_t>& out)
+{
+  std::size_t length = text.size();
+  if (length % 4 != 0) {
+    return false;
+  }
+
+  std::size_t padding = 0;
+  if (length > 0 && text[length - 1] == '=') {
+    padding = text[length - 2] == '=' ? 2 : 1;
+  }
+  out.resize(length / 4 * 3 - padding);
+
+  const auto* in = reinterpret_cast<const std::uint8_t*>(text.data());
+  std::uint8_t* dst = out.data();
+  std::uint8_t invalid = 0;
+
+  // every quad but a padded last one decodes to three whole bytes
+  std::size_t quads = length / 4 - (padding ? 1 : 0);
+  for (std::size_t q = 0; q < quads; ++q) {
+    std::uint8_t a = kDecode.values[in[0]];
+    std::uint8_t b = kDecode.values[in[1]];
+    std::uint8_t c = kDecode.values[in[2]];
+    std::uint8_t d = kDecode.values[in[3]];
+    invalid |= a | b | c | d;
+
+    std::uint32_t v = static_cast<std::uint32_t>(a) << 18 | static_cast<std::uint32_t>(b) << 12 |
+                      static_cast<std::uint32_t>(c) << 6 | d;
+    dst[0] = static_cast<std::uint8_t>(v >> 16);
+    dst[1] = static_cast<std::uint8_t>(v >> 8);
+    dst[2] = static_cast<std::uint8_t>(v);
+    in += 4;
+    dst += 3;
+  }
+
+  if (padding) {
+    std::uint8_t a = kDecode.values[in[0]];
+    std::uint8_t b = kDecode.values[in[1]];
+    std::uint8_t c = padding == 1 ? kDecode.values[in[2]] : 0;
+    invalid |= a | b | c;
+
+    std::uint32_t v = static_cast<std::uint32_t>(a) << 18 | static_cast<std::uint32_t>(b) << 12 |
+                      static_cast<std::uint32_t>(c) << 6;
+    dst[0] = static_cast<std::uint8_t>(v >> 16);
+    if (padding == 1) {
+      dst[1] = static_cast<std::uint8_t>(v >> 8);
+    }
+  }
+
+  return (invalid & 0x80) == 0;
+}
+
+}  // namespace utu
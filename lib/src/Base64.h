@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace utu
+{
+
+// Standard base64 alphabet with padding, appended to out.
+void base64Encode(const std::uint8_t* data, std::size_t size, std::string& out);
+
+// Decode into out, replacing its contents. Returns false if text is not
+// padded base64; out is then unspecified.
+bool base64Decode(std::string_view text, std::vector<std::uint8_t>& out);
+
+// Samples converted to T as little endian bytes, replacing the contents of
+// bytes.
+template <typename T, typename SampleType>
+void packSamples(const SampleType* samples, std::size_t count, std::vector<std::uint8_t>& bytes)
+{
+  using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+
+  bytes.resize(count * sizeof(T));
+  std::uint8_t* b = bytes.data();
+  for (std::size_t i = 0; i < count; ++i) {
+    T value = static_cast<T>(samples[i]);
+    Bits bits;
+    std::memcpy(&bits, &value, sizeof(T));
+    for (std::size_t k = 0; k < sizeof(T); ++k) {
+      *b++ = static_cast<std::uint8_t>(bits >> (8 * k));
+    }
+  }
+}
+
+// Little endian T converted to samples, replacing their contents. Returns
+// false if size is not a whole number of T.
+template <typename T, typename Samples>
+bool unpackSamples(const std::uint8_t* bytes, std::size_t size, Samples& samples)
+{
+  using Bits = std::conditional_t<sizeof(T) == 8, std::uint64_t, std::uint32_t>;
+  using SampleType = typename Samples::value_type;
+
+  if (size % sizeof(T) != 0) {
+    return false;
+  }
+
+  std::size_t count = size / sizeof(T);
+  samples.resize(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    Bits bits = 0;
+    for (std::size_t k = 0; k < sizeof(T); ++k) {
+      bits |= static_cast<Bits>(bytes[k]) << (8 * k);
+    }
+    T value;
+    std::memcpy(&value, &bits, sizeof(T));
+    samples[i] = static_cast<SampleType>(value);
+    bytes += sizeof(T);
+  }
+  return true;
+}
+
+// Append samples converted to T as little endian base64, using bytes as
+// scratch.
+template <typename T, typename SampleType>
+void encodeSamples(const SampleType* samples, std::size_t count, std::vector<std::uint8_t>& bytes,
+                   std::string& out)
+{
+  packSamples<T>(samples, count, bytes);
+  base64Encode(bytes.data(), bytes.size(), out);
+}
+
+// Decode little endian base64 of T into samples, using bytes as scratch.
+// Returns false if text is not base64 of a whole number of T.
+template <typename T, typename Samples>
+bool decodeSamples(std::string_view text, std::vector<std::uint8_t>& bytes, Samples& samples)
+{
+  return base64Decode(text, bytes) && unpackSamples<T>(bytes.data(), bytes.size(), samples);
+}
+
+}  // namespace utu
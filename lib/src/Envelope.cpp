@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Envelope.h>
+
+#include <algorithm>
+
+// Queries are processed in blocks of this many; the breakpoint positions of a
+// block are kept on the stack.
+constexpr std::size_t kBlockSize = 64;
+
+namespace
+{
+
+// out[i] = v[lo[i]] + frac[i] * (v[hi[i]] - v[lo[i]]) for every query of the
+// block. Free of branches and loop carried dependencies so it vectorizes,
+// using gathers where the target provides them.
+template <typename SampleType>
+void _interpolate(const SampleType* v, const std::size_t* lo, const std::size_t* hi,
+                  const SampleType* frac, std::size_t count, SampleType* out)
+{
+  for (std::size_t i = 0; i < count; ++i) {
+    SampleType a = v[lo[i]];
+    SampleType b = v[hi[i]];
+    out[i] = a + frac[i] * (b - a);
+  }
+}
+
+}  // namespace
+
+namespace utu
+{
+
+template <typename SampleType>
+BasicEnvelopeCursor<SampleType>::BasicEnvelopeCursor(const Partial& partial,
+                                                     const std::vector<std::string>& parameters)
+    : _time(nullptr), _size(0), _cursor(0)
+{
+  auto time = partial.parameters.find(kTimeName);
+  if (time != partial.parameters.end()) {
+    _time = &time->second;
+    _size = _time->size();
+  }
+
+  // envelopes are expected to be the same length, only the common prefix is
+  // evaluated if not
+  _values.reserve(parameters.size());
+  for (const auto& name : parameters) {
+    auto it = partial.parameters.find(name);
+    if (it == partial.parameters.end()) {
+      _values.push_back(nullptr);
+    } else {
+      _values.push_back(it->second.data());
+      _size = std::min(_size, it->second.size());
+    }
+  }
+}
+
+template <typename SampleType>
+void BasicEnvelopeCursor<SampleType>::evaluate(const double* times, std::size_t count,
+                                               SampleType* const* outputs)
+{
+  if (_size == 0) {
+    for (std::size_t k = 0; k < _values.size(); ++k) {
+      std::fill(outputs[k], outputs[k] + count, SampleType(0));
+    }
+    return;
+  }
+
+  const SampleType* time = _time->data();
+  auto at = [&](std::size_t i) { return static_cast<double>(time[i]); };
+
+  if (count > 0 && _cursor > 0 && times[0] < at(_cursor)) {
+    auto it = std::upper_bound(time, time + _size, times[0],
+                               [](double t, SampleType x) { return t < static_cast<double>(x); });
+    _cursor = it == time ? 0 : static_cast<std::size_t>(it - time) - 1;
+  }
+
+  std::size_t lo[kBlockSize];
+  std::size_t hi[kBlockSize];
+  SampleType frac[kBlockSize];
+
+  for (std::size_t base = 0; base < count; base += kBlockSize) {
+    std::size_t n = std::min(kBlockSize, count - base);
+
+    // locate the breakpoints around each query
+    for (std::size_t i = 0; i < n; ++i) {
+      double t = times[base + i];
+      while (_cursor + 1 < _size && at(_cursor + 1) <= t) {
+        ++_cursor;
+      }
+
+      double t0 = at(_cursor);
+      lo[i] = _cursor;
+      if (t <= t0 || _cursor + 1 == _size) {
+        // before the first breakpoint, on a breakpoint, or after the last
+        hi[i] = _cursor;
+        frac[i] = 0;
+      } else {
+        hi[i] = _cursor + 1;
+        frac[i] = static_cast<SampleType>((t - t0) / (at(_cursor + 1) - t0));
+      }
+    }
+
+    for (std::size_t k = 0; k < _values.size(); ++k) {
+      SampleType* out = outputs[k] + base;
+      if (_values[k]) {
+        _interpolate(_values[k], lo, hi, frac, n, out);
+      } else {
+        std::fill(out, out + n, SampleType(0));
+      }
+    }
+  }
+}
+
+template class BasicEnvelopeCursor<double>;
+template class BasicEnvelopeCursor<float>;
+
+}  // namespace utu
@@ -0,0 +1,315 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Evaluation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Parallel.h"
+
+// Blocks are evaluated in groups so each parallel task is large enough to
+// amortize scheduling.
+constexpr std::size_t kBlocksPerTask = 64;
+constexpr std::size_t kFramesPerTask = 16;
+
+// Lowest band edge of the default octave bands
+constexpr double kLowestBandEdge = 62.5;
+
+namespace
+{
+
+using namespace utu;
+
+// Power ratio in dB limited to +/- the evaluation floor
+double _ratioDb(double numerator, double denominator)
+{
+  if (numerator <= 0) {
+    return kEvaluationFloorDb;
+  }
+  if (denominator <= 0) {
+    return -kEvaluationFloorDb;
+  }
+  return std::clamp(10.0 * std::log10(numerator / denominator), kEvaluationFloorDb,
+                    -kEvaluationFloorDb);
+}
+
+// Accumulate the energy of the source and of the residual. Independent
+// partial sums break the dependency between iterations so the loop vectorizes.
+void _energies(const double* source, const double* rendered, std::size_t count, double& signal,
+               double& error)
+{
+  constexpr std::size_t kLanes = 4;
+  double s[kLanes] = {0};
+  double e[kLanes] = {0};
+
+  std::size_t i = 0;
+  for (; i + kLanes <= count; i += kLanes) {
+    for (std::size_t l = 0; l < kLanes; ++l) {
+      double x = source[i + l];
+      double r = x - rendered[i + l];
+      s[l] += x * x;
+      e[l] += r * r;
+    }
+  }
+  for (; i < count; ++i) {
+    double x = source[i];
+    double r = x - rendered[i];
+    s[0] += x * x;
+    e[0] += r * r;
+  }
+
+  signal = (s[0] + s[1]) + (s[2] + s[3]);
+  error = (e[0] + e[1]) + (e[2] + e[3]);
+}
+
+// In place radix-2 complex FFT over split real and imaginary arrays with
+// precomputed twiddles and bit reversal, shared read only between threads.
+class _FFT final
+{
+ public:
+  explicit _FFT(std::size_t size) : _size(size), _cos(size / 2), _sin(size / 2), _reverse(size)
+  {
+    if (size < 2 || (size & (size - 1)) != 0) {
+      throw std::invalid_argument("fft size must be a power of two");
+    }
+
+    for (std::size_t k = 0; k < size / 2; ++k) {
+      double w = -2.0 * M_PI * static_cast<double>(k) / static_cast<double>(size);
+      _cos[k] = std::cos(w);
+      _sin[k] = std::sin(w);
+    }
+
+    std::size_t bits = 0;
+    while ((std::size_t(1) << bits) < size) {
+      ++bits;
+    }
+    for (std::size_t i = 0; i < size; ++i) {
+      std::size_t r = 0;
+      for (std::size_t b = 0; b < bits; ++b) {
+        r |= ((i >> b) & 1) << (bits - 1 - b);
+      }
+      _reverse[i] = r;
+    }
+  }
+
+  std::size_t size() const { return _size; }
+
+  void transform(double* re, double* im) const
+  {
+    for (std::size_t i = 0; i < _size; ++i) {
+      std::size_t j = _reverse[i];
+      if (i < j) {
+        std::swap(re[i], re[j]);
+        std::swap(im[i], im[j]);
+      }
+    }
+
+    for (std::size_t half = 1; half < _size; half *= 2) {
+      std::size_t stride = _size / (half * 2);
+      for (std::size_t start = 0; start < _size; start += half * 2) {
+        double* re0 = re + start;
+        double* im0 = im + start;
+        double* re1 = re0 + half;
+        double* im1 = im0 + half;
+        for (std::size_t k = 0; k < half; ++k) {
+          double c = _cos[k * stride];
+          double s = _sin[k * stride];
+          double tr = re1[k] * c - im1[k] * s;
+          double ti = re1[k] * s + im1[k] * c;
+          re1[k] = re0[k] - tr;
+          im1[k] = im0[k] - ti;
+          re0[k] += tr;
+          im0[k] += ti;
+        }
+      }
+    }
+  }
+
+ private:
+  std::size_t _size;
+  std::vector<double> _cos;
+  std::vector<double> _sin;
+  std::vector<std::size_t> _reverse;
+};
+
+std::vector<double> _bandEdges(const EvaluateOptions& options, double nyquist)
+{
+  std::vector<double> edges;
+  if (!options.bandEdges.empty()) {
+    edges = options.bandEdges;
+    if (edges.size() < 2 || !std::is_sorted(edges.begin(), edges.end()) || edges.front() < 0) {
+      throw std::invalid_argument("at least two ascending, non-negative, band edges are required");
+    }
+    return edges;
+  }
+
+  edges.push_back(0);
+  for (double edge = kLowestBandEdge; edge < nyquist; edge *= 2) {
+    edges.push_back(edge);
+  }
+  edges.push_back(nyquist);
+  return edges;
+}
+
+// Per band power accumulated over a run of analysis frames
+struct _BandPower {
+  std::vector<double> source;
+  std::vector<double> error;
+  std::size_t frames = 0;
+
+  explicit _BandPower(std::size_t bands) : source(bands, 0.0), error(bands, 0.0) {}
+};
+
+// Accumulate the windowed power spectra of the source and residual into
+// bands for the frames [begin, end). The real source and residual are
+// transformed together as the real and imaginary parts of one complex
+// signal then separated using the conjugate symmetry of real spectra.
+void _spectralFrames(const double* source, const double* rendered, std::size_t count,
+                     const _FFT& fft, const std::vector<double>& window,
+                     const std::vector<std::size_t>& binBand, std::size_t begin, std::size_t end,
+                     _BandPower& power)
+{
+  std::size_t n = fft.size();
+  std::size_t hop = n / 2;
+  std::vector<double> re(n);
+  std::vector<double> im(n);
+
+  for (std::size_t frame = begin; frame < end; ++frame) {
+    std::size_t offset = frame * hop;
+    std::size_t available = std::min(n, count - offset);
+    for (std::size_t i = 0; i < available; ++i) {
+      double x = source[offset + i];
+      re[i] = window[i] * x;
+      im[i] = window[i] * (x - rendered[offset + i]);
+    }
+    std::fill(re.data() + available, re.data() + n, 0.0);
+    std::fill(im.data() + available, im.data() + n, 0.0);
+
+    fft.transform(re.data(), im.data());
+
+    for (std::size_t k = 0; k <= n / 2; ++k) {
+      std::size_t band = binBand[k];
+      if (band >= power.source.size()) {
+        continue;
+      }
+      std::size_t m = (n - k) % n;
+      // S = (Z[k] + conj(Z[m])) / 2, E = (Z[k] - conj(Z[m])) / 2i
+      double sr = 0.5 * (re[k] + re[m]);
+      double si = 0.5 * (im[k] - im[m]);
+      double er = 0.5 * (im[k] + im[m]);
+      double ei = 0.5 * (re[m] - re[k]);
+      power.source[band] += sr * sr + si * si;
+      power.error[band] += er * er + ei * ei;
+    }
+    ++power.frames;
+  }
+}
+
+}  // namespace
+
+namespace utu
+{
+
+Evaluation evaluate(const double* source, const double* rendered, std::size_t count,
+                    double sampleRate, const EvaluateOptions& options)
+{
+  if (sampleRate <= 0 || options.blockTime <= 0) {
+    throw std::invalid_argument("sample rate and block time must be greater than 0");
+  }
+
+  Evaluation result;
+  unsigned threads = threadCount(options.threads);
+
+  // time local error, blocks are independent and evaluated in parallel
+  auto blockSize = static_cast<std::size_t>(std::lround(options.blockTime * sampleRate));
+  blockSize = std::max<std::size_t>(blockSize, 1);
+  std::size_t blocks = (count + blockSize - 1) / blockSize;
+  result.blockTime = static_cast<double>(blockSize) / sampleRate;
+  result.errorCurve.resize(blocks);
+
+  std::vector<double> blockSignal(blocks);
+  std::vector<double> blockError(blocks);
+  std::size_t blockTasks = (blocks + kBlocksPerTask - 1) / kBlocksPerTask;
+  parallelFor(blockTasks, threads, [&](std::size_t task) {
+    std::size_t last = std::min(blocks, (task + 1) * kBlocksPerTask);
+    for (std::size_t b = task * kBlocksPerTask; b < last; ++b) {
+      std::size_t offset = b * blockSize;
+      std::size_t n = std::min(blockSize, count - offset);
+      _energies(source + offset, rendered + offset, n, blockSignal[b], blockError[b]);
+      result.errorCurve[b] = _ratioDb(blockError[b], static_cast<double>(n));
+    }
+  });
+
+  // summed in block order so the result does not depend on the thread count
+  double signal = 0;
+  double error = 0;
+  for (std::size_t b = 0; b < blocks; ++b) {
+    signal += blockSignal[b];
+    error += blockError[b];
+  }
+  result.snr = _ratioDb(signal, error);
+
+  // spectral error per band over half overlapping Hann windowed frames
+  double nyquist = sampleRate / 2;
+  std::vector<double> edges = _bandEdges(options, nyquist);
+  std::size_t bandCount = edges.size() - 1;
+
+  _FFT fft(options.fftSize);
+  std::size_t n = fft.size();
+  std::vector<double> window(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    window[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * static_cast<double>(i) / static_cast<double>(n));
+  }
+
+  // band of each bin, bins outside every band map to the band count
+  std::vector<std::size_t> binBand(n / 2 + 1, bandCount);
+  for (std::size_t k = 0; k <= n / 2; ++k) {
+    double frequency = static_cast<double>(k) * sampleRate / static_cast<double>(n);
+    auto it = std::upper_bound(edges.begin(), edges.end(), frequency);
+    if (it != edges.begin() && (it != edges.end() || frequency == edges.back())) {
+      binBand[k] = std::min(static_cast<std::size_t>(it - edges.begin()) - 1, bandCount - 1);
+    }
+  }
+
+  std::size_t hop = n / 2;
+  std::size_t frames = count == 0 ? 0 : (count + hop - 1) / hop;
+  std::size_t frameTasks = (frames + kFramesPerTask - 1) / kFramesPerTask;
+  std::vector<_BandPower> powers(frameTasks, _BandPower(bandCount));
+  parallelFor(frameTasks, threads, [&](std::size_t task) {
+    std::size_t begin = task * kFramesPerTask;
+    _spectralFrames(source, rendered, count, fft, window, binBand, begin,
+                    std::min(frames, begin + kFramesPerTask), powers[task]);
+  });
+
+  _BandPower total(bandCount);
+  for (const auto& p : powers) {
+    for (std::size_t b = 0; b < bandCount; ++b) {
+      total.source[b] += p.source[b];
+      total.error[b] += p.error[b];
+    }
+    total.frames += p.frames;
+  }
+
+  for (std::size_t b = 0; b < bandCount; ++b) {
+    double frameCount = static_cast<double>(std::max<std::size_t>(total.frames, 1));
+    result.bands.push_back({edges[b], edges[b + 1], _ratioDb(total.source[b], frameCount),
+                            _ratioDb(total.error[b], total.source[b])});
+  }
+
+  return result;
+}
+
+double signalToNoise(const double* source, const double* rendered, std::size_t count)
+{
+  double signal = 0;
+  double error = 0;
+  _energies(source, rendered, count, signal, error);
+  return _ratioDb(signal, error);
+}
+
+}  // namespace utu
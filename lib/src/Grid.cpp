@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Grid.h>
+#include <utu/Harmonic.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "Parallel.h"
+
+// Frames are filled in blocks of rows so each parallel task writes a
+// contiguous region of every matrix.
+constexpr std::size_t kFramesPerTask = 256;
+
+namespace
+{
+
+using namespace utu;
+
+constexpr double kTwoPi = 2.0 * M_PI;
+
+template <typename SampleType>
+struct _Envelopes {
+  using Samples = typename BasicPartial<SampleType>::Samples;
+
+  const Samples* time = nullptr;
+  const Samples* frequency = nullptr;
+  const Samples* amplitude = nullptr;
+  const Samples* bandwidth = nullptr;
+  const Samples* phase = nullptr;
+
+  explicit _Envelopes(const BasicPartial<SampleType>& p)
+      : time(_find(p, kTimeName)),
+        frequency(_find(p, kFrequencyName)),
+        amplitude(_find(p, kAmplitudeName)),
+        bandwidth(_find(p, kBandwidthName)),
+        phase(_find(p, kPhaseName))
+  {
+  }
+
+  std::size_t size() const { return time ? time->size() : 0; }
+
+  static double at(const Samples* e, std::size_t i)
+  {
+    return e && i < e->size() ? static_cast<double>((*e)[i]) : 0.0;
+  }
+
+ private:
+  static const Samples* _find(const BasicPartial<SampleType>& p, const char* name)
+  {
+    auto it = p.parameters.find(name);
+    return it == p.parameters.end() ? nullptr : &it->second;
+  }
+};
+
+// Fill frames [begin, end) for every partial. The cursor of each partial is
+// found once by binary search then advanced monotonically with the frames.
+template <typename SampleType>
+void _fill(const std::vector<_Envelopes<SampleType>>& envelopes, std::size_t begin,
+           std::size_t end, Grid& grid)
+{
+  using E = _Envelopes<SampleType>;
+
+  std::size_t count = envelopes.size();
+  std::vector<std::size_t> cursors(count, 0);
+  double firstTime = grid.startTime + static_cast<double>(begin) * grid.hop;
+  for (std::size_t p = 0; p < count; ++p) {
+    if (const auto* time = envelopes[p].time) {
+      auto it = std::upper_bound(time->begin(), time->end(), firstTime,
+                                 [](double t, SampleType x) { return t < static_cast<double>(x); });
+      cursors[p] = it == time->begin() ? 0 : static_cast<std::size_t>(it - time->begin()) - 1;
+    }
+  }
+
+  for (std::size_t f = begin; f < end; ++f) {
+    double t = grid.startTime + static_cast<double>(f) * grid.hop;
+    std::size_t row = f * count;
+
+    for (std::size_t p = 0; p < count; ++p) {
+      const E& e = envelopes[p];
+      std::size_t n = e.size();
+      if (n == 0 || t < E::at(e.time, 0) || t > E::at(e.time, n - 1)) {
+        continue;  // matrices are zero initialized
+      }
+
+      std::size_t& i = cursors[p];
+      while (i + 1 < n && E::at(e.time, i + 1) <= t) {
+        ++i;
+      }
+
+      double t0 = E::at(e.time, i);
+      double f0 = E::at(e.frequency, i);
+      double frequency = f0;
+      double amplitude = E::at(e.amplitude, i);
+      double bandwidth = E::at(e.bandwidth, i);
+      if (i + 1 < n) {
+        double dt = E::at(e.time, i + 1) - t0;
+        double alpha = dt > 0 ? (t - t0) / dt : 0.0;
+        frequency += alpha * (E::at(e.frequency, i + 1) - f0);
+        amplitude += alpha * (E::at(e.amplitude, i + 1) - amplitude);
+        bandwidth += alpha * (E::at(e.bandwidth, i + 1) - bandwidth);
+      }
+      double phase = E::at(e.phase, i) + kTwoPi * 0.5 * (f0 + frequency) * (t - t0);
+
+      grid.frequency[row + p] = frequency;
+      grid.amplitude[row + p] = amplitude;
+      grid.bandwidth[row + p] = bandwidth;
+      grid.phase[row + p] = std::remainder(phase, kTwoPi);
+      grid.active[row + p] = 1;
+    }
+  }
+}
+
+}  // namespace
+
+namespace utu
+{
+
+template <typename SampleType>
+Grid grid(const BasicPartialData<SampleType>& data, const GridOptions& options)
+{
+  if (!(options.hop > 0)) {
+    throw std::invalid_argument("grid hop must be greater than 0");
+  }
+  if (data.fundamental) {
+    BasicPartialData<SampleType> absolute = data;
+    makeHarmonicAbsolute(absolute);
+    return grid(absolute, options);
+  }
+
+  std::vector<_Envelopes<SampleType>> envelopes;
+  envelopes.reserve(data.partials.size());
+  std::optional<double> lastTime = options.endTime;
+  for (const auto& p : data.partials) {
+    const auto& e = envelopes.emplace_back(p);
+    if (!options.endTime && e.size() > 0) {
+      double end = _Envelopes<SampleType>::at(e.time, e.size() - 1);
+      lastTime = std::max(lastTime.value_or(end), end);
+    }
+  }
+
+  Grid result;
+  result.partials = envelopes.size();
+  result.startTime = options.startTime;
+  result.hop = options.hop;
+  if (lastTime && *lastTime >= options.startTime) {
+    // tolerate rounding so a frame landing on the end time is included
+    double span = (*lastTime - options.startTime) / options.hop;
+    result.frames = static_cast<std::size_t>(std::floor(span + 1e-9)) + 1;
+  }
+
+  std::size_t cells = result.frames * result.partials;
+  result.frequency.assign(cells, 0.0);
+  result.amplitude.assign(cells, 0.0);
+  result.bandwidth.assign(cells, 0.0);
+  result.phase.assign(cells, 0.0);
+  result.active.assign(cells, 0);
+
+  std::size_t tasks = (result.frames + kFramesPerTask - 1) / kFramesPerTask;
+  parallelFor(tasks, threadCount(options.threads), [&](std::size_t task) {
+    std::size_t begin = task * kFramesPerTask;
+    _fill(envelopes, begin, std::min(result.frames, begin + kFramesPerTask), result);
+  });
+
+  return result;
+}
+
+template Grid grid(const BasicPartialData<double>& data, const GridOptions& options);
+template Grid grid(const BasicPartialData<float>& data, const GridOptions& options);
+
+}  // namespace utu
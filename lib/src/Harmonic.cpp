@@ -0,0 +1,261 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Envelope.h>
+#include <utu/Harmonic.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+
+using namespace utu;
+
+template <typename Partial>
+auto _find(Partial& p, const char* name) -> decltype(&p.parameters.begin()->second)
+{
+  auto it = p.parameters.find(name);
+  return it == p.parameters.end() ? nullptr : &it->second;
+}
+
+// Evaluate the track at count ascending times, holding the end values. The
+// breakpoint index advances with the times rather than searching for each.
+template <typename SampleType>
+void _evaluate(const PartialDataHeader::Fundamental& track, const SampleType* times,
+               std::size_t count, double* out)
+{
+  const auto& t = track.time;
+  const auto& v = track.frequency;
+  std::size_t size = std::min(t.size(), v.size());
+
+  std::size_t j = 0;
+  for (std::size_t i = 0; i < count; ++i) {
+    double x = static_cast<double>(times[i]);
+    while (j + 1 < size && t[j + 1] <= x) {
+      ++j;
+    }
+    if (x <= t[j] || j + 1 == size) {
+      out[i] = v[j];
+    } else {
+      out[i] = v[j] + (x - t[j]) / (t[j + 1] - t[j]) * (v[j + 1] - v[j]);
+    }
+  }
+}
+
+// The track at each of count breakpoints of a partial; breakpoints beyond the
+// end of a shorter time envelope hold its last time.
+template <typename Samples>
+void _fundamentalAt(const PartialDataHeader::Fundamental& track, const Samples& time,
+                    std::size_t count, std::vector<double>& out)
+{
+  out.resize(count);
+  std::size_t timed = std::min(count, time.size());
+  _evaluate(track, time.data(), timed, out.data());
+  if (timed > 0) {
+    std::fill(out.begin() + static_cast<std::ptrdiff_t>(timed), out.end(), out[timed - 1]);
+  }
+}
+
+}  // namespace
+
+namespace utu
+{
+
+template <typename SampleType>
+std::optional<unsigned> harmonicNumber(const BasicPartial<SampleType>& partial)
+{
+  if (!partial.label || partial.label->empty() ||
+      !std::isdigit(static_cast<unsigned char>(partial.label->front()))) {
+    return {};
+  }
+
+  char* end = nullptr;
+  unsigned long k = std::strtoul(partial.label->c_str(), &end, 10);
+  if (*end != '\0' || k == 0 || k > std::numeric_limits<unsigned>::max()) {
+    return {};
+  }
+  return static_cast<unsigned>(k);
+}
+
+template <typename SampleType>
+void makeHarmonicRelative(BasicPartialData<SampleType>& data, double hopTime)
+{
+  if (!(hopTime > 0)) {
+    throw std::invalid_argument("fundamental hop time must be greater than 0");
+  }
+  if (data.fundamental) {
+    return;
+  }
+
+  // span of the harmonic partials
+  double start = std::numeric_limits<double>::infinity();
+  double end = -std::numeric_limits<double>::infinity();
+  for (const auto& p : data.partials) {
+    const auto* time = _find(p, kTimeName);
+    if (harmonicNumber(p) && _find(p, kFrequencyName) && time && !time->empty()) {
+      start = std::min(start, static_cast<double>(time->front()));
+      end = std::max(end, static_cast<double>(time->back()));
+    }
+  }
+  if (!(start <= end)) {
+    return;
+  }
+
+  // accumulate the estimates of each harmonic at the frames within its span
+  auto frames = static_cast<std::size_t>(std::floor((end - start) / hopTime)) + 1;
+  std::vector<double> weighted(frames, 0.0);
+  std::vector<double> total(frames, 0.0);
+  std::vector<double> times(frames);
+  std::vector<SampleType> frequency(frames);
+  std::vector<SampleType> amplitude(frames);
+  const std::vector<std::string> parameters = {kFrequencyName, kAmplitudeName};
+
+  for (const auto& p : data.partials) {
+    auto k = harmonicNumber(p);
+    const auto* time = _find(p, kTimeName);
+    if (!k || !_find(p, kFrequencyName) || !time || time->empty()) {
+      continue;
+    }
+
+    auto first = static_cast<std::size_t>(
+        std::ceil((static_cast<double>(time->front()) - start) / hopTime));
+    auto last = std::min(frames - 1, static_cast<std::size_t>(std::floor(
+                                         (static_cast<double>(time->back()) - start) / hopTime)));
+    if (first > last) {
+      continue;
+    }
+
+    std::size_t count = last - first + 1;
+    for (std::size_t i = 0; i < count; ++i) {
+      times[i] = start + static_cast<double>(first + i) * hopTime;
+    }
+    BasicEnvelopeCursor<SampleType> cursor(p, parameters);
+    SampleType* outputs[] = {frequency.data(), amplitude.data()};
+    cursor.evaluate(times.data(), count, outputs);
+
+    // partials without amplitudes are weighted equally
+    bool weightByAmplitude = _find(p, kAmplitudeName) != nullptr;
+    for (std::size_t i = 0; i < count; ++i) {
+      double a = weightByAmplitude ? static_cast<double>(amplitude[i]) : 1.0;
+      weighted[first + i] += a * static_cast<double>(frequency[i]) / *k;
+      total[first + i] += a;
+    }
+  }
+
+  PartialDataHeader::Fundamental track;
+  for (std::size_t f = 0; f < frames; ++f) {
+    if (total[f] > 0) {
+      track.time.push_back(start + static_cast<double>(f) * hopTime);
+      track.frequency.push_back(weighted[f] / total[f]);
+    }
+  }
+  if (track.time.empty()) {
+    return;
+  }
+
+  std::vector<double> f0;
+  for (auto& p : data.partials) {
+    auto k = harmonicNumber(p);
+    const auto* time = _find(p, kTimeName);
+    auto* samples = _find(p, kFrequencyName);
+    if (!k || !time || time->empty() || !samples) {
+      continue;
+    }
+
+    _fundamentalAt(track, *time, samples->size(), f0);
+    for (std::size_t i = 0; i < samples->size(); ++i) {
+      double f = static_cast<double>((*samples)[i]);
+      (*samples)[i] = static_cast<SampleType>(f / (*k * f0[i]) - 1.0);
+    }
+  }
+
+  data.fundamental = std::move(track);
+}
+
+template <typename SampleType>
+void makeHarmonicAbsolute(BasicPartialData<SampleType>& data)
+{
+  if (!data.fundamental) {
+    return;
+  }
+
+  std::vector<double> frequencies;
+  for (auto& p : data.partials) {
+    auto* samples = _find(p, kFrequencyName);
+    if (!samples || !harmonicNumber(p)) {
+      continue;
+    }
+    if (!absoluteFrequencies(*data.fundamental, p, frequencies)) {
+      throw std::invalid_argument(
+          "harmonic relative frequencies require a fundamental track and time envelopes");
+    }
+    convertSamples(frequencies.data(), frequencies.size(), samples->data());
+  }
+
+  data.fundamental.reset();
+}
+
+template <typename SampleType>
+void transpose(BasicPartialData<SampleType>& data, double cents)
+{
+  double ratio = std::pow(2.0, cents / 1200.0);
+  if (data.fundamental) {
+    for (double& f : data.fundamental->frequency) {
+      f *= ratio;
+    }
+  }
+
+  for (auto& p : data.partials) {
+    auto* samples = _find(p, kFrequencyName);
+    const auto* time = _find(p, kTimeName);
+    bool relative = data.fundamental && harmonicNumber(p) && time && !time->empty();
+    if (!samples || relative) {
+      continue;
+    }
+    for (auto& f : *samples) {
+      f = static_cast<SampleType>(static_cast<double>(f) * ratio);
+    }
+  }
+}
+
+template <typename SampleType>
+bool absoluteFrequencies(const PartialDataHeader::Fundamental& fundamental,
+                         const BasicPartial<SampleType>& partial, std::vector<double>& frequencies)
+{
+  auto k = harmonicNumber(partial);
+  const auto* time = _find(partial, kTimeName);
+  const auto* samples = _find(partial, kFrequencyName);
+  if (!k || !time || time->empty() || !samples || fundamental.time.empty() ||
+      fundamental.frequency.empty()) {
+    return false;
+  }
+
+  _fundamentalAt(fundamental, *time, samples->size(), frequencies);
+  for (std::size_t i = 0; i < samples->size(); ++i) {
+    frequencies[i] *= *k * (1.0 + static_cast<double>((*samples)[i]));
+  }
+  return true;
+}
+
+template std::optional<unsigned> harmonicNumber(const Partial& partial);
+template std::optional<unsigned> harmonicNumber(const FloatPartial& partial);
+template void makeHarmonicRelative(PartialData& data, double hopTime);
+template void makeHarmonicRelative(FloatPartialData& data, double hopTime);
+template void makeHarmonicAbsolute(PartialData& data);
+template void makeHarmonicAbsolute(FloatPartialData& data);
+template void transpose(PartialData& data, double cents);
+template void transpose(FloatPartialData& data, double cents);
+template bool absoluteFrequencies(const PartialDataHeader::Fundamental& fundamental,
+                                  const Partial& partial, std::vector<double>& frequencies);
+template bool absoluteFrequencies(const PartialDataHeader::Fundamental& fundamental,
+                                  const FloatPartial& partial, std::vector<double>& frequencies);
+
+}  // namespace utu
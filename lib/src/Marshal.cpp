@@ -6,6 +6,27 @@
 
 #include "Marshal.h"
 
+#include <utu/Harmonic.h>
+
+#include <cstdlib>
+
+namespace
+{
+
+// Loris labels are integers (0 meaning unlabeled) where as utu labels are
+// arbitrary strings, only labels which are entirely numeric are carried over.
+Loris::Partial::label_type _toLabel(const std::string& s)
+{
+  char* end = nullptr;
+  long label = std::strtol(s.c_str(), &end, 10);
+  if (s.empty() || *end != '\0') {
+    return 0;
+  }
+  return static_cast<Loris::Partial::label_type>(label);
+}
+
+}  // namespace
+
 utu::PartialData Marshal::from(const Loris::PartialList& partials)
 {
   utu::PartialData result;
@@ -30,6 +51,9 @@ utu::PartialData Marshal::from(const Loris::PartialList& partials)
     }
 
     utu::Partial op;
+    if (ip.label() != 0) {
+      op.label = std::to_string(ip.label());
+    }
     op.parameters[kTimeName] = time;
     op.parameters[kFrequencyName] = frequency;
     op.parameters[kAmplitudeName] = amplitude;
@@ -47,10 +71,14 @@ Loris::PartialList Marshal::from(const utu::PartialData& data)
   // TODO: validate the required parameters are present
 
   Loris::PartialList result;
+  std::vector<double> absolute;
 
   for (auto partial : data.partials) {
     auto times = partial.parameters[kTimeName];
     auto frequencies = partial.parameters[kFrequencyName];
+    if (data.fundamental && utu::absoluteFrequencies(*data.fundamental, partial, absolute)) {
+      frequencies.assign(absolute.begin(), absolute.end());
+    }
     auto amplitudes = partial.parameters[kAmplitudeName];
     auto bandwidths = partial.parameters[kBandwidthName];
     auto phases = partial.parameters[kPhaseName];
@@ -62,6 +90,9 @@ Loris::PartialList Marshal::from(const utu::PartialData& data)
     auto p = phases.cbegin();
 
     Loris::Partial out;
+    if (partial.label) {
+      out.setLabel(_toLabel(*partial.label));
+    }
 
     for (; t != times.end() and f != frequencies.end() and a != amplitudes.end() and
            b != bandwidths.end() and p != phases.end();
@@ -0,0 +1,68 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace utu
+{
+
+// The number of threads to use for a requested count where 0 means one per
+// core.
+inline unsigned threadCount(unsigned requested)
+{
+  if (requested == 0) {
+    return std::max(std::thread::hardware_concurrency(), 1u);
+  }
+  return requested;
+}
+
+// Call fn(i) for every i in [0, count) spread across up to the given number of
+// threads; indices are handed out in order as threads become free. The first
+// exception thrown by fn is rethrown once all threads have finished.
+template <typename F>
+void parallelFor(std::size_t count, unsigned threads, F&& fn)
+{
+  threads = static_cast<unsigned>(std::min<std::size_t>(threadCount(threads), count));
+  if (threads <= 1) {
+    for (std::size_t i = 0; i < count; ++i) {
+      fn(i);
+    }
+    return;
+  }
+
+  std::atomic<std::size_t> next(0);
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> workers;
+  for (unsigned t = 0; t < threads; ++t) {
+    workers.emplace_back([&, t] {
+      try {
+        for (std::size_t i = next++; i < count; i = next++) {
+          fn(i);
+        }
+      } catch (...) {
+        errors[t] = std::current_exception();
+        next = count;
+      }
+    });
+  }
+  for (auto& w : workers) {
+    w.join();
+  }
+  for (auto& e : errors) {
+    if (e) {
+      std::rethrow_exception(e);
+    }
+  }
+}
+
+}  // namespace utu
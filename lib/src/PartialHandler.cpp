@@ -0,0 +1,545 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "PartialHandler.h"
+
+#include <utu/Harmonic.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "Base64.h"
+
+namespace utu
+{
+
+template <typename SampleType>
+BasicPartialHandler<SampleType>::BasicPartialHandler(const ReadOptions& options,
+                                                     std::pmr::memory_resource* resource,
+                                                     Document document)
+    : _options(options),
+      _document(document),
+      _needTime(options.startTime || options.endTime),
+      _needAmplitude(options.minPeakAmplitude.has_value()),
+      _skipDepth(0),
+      _sawRoot(false),
+      _info({"", 0}),
+      _data(resource),
+      _range(nullptr),
+      _rangeIndex(0),
+      _track(nullptr),
+      _partial(nullptr),
+      _discard(false),
+      _sawTime(false),
+      _sawAmplitude(false),
+      _samples(nullptr)
+{
+  if (document == Document::Partials) {
+    // every top level object is a partial
+    _sawRoot = true;
+    _stack.push_back(Context::Partials);
+  }
+}
+
+template <typename SampleType>
+auto BasicPartialHandler<SampleType>::result() -> std::optional<Data>
+{
+  if (!_sawRoot) {
+    return {};
+  }
+  return std::move(_data);
+}
+
+//
+// scalar values
+//
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::null() { return true; }
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::boolean(bool /* value */) { return true; }
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::number_integer(number_integer_t value)
+{
+  if (_in(Context::FileInfo) && _key == "version") {
+    _info.version = static_cast<uint16_t>(value);
+    return true;
+  }
+  return _number(static_cast<double>(value));
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::number_unsigned(number_unsigned_t value)
+{
+  if (_in(Context::FileInfo) && _key == "version") {
+    _info.version = static_cast<uint16_t>(value);
+    return true;
+  }
+  return _number(static_cast<double>(value));
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::number_float(number_float_t value, const string_t& /* s */)
+{
+  return _number(value);
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::_number(double value)
+{
+  if (_in(Context::Samples)) {
+    _samples->push_back(static_cast<SampleType>(value));
+  } else if (_in(Context::FundamentalSamples)) {
+    _track->push_back(value);
+  } else if (_in(Context::Marker) && _key == "time") {
+    _data.markers.back().time = value;
+  } else if (_in(Context::Summary)) {
+    if (_key == "partial_count") {
+      _info.summary->partials = static_cast<std::size_t>(value);
+    } else if (_key == "breakpoint_count") {
+      _info.summary->breakpoints = static_cast<std::size_t>(value);
+    }
+  } else if (_in(Context::SummaryRange)) {
+    if (_rangeIndex == 0) {
+      _range->min = value;
+    } else if (_rangeIndex == 1) {
+      _range->max = value;
+    }
+    _rangeIndex++;
+  }
+  return true;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::string(string_t& value)
+{
+  if (_skipDepth > 0 || _stack.empty()) {
+    return true;
+  }
+
+  switch (_stack.back()) {
+    case Context::Root:
+      if (_key == "description") {
+        _data.description = std::move(value);
+      }
+      break;
+    case Context::FileInfo:
+      if (_key == "kind") {
+        _info.kind = std::move(value);
+      } else if (_key == "encoding") {
+        _info.encoding = std::move(value);
+      }
+      break;
+    case Context::Summary:
+      if (_key == "fingerprint") {
+        _info.summary->fingerprint = std::move(value);
+      }
+      break;
+    case Context::Source:
+      if (_key == "location") {
+        _data.source->location = std::move(value);
+      } else if (_key == "fingerprint") {
+        _data.source->fingerprint = std::move(value);
+      }
+      break;
+    case Context::Marker:
+      if (_key == "name") {
+        _data.markers.back().name = std::move(value);
+      }
+      break;
+    case Context::Parameters:
+      if (_selected(value)) {
+        _data.parameters.push_back(std::move(value));
+      }
+      break;
+    case Context::PartialParameters:
+      if (!_discard) {
+        _decodeSamples(_key, value);
+      }
+      break;
+    case Context::PartialObject:
+      if (_key == "label") {
+        const auto& labels = _options.labels;
+        if (!labels.empty() && std::find(labels.begin(), labels.end(), value) == labels.end()) {
+          _discard = true;
+        }
+        _partial->label = std::move(value);
+      }
+      break;
+    default:
+      break;
+  }
+  return true;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::binary(binary_t& value)
+{
+  if (!_in(Context::PartialParameters) || _discard) {
+    return true;
+  }
+
+  _startSamples(_key);
+  if (!_samples) {
+    return true;
+  }
+
+  bool valid;
+  if (_info.encoding == kFloat64Encoding) {
+    valid = unpackSamples<double>(value.data(), value.size(), *_samples);
+  } else if (_info.encoding == kFloat32Encoding) {
+    valid = unpackSamples<float>(value.data(), value.size(), *_samples);
+  } else {
+    throw std::runtime_error("unsupported sample encoding for parameter '" + _key + "'");
+  }
+  if (!valid) {
+    throw std::runtime_error("invalid typed array for parameter '" + _key + "'");
+  }
+
+  _endSamples();
+  return true;
+}
+
+//
+// structure
+//
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::_in(Context context) const
+{
+  return _skipDepth == 0 && !_stack.empty() && _stack.back() == context;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::_skipValue()
+{
+  _skipDepth = 1;
+  return true;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::start_object(std::size_t /* elements */)
+{
+  if (_skipDepth > 0) {
+    _skipDepth++;
+    return true;
+  }
+
+  if (_stack.empty()) {
+    _sawRoot = true;
+    _stack.push_back(Context::Root);
+    return true;
+  }
+
+  switch (_stack.back()) {
+    case Context::Root:
+      if (_key == "file_info") {
+        _stack.push_back(Context::FileInfo);
+        return true;
+      }
+      if (_key == "source") {
+        _data.source = PartialData::Source();
+        _stack.push_back(Context::Source);
+        return true;
+      }
+      if (_key == "fundamental") {
+        _data.fundamental = PartialData::Fundamental();
+        _stack.push_back(Context::Fundamental);
+        return true;
+      }
+      break;
+    case Context::FileInfo:
+      if (_key == "summary") {
+        _info.summary = Summary();
+        _stack.push_back(Context::Summary);
+        return true;
+      }
+      break;
+    case Context::Summary:
+      if (_key == "ranges") {
+        _stack.push_back(Context::SummaryRanges);
+        return true;
+      }
+      break;
+    case Context::Markers:
+      _data.markers.push_back({0.0, {}});
+      _stack.push_back(Context::Marker);
+      return true;
+    case Context::Partials:
+      _partial = &_data.partials.emplace_back();
+      _discard = false;
+      _sawTime = false;
+      _sawAmplitude = false;
+      _stack.push_back(Context::PartialObject);
+      return true;
+    case Context::PartialObject:
+      if (_key == "parameters") {
+        _stack.push_back(Context::PartialParameters);
+        return true;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return _skipValue();
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::end_object()
+{
+  if (_skipDepth > 0) {
+    _skipDepth--;
+    return true;
+  }
+
+  if (_stack.back() == Context::PartialObject) {
+    _endPartial();
+  }
+  _stack.pop_back();
+  return true;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::key(string_t& value)
+{
+  if (_skipDepth == 0) {
+    _key = std::move(value);
+  }
+  return true;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::start_array(std::size_t /* elements */)
+{
+  if (_skipDepth > 0) {
+    _skipDepth++;
+    return true;
+  }
+
+  if (_stack.empty()) {
+    return _skipValue();
+  }
+
+  switch (_stack.back()) {
+    case Context::Root:
+      if (_key == "markers") {
+        _stack.push_back(Context::Markers);
+        return true;
+      }
+      if (_key == "parameters") {
+        _stack.push_back(Context::Parameters);
+        return true;
+      }
+      if (_key == "partials") {
+        if (_document == Document::Header) {
+          return false;
+        }
+        _stack.push_back(Context::Partials);
+        return true;
+      }
+      break;
+    case Context::Fundamental:
+      if (_key == kTimeName || _key == kFrequencyName) {
+        _track = _key == kTimeName ? &_data.fundamental->time : &_data.fundamental->frequency;
+        _track->clear();
+        _stack.push_back(Context::FundamentalSamples);
+        return true;
+      }
+      break;
+    case Context::SummaryRanges:
+      _range = &_info.summary->ranges[_key];
+      *_range = {0.0, 0.0};
+      _rangeIndex = 0;
+      _stack.push_back(Context::SummaryRange);
+      return true;
+    case Context::PartialParameters:
+      if (!_discard) {
+        _startSamples(_key);
+        if (_samples) {
+          _stack.push_back(Context::Samples);
+          return true;
+        }
+      }
+      break;
+    default:
+      break;
+  }
+
+  return _skipValue();
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::end_array()
+{
+  if (_skipDepth > 0) {
+    _skipDepth--;
+    return true;
+  }
+
+  if (_stack.back() == Context::Samples) {
+    _endSamples();
+  }
+  _stack.pop_back();
+  return true;
+}
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::parse_error(std::size_t /* position */,
+                                                  const std::string& /* lastToken */,
+                                                  const nlohmann::detail::exception& ex)
+{
+  // match the behavior of json::parse which reports errors via exceptions
+  if (auto* e = dynamic_cast<const json::parse_error*>(&ex)) {
+    throw *e;
+  }
+  throw std::runtime_error(ex.what());
+}
+
+//
+// partials
+//
+
+template <typename SampleType>
+bool BasicPartialHandler<SampleType>::_selected(const std::string& parameter) const
+{
+  const auto& selected = _options.parameters;
+  return selected.empty() || std::find(selected.begin(), selected.end(), parameter) != selected.end();
+}
+
+template <typename SampleType>
+void BasicPartialHandler<SampleType>::_startSamples(const std::string& parameter)
+{
+  _samplesName = parameter;
+  _samples = nullptr;
+
+  if (_selected(parameter)) {
+    _samples = &_partial->parameters[parameter];
+  } else if (_needTime && parameter == kTimeName) {
+    _samples = &_filterTime;
+  } else if (_needAmplitude && parameter == kAmplitudeName) {
+    _samples = &_filterAmplitude;
+  }
+
+  if (_samples) {
+    _samples->clear();
+  }
+}
+
+template <typename SampleType>
+void BasicPartialHandler<SampleType>::_decodeSamples(const std::string& parameter,
+                                                     const std::string& text)
+{
+  _startSamples(parameter);
+  if (!_samples) {
+    return;
+  }
+
+  bool valid;
+  if (_info.encoding == kBase64Float64Encoding) {
+    valid = decodeSamples<double>(text, _bytes, *_samples);
+  } else if (_info.encoding == kBase64Float32Encoding) {
+    valid = decodeSamples<float>(text, _bytes, *_samples);
+  } else {
+    throw std::runtime_error("unsupported sample encoding for parameter '" + parameter + "'");
+  }
+  if (!valid) {
+    throw std::runtime_error("invalid encoded samples for parameter '" + parameter + "'");
+  }
+
+  _endSamples();
+}
+
+template <typename SampleType>
+void BasicPartialHandler<SampleType>::_endSamples()
+{
+  // evaluate filters as soon as the envelopes they depend on are complete so
+  // that the remainder of a rejected partial can be skipped
+  if (_needTime && _samplesName == kTimeName) {
+    _sawTime = true;
+    const auto& time = *_samples;
+    if (time.empty() ||
+        (_options.startTime && static_cast<double>(time.back()) < *_options.startTime) ||
+        (_options.endTime && static_cast<double>(time.front()) > *_options.endTime)) {
+      _discard = true;
+    }
+  } else if (_needAmplitude && _samplesName == kAmplitudeName) {
+    _sawAmplitude = true;
+    const auto& amplitude = *_samples;
+    auto peak = std::max_element(amplitude.begin(), amplitude.end());
+    if (peak == amplitude.end() || static_cast<double>(*peak) < *_options.minPeakAmplitude) {
+      _discard = true;
+    }
+  }
+
+  _samples = nullptr;
+}
+
+template <typename SampleType>
+void BasicPartialHandler<SampleType>::_endPartial()
+{
+  bool keep = !_discard && (!_needTime || _sawTime) && (!_needAmplitude || _sawAmplitude) &&
+              (_options.labels.empty() || _partial->label);
+  if (!keep) {
+    _data.partials.pop_back();
+  }
+  _partial = nullptr;
+}
+
+template class BasicPartialHandler<double>;
+template class BasicPartialHandler<float>;
+
+//
+// harmonic relative documents
+//
+
+namespace
+{
+
+bool _loadsTimeForHarmonics(const ReadOptions& options)
+{
+  const auto& selected = options.parameters;
+  auto has = [&](const char* name) {
+    return std::find(selected.begin(), selected.end(), name) != selected.end();
+  };
+  return !options.harmonicRelative && !selected.empty() && has(kFrequencyName) &&
+         !has(kTimeName);
+}
+
+}  // namespace
+
+ReadOptions harmonicReadOptions(const ReadOptions& requested)
+{
+  ReadOptions options = requested;
+  if (_loadsTimeForHarmonics(requested)) {
+    options.parameters.push_back(kTimeName);
+  }
+  return options;
+}
+
+template <typename SampleType>
+void restoreHarmonics(BasicPartialData<SampleType>& data, const ReadOptions& requested)
+{
+  if (!requested.harmonicRelative) {
+    makeHarmonicAbsolute(data);
+  }
+
+  if (_loadsTimeForHarmonics(requested)) {
+    auto& parameters = data.parameters;
+    parameters.erase(std::remove(parameters.begin(), parameters.end(), kTimeName),
+                     parameters.end());
+    for (auto& p : data.partials) {
+      p.parameters.erase(kTimeName);
+    }
+  }
+}
+
+template void restoreHarmonics(PartialData& data, const ReadOptions& requested);
+template void restoreHarmonics(FloatPartialData& data, const ReadOptions& requested);
+
+}  // namespace utu
@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+#include <cstdint>
+#include <memory_resource>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "SerializerImpl.h"
+
+namespace utu
+{
+
+// SAX event handler which builds PartialData directly from the token stream
+// without materializing a json DOM first. Parameters and partials excluded by
+// the read options are skipped as they are parsed. Samples are narrowed to
+// SampleType as they are parsed; base64 encoded envelopes are decoded
+// directly into the envelope storage.
+template <typename SampleType>
+class BasicPartialHandler final
+{
+ public:
+  using Data = BasicPartialData<SampleType>;
+
+  using json = nlohmann::json;
+  using number_integer_t = json::number_integer_t;
+  using number_unsigned_t = json::number_unsigned_t;
+  using number_float_t = json::number_float_t;
+  using string_t = json::string_t;
+  using binary_t = json::binary_t;
+
+  enum class Document {
+    // a complete partial data document
+    Data,
+    // a sequence of partial objects, such as the body lines of a ".utul" file;
+    // each is parsed separately and appended to the result
+    Partials,
+    // a complete partial data document of which only the fields preceding
+    // the partials are parsed; parsing stops at the partials
+    Header,
+  };
+
+  BasicPartialHandler(const ReadOptions& options, std::pmr::memory_resource* resource,
+                      Document document = Document::Data);
+
+  // nlohmann::json_sax interface
+  bool null();
+  bool boolean(bool value);
+  bool number_integer(number_integer_t value);
+  bool number_unsigned(number_unsigned_t value);
+  bool number_float(number_float_t value, const string_t& s);
+  bool string(string_t& value);
+  bool binary(binary_t& value);
+  bool start_object(std::size_t elements);
+  bool key(string_t& value);
+  bool end_object();
+  bool start_array(std::size_t elements);
+  bool end_array();
+  bool parse_error(std::size_t position, const std::string& lastToken,
+                   const nlohmann::detail::exception& ex);
+
+  const FileInfo& fileInfo() const { return _info; }
+
+  // The parsed data, no value if the document was not an object.
+  std::optional<Data> result();
+
+ private:
+  enum class Context {
+    Root,
+    FileInfo,
+    Summary,
+    SummaryRanges,
+    SummaryRange,
+    Source,
+    Fundamental,
+    FundamentalSamples,
+    Markers,
+    Marker,
+    Parameters,
+    Partials,
+    PartialObject,
+    PartialParameters,
+    Samples,
+  };
+
+  bool _in(Context context) const;
+  bool _number(double value);
+  bool _skipValue();
+  bool _selected(const std::string& parameter) const;
+  void _startSamples(const std::string& parameter);
+  void _decodeSamples(const std::string& parameter, const std::string& text);
+  void _endSamples();
+  void _endPartial();
+
+  const ReadOptions& _options;
+  Document _document;
+  bool _needTime;
+  bool _needAmplitude;
+
+  std::vector<Context> _stack;
+  std::size_t _skipDepth;
+  std::string _key;
+
+  bool _sawRoot;
+  FileInfo _info;
+  Data _data;
+
+  // [min, max] of the summary range being parsed
+  Summary::Range* _range;
+  std::size_t _rangeIndex;
+
+  // envelope of the fundamental track being parsed
+  std::vector<double>* _track;
+
+  // state for the partial currently being parsed, which is constructed in
+  // place at the end of the partials so it is allocated from the resource
+  typename Data::Partial* _partial;
+  bool _discard;
+  bool _sawTime;
+  bool _sawAmplitude;
+  std::string _samplesName;
+  typename Data::Partial::Samples* _samples;
+  std::vector<std::uint8_t> _bytes;  // decoded base64
+
+  // scratch envelopes needed to evaluate filters but not selected for loading
+  typename Data::Partial::Samples _filterTime;
+  typename Data::Partial::Samples _filterAmplitude;
+};
+
+using PartialHandler = BasicPartialHandler<double>;
+using FloatPartialHandler = BasicPartialHandler<float>;
+
+// Restoring absolute frequencies of harmonic relative documents needs time
+// envelopes; the options to parse with so they are loaded even if not
+// requested.
+ReadOptions harmonicReadOptions(const ReadOptions& requested);
+
+// Restore absolute frequencies of data parsed with harmonicReadOptions(),
+// unless requested otherwise, then drop envelopes which were only loaded to
+// do so.
+template <typename SampleType>
+void restoreHarmonics(BasicPartialData<SampleType>& data, const ReadOptions& requested);
+
+}  // namespace utu
@@ -4,18 +4,33 @@
 // SPDX-License-Identifier: MIT
 //
 
+#include <utu/Harmonic.h>
 #include <utu/PartialIO.h>
 
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include "Base64.h"
+#include "Parallel.h"
+#include "PartialHandler.h"
 #include "SerializerImpl.h"
 
 constexpr uint8_t kIndentWidth = 2;
 
-constexpr uint16_t kFileVersion = 1;
-constexpr char kFileKind[] = "utu-partial-data";
+// The partials are spliced into the dumped document frame in place of the
+// empty array; elements of the top level partials array are indented twice.
+constexpr char kPartialsPlaceholder[] = "\n  \"partials\": []";
+constexpr char kPartialIndent[] = "\n    ";
+
+// Documents with fewer samples than this are serialized on the calling thread
+constexpr size_t kParallelMinimumSamples = 1 << 18;
 
 namespace
 {
@@ -23,25 +38,267 @@ namespace
 using json = nlohmann::json;
 using namespace utu;
 
-std::optional<PartialData> _read(json& j)
+void _checkVersion(const FileInfo& info)
+{
+  if (info.kind == kFileKind && info.version > kFileVersion) {
+    throw std::runtime_error("unsupported " + info.kind + " version " +
+                             std::to_string(info.version));
+  }
+}
+
+template <typename T, typename InputType>
+std::optional<T> _read(InputType&& input, const ReadOptions& options,
+                       std::pmr::memory_resource* resource)
 {
-  FileInfo info = j["file_info"].get<FileInfo>();
+  ReadOptions parseOptions = harmonicReadOptions(options);
+  BasicPartialHandler<typename T::Partial::Sample> handler(parseOptions, resource);
+  json::sax_parse(std::forward<InputType>(input), &handler, json::input_format_t::json,
+                  true /* strict */, true /* allow comments */);
+  _checkVersion(handler.fileInfo());
+
+  std::optional<T> result = handler.result();
+  if (result) {
+    restoreHarmonics(*result, options);
+  }
+  return result;
+}
 
-  // TODO: validate header and choose the appropriate version of the PartialData
-  // structure to read.
+json::input_format_t _inputFormat(BinaryFormat format)
+{
+  return format == BinaryFormat::Cbor ? json::input_format_t::cbor : json::input_format_t::msgpack;
+}
 
-  PartialData data = j;
-  std::optional<PartialData> result(data);
+template <typename InputType, typename Handler>
+void _parseBinary(InputType&& input, BinaryFormat format, Handler& handler)
+{
+  json::sax_parse(std::forward<InputType>(input), &handler, _inputFormat(format),
+                  true /* strict */);
+}
 
+template <typename T, typename InputType>
+std::optional<T> _readBinary(InputType&& input, BinaryFormat format, const ReadOptions& options)
+{
+  ReadOptions parseOptions = harmonicReadOptions(options);
+  BasicPartialHandler<typename T::Partial::Sample> handler(parseOptions,
+                                                           std::pmr::get_default_resource());
+  _parseBinary(std::forward<InputType>(input), format, handler);
+  _checkVersion(handler.fileInfo());
+
+  std::optional<T> result = handler.result();
+  if (result) {
+    restoreHarmonics(*result, options);
+  }
   return result;
 }
 
-void _addFileInfo(json& j)
+// Parse the fields up to the partials with the given parse function.
+template <typename Parse>
+std::optional<PartialHeader> _readHeader(Parse&& parse)
+{
+  ReadOptions options;
+  PartialHandler handler(options, std::pmr::get_default_resource(),
+                         PartialHandler::Document::Header);
+  parse(handler);
+  _checkVersion(handler.fileInfo());
+
+  std::optional<PartialData> data = handler.result();
+  if (!data) {
+    return {};
+  }
+
+  PartialHeader header;
+  header.kind = handler.fileInfo().kind;
+  header.version = handler.fileInfo().version;
+  header.fields = std::move(*data);
+  header.summary = handler.fileInfo().summary;
+  return header;
+}
+
+void _addFileInfo(json& j, SampleEncoding encoding, std::optional<Summary> summary)
 {
   FileInfo info({kFileKind, kFileVersion});
+  info.summary = std::move(summary);
+  if (encoding == SampleEncoding::Base64Float64) {
+    info.encoding = kBase64Float64Encoding;
+  } else if (encoding == SampleEncoding::Base64Float32) {
+    info.encoding = kBase64Float32Encoding;
+  }
   j["file_info"] = info;
 }
 
+// The partial with every envelope as a base64 string.
+template <typename Json, typename Partial>
+Json _encodePartial(const Partial& p, SampleEncoding encoding, std::vector<uint8_t>& bytes)
+{
+  Json j;
+  if (p.label) {
+    j["label"] = *p.label;
+  }
+
+  Json& parameters = j["parameters"] = Json::object();
+  std::string text;
+  for (const auto& entry : p.parameters) {
+    const auto& samples = entry.second;
+    text.clear();
+    if (encoding == SampleEncoding::Base64Float64) {
+      encodeSamples<double>(samples.data(), samples.size(), bytes, text);
+    } else {
+      encodeSamples<float>(samples.data(), samples.size(), bytes, text);
+    }
+    parameters[entry.first] = text;
+  }
+  return j;
+}
+
+// Append partials [begin, end) formatted exactly as json::dump would at their
+// depth in the document.
+template <typename Partials>
+void _dumpPartials(const Partials& partials, size_t begin, size_t end, SampleEncoding encoding,
+                   std::string& out)
+{
+  using Json = BasicJson<typename Partials::value_type::Sample>;
+
+  std::string s;
+  std::vector<uint8_t> bytes;
+  for (size_t i = begin; i < end; ++i) {
+    if (encoding == SampleEncoding::Text) {
+      s = Json(partials[i]).dump(kIndentWidth);
+    } else {
+      s = _encodePartial<Json>(partials[i], encoding, bytes).dump(kIndentWidth);
+    }
+
+    out += kPartialIndent;
+    size_t from = 0;
+    for (size_t nl = s.find('\n'); nl != std::string::npos; nl = s.find('\n', from)) {
+      out.append(s, from, nl - from);
+      out += kPartialIndent;
+      from = nl + 1;
+    }
+    out.append(s, from, std::string::npos);
+
+    if (i + 1 < partials.size()) {
+      out += ',';
+    }
+  }
+}
+
+template <typename T>
+unsigned _threadCount(const T& value, const WriteOptions& options)
+{
+  size_t samples = 0;
+  for (const auto& p : value.partials) {
+    for (const auto& entry : p.parameters) {
+      samples += entry.second.size();
+    }
+  }
+  if (samples < kParallelMinimumSamples) {
+    return 1;
+  }
+  return threadCount(options.threads);
+}
+
+// The document with every envelope as a typed array of its samples.
+template <typename T>
+json _binaryDocument(const T& value, const WriteOptions& options)
+{
+  if (options.encoding != SampleEncoding::Text) {
+    throw std::invalid_argument("binary documents do not take a sample encoding");
+  }
+  if (options.harmonicRelative && !value.fundamental) {
+    T relative = value;
+    makeHarmonicRelative(relative);
+    if (relative.fundamental) {
+      return _binaryDocument(relative, options);
+    }
+  }
+
+  using Sample = typename T::Partial::Sample;
+
+  PartialData header;
+  static_cast<PartialDataHeader&>(header) = value;
+  json j = header;
+  _addFileInfo(j, SampleEncoding::Text,
+               options.summary ? std::optional<Summary>(summarize(value)) : std::nullopt);
+  j["file_info"]["encoding"] = sizeof(Sample) == 8 ? kFloat64Encoding : kFloat32Encoding;
+
+  json& partials = j["partials"];
+  std::vector<uint8_t> bytes;
+  for (const auto& p : value.partials) {
+    json& partial = partials.emplace_back(json::object());
+    if (p.label) {
+      partial["label"] = *p.label;
+    }
+    json& parameters = partial["parameters"] = json::object();
+    for (const auto& entry : p.parameters) {
+      packSamples<Sample>(entry.second.data(), entry.second.size(), bytes);
+      parameters[entry.first] = json::binary(bytes);
+    }
+  }
+  return j;
+}
+
+// Serialize the document passing the text to emit in order. The frame around
+// the partials is produced by json::dump and the partials are dumped
+// individually, in parallel when large enough, so the output is identical to
+// dumping the whole document at once.
+template <typename T, typename Emit>
+void _write(const T& value, const WriteOptions& options, Emit&& emit)
+{
+  if (options.harmonicRelative && !value.fundamental) {
+    T relative = value;
+    makeHarmonicRelative(relative);
+    if (relative.fundamental) {
+      _write(relative, options, emit);
+      return;
+    }
+  }
+
+  // the header fields, which do not depend on the sample type
+  PartialData header;
+  static_cast<PartialDataHeader&>(header) = value;
+
+  json j = header;
+  _addFileInfo(j, options.encoding,
+               options.summary ? std::optional<Summary>(summarize(value)) : std::nullopt);
+  std::string frame = j.dump(kIndentWidth);
+
+  const auto& partials = value.partials;
+  size_t split = frame.find(kPartialsPlaceholder);
+  if (partials.empty() || split == std::string::npos) {
+    emit(frame);
+    return;
+  }
+
+  // up to, and including, the opening bracket of the partials
+  split += std::strlen(kPartialsPlaceholder) - 1;
+  emit(std::string_view(frame).substr(0, split));
+
+  unsigned threads = _threadCount(value, options);
+  if (threads <= 1) {
+    std::string chunk;
+    for (size_t i = 0; i < partials.size(); ++i) {
+      chunk.clear();
+      _dumpPartials(partials, i, i + 1, options.encoding, chunk);
+      emit(chunk);
+    }
+  } else {
+    // several chunks per thread to even out partials of differing length
+    size_t count = std::min<size_t>(partials.size(), threads * 4);
+    std::vector<std::string> chunks(count);
+    parallelFor(count, threads, [&](size_t c) {
+      _dumpPartials(partials, c * partials.size() / count, (c + 1) * partials.size() / count,
+                    options.encoding, chunks[c]);
+    });
+
+    for (const auto& chunk : chunks) {
+      emit(chunk);
+    }
+  }
+
+  emit("\n  ");
+  emit(std::string_view(frame).substr(split));
+}
+
 }  // namespace
 
 namespace utu
@@ -49,37 +306,162 @@ namespace utu
 
 using json = nlohmann::json;
 
-template <>
-std::optional<PartialData> PartialReader::read(const std::string& jsonData)
+template <typename T>
+Summary summarize(const T& data)
+{
+  Summary summary;
+  summary.partials = data.partials.size();
+  std::vector<double> frequencies;
+  for (const auto& p : data.partials) {
+    bool relative = data.fundamental && absoluteFrequencies(*data.fundamental, p, frequencies);
+    for (const auto& [name, samples] : p.parameters) {
+      if (samples.empty()) {
+        continue;
+      }
+      if (name == kTimeName) {
+        summary.breakpoints += samples.size();
+      }
+
+      Summary::Range range;
+      if (relative && name == kFrequencyName) {
+        auto [low, high] = std::minmax_element(frequencies.begin(), frequencies.end());
+        range = {*low, *high};
+      } else {
+        auto [low, high] = std::minmax_element(samples.begin(), samples.end());
+        range = {static_cast<double>(*low), static_cast<double>(*high)};
+      }
+      auto [it, inserted] = summary.ranges.try_emplace(name, range);
+      if (!inserted) {
+        it->second.min = std::min(it->second.min, range.min);
+        it->second.max = std::max(it->second.max, range.max);
+      }
+    }
+  }
+  if (data.source) {
+    summary.fingerprint = data.source->fingerprint;
+  }
+  return summary;
+}
+
+template Summary summarize(const PartialData& data);
+template Summary summarize(const FloatPartialData& data);
+
+std::optional<PartialHeader> PartialHeaderReader::read(std::istream& is)
+{
+  return _readHeader([&](auto& handler) {
+    json::sax_parse(is, &handler, json::input_format_t::json, true /* strict */,
+                    true /* allow comments */);
+  });
+}
+
+std::optional<PartialHeader> PartialHeaderReader::read(std::istream& is, BinaryFormat format)
+{
+  return _readHeader([&](auto& handler) { _parseBinary(is, format, handler); });
+}
+
+template <typename T>
+std::optional<T> Reader<T>::read(const std::string& jsonData)
+{
+  return _read<T>(jsonData, ReadOptions(), std::pmr::get_default_resource());
+}
+
+template <typename T>
+std::optional<T> Reader<T>::read(std::istream& is)
+{
+  return _read<T>(is, ReadOptions(), std::pmr::get_default_resource());
+}
+
+template <typename T>
+std::optional<T> Reader<T>::read(const std::string& jsonData, const ReadOptions& options)
+{
+  return _read<T>(jsonData, options, std::pmr::get_default_resource());
+}
+
+template <typename T>
+std::optional<T> Reader<T>::read(std::istream& is, const ReadOptions& options)
 {
-  json j = json::parse(jsonData, nullptr, true /* allow exceptions */, true /* allow comments */);
-  return _read(j);
+  return _read<T>(is, options, std::pmr::get_default_resource());
 }
 
-template <>
-std::optional<PartialData> PartialReader::read(std::istream& is)
+template <typename T>
+std::optional<T> Reader<T>::read(const std::string& jsonData, const ReadOptions& options,
+                                 std::pmr::memory_resource* resource)
 {
-  json j;
-  is >> j;
-  return _read(j);
+  return _read<T>(jsonData, options, resource);
 }
 
-template <>
-std::optional<std::string> PartialWriter::write(const PartialData& value)
+template <typename T>
+std::optional<T> Reader<T>::read(std::istream& is, const ReadOptions& options,
+                                 std::pmr::memory_resource* resource)
 {
-  json j = value;
-  _addFileInfo(j);
-  std::optional<std::string> result(j.dump(kIndentWidth));
+  return _read<T>(is, options, resource);
+}
+
+template <typename T>
+std::optional<T> Reader<T>::read(const std::vector<std::uint8_t>& data, BinaryFormat format,
+                                 const ReadOptions& options)
+{
+  return _readBinary<T>(data, format, options);
+}
+
+template <typename T>
+std::optional<T> Reader<T>::read(std::istream& is, BinaryFormat format, const ReadOptions& options)
+{
+  return _readBinary<T>(is, format, options);
+}
+
+template <typename T>
+std::optional<std::string> Writer<T>::write(const T& value, const WriteOptions& options)
+{
+  std::string result;
+  _write(value, options, [&](std::string_view s) { result.append(s); });
   return result;
 }
 
-template <>
-void PartialWriter::write(const PartialData& value, std::ostream& os)
+template <typename T>
+void Writer<T>::write(const T& value, std::ostream& os, const WriteOptions& options)
 {
   // TODO: better error reporting
-  json j = value;
-  _addFileInfo(j);
-  os << std::setw(kIndentWidth) << j << std::endl;
+  _write(value, options,
+         [&](std::string_view s) { os.write(s.data(), static_cast<std::streamsize>(s.size())); });
+  os << std::endl;
+}
+
+template <typename T>
+std::optional<std::string> Writer<T>::write(const T& value)
+{
+  return write(value, WriteOptions());
+}
+
+template <typename T>
+void Writer<T>::write(const T& value, std::ostream& os)
+{
+  write(value, os, WriteOptions());
 }
 
+template <typename T>
+std::vector<std::uint8_t> Writer<T>::write(const T& value, BinaryFormat format,
+                                           const WriteOptions& options)
+{
+  json j = _binaryDocument(value, options);
+  return format == BinaryFormat::Cbor ? json::to_cbor(j) : json::to_msgpack(j);
+}
+
+template <typename T>
+void Writer<T>::write(const T& value, std::ostream& os, BinaryFormat format,
+                      const WriteOptions& options)
+{
+  json j = _binaryDocument(value, options);
+  if (format == BinaryFormat::Cbor) {
+    json::to_cbor(j, os);
+  } else {
+    json::to_msgpack(j, os);
+  }
+}
+
+template struct Reader<PartialData>;
+template struct Reader<FloatPartialData>;
+template struct Writer<PartialData>;
+template struct Writer<FloatPartialData>;
+
 }  // namespace utu
\ No newline at end of file
@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Harmonic.h>
+#include <utu/PartialIO.h>
+
+#include <iterator>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "Parallel.h"
+#include "PartialHandler.h"
+#include "SerializerImpl.h"
+
+constexpr uint16_t kLinesVersion = 1;
+constexpr char kLinesKind[] = "utu-partial-lines";
+
+// Bodies smaller than this are parsed on the calling thread
+constexpr size_t kParallelMinimumBytes = 1 << 20;
+
+namespace
+{
+
+using json = nlohmann::json;
+using namespace utu;
+
+void _parse(std::string_view text, PartialHandler& handler)
+{
+  json::sax_parse(text.data(), text.data() + text.size(), &handler, json::input_format_t::json,
+                  true /* strict */, true /* allow comments */);
+}
+
+// Parse every non blank line in text as a partial.
+PartialData::Partials _parseLines(std::string_view text, const ReadOptions& options)
+{
+  PartialHandler handler(options, std::pmr::get_default_resource(),
+                         PartialHandler::Document::Partials);
+  while (!text.empty()) {
+    size_t eol = text.find('\n');
+    std::string_view line = text.substr(0, eol);
+    if (line.find_first_not_of(" \t\r") != std::string_view::npos) {
+      _parse(line, handler);
+    }
+    text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+  }
+  return std::move(handler.result()->partials);
+}
+
+// Split text into roughly equal parts ending on line boundaries.
+std::vector<std::string_view> _splitLines(std::string_view text, size_t parts)
+{
+  std::vector<std::string_view> result;
+  size_t target = text.size() / parts + 1;
+  while (!text.empty()) {
+    size_t eol = text.size() > target ? text.find('\n', target) : std::string_view::npos;
+    size_t length = eol == std::string_view::npos ? text.size() : eol + 1;
+    result.push_back(text.substr(0, length));
+    text.remove_prefix(length);
+  }
+  return result;
+}
+
+std::optional<PartialData> _readLines(std::string_view text, const ReadOptions& options,
+                                      unsigned threads)
+{
+  size_t eol = text.find('\n');
+  PartialHandler header(options, std::pmr::get_default_resource());
+  _parse(text.substr(0, eol), header);
+
+  std::optional<PartialData> data = header.result();
+  if (!data || eol == std::string_view::npos) {
+    return data;
+  }
+
+  std::string_view body = text.substr(eol + 1);
+  threads = body.size() < kParallelMinimumBytes ? 1 : threadCount(threads);
+  if (threads <= 1) {
+    data->partials = _parseLines(body, options);
+    return data;
+  }
+
+  // several chunks per thread to even out differences in line length
+  std::vector<std::string_view> chunks = _splitLines(body, threads * 4);
+  std::vector<PartialData::Partials> results(chunks.size());
+  parallelFor(chunks.size(), threads,
+              [&](size_t c) { results[c] = _parseLines(chunks[c], options); });
+
+  size_t count = 0;
+  for (const auto& r : results) {
+    count += r.size();
+  }
+  data->partials.reserve(count);
+  for (auto& r : results) {
+    std::move(r.begin(), r.end(), std::back_inserter(data->partials));
+  }
+  return data;
+}
+
+std::optional<PartialData> _read(std::string_view text, const ReadOptions& options,
+                                 unsigned threads)
+{
+  std::optional<PartialData> data = _readLines(text, harmonicReadOptions(options), threads);
+  if (data) {
+    restoreHarmonics(*data, options);
+  }
+  return data;
+}
+
+}  // namespace
+
+namespace utu
+{
+
+std::optional<PartialData> PartialLineReader::read(std::istream& is)
+{
+  return read(is, ReadOptions());
+}
+
+std::optional<PartialData> PartialLineReader::read(std::istream& is, const ReadOptions& options,
+                                                   unsigned threads)
+{
+  std::string text((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+  return _read(text, options, threads);
+}
+
+std::optional<PartialData> PartialLineReader::read(const std::string& lineData,
+                                                   const ReadOptions& options, unsigned threads)
+{
+  return _read(lineData, options, threads);
+}
+
+PartialLineWriter::PartialLineWriter(std::ostream& os, const PartialData& header) : _os(os)
+{
+  _writeHeader(header, {});
+}
+
+PartialLineWriter::PartialLineWriter(std::ostream& os) : _os(os) {}
+
+void PartialLineWriter::_writeHeader(const PartialData& header,
+                                     const std::optional<Summary>& summary)
+{
+  PartialData fields;
+  fields.description = header.description;
+  fields.source = header.source;
+  fields.markers = header.markers;
+  fields.fundamental = header.fundamental;
+  fields.parameters = header.parameters;
+
+  json j = fields;
+  j.erase("partials");
+  FileInfo info({kLinesKind, kLinesVersion});
+  info.summary = summary;
+  j["file_info"] = info;
+  _os << j.dump() << '\n';
+}
+
+void PartialLineWriter::append(const Partial& partial)
+{
+  _os << json(partial).dump() << '\n';
+}
+
+void PartialLineWriter::write(const PartialData& data, std::ostream& os,
+                              const WriteOptions& options)
+{
+  if (options.encoding != SampleEncoding::Text) {
+    throw std::invalid_argument("line delimited documents only support text encoding");
+  }
+  if (options.harmonicRelative && !data.fundamental) {
+    PartialData relative = data;
+    makeHarmonicRelative(relative);
+    if (relative.fundamental) {
+      write(relative, os, options);
+      return;
+    }
+  }
+
+  PartialLineWriter writer(os);
+  writer._writeHeader(data, options.summary ? std::optional<Summary>(summarize(data))
+                                            : std::nullopt);
+  for (const auto& p : data.partials) {
+    writer.append(p);
+  }
+  os.flush();
+}
+
+}  // namespace utu
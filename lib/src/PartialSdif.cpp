@@ -0,0 +1,677 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Envelope.h>
+#include <utu/Harmonic.h>
+#include <utu/PartialIO.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// SDIF is a chunked big endian format. After the file header every chunk
+// starts with a four character signature and a 32 bit size; frames follow
+// with a time, stream id and matrix count and then the matrices, each with
+// a header of signature, data type, rows and columns. Matrix data is row
+// major and padded to a multiple of 8 bytes.
+//
+
+namespace
+{
+
+using namespace utu;
+
+constexpr uint32_t _signature(const char (&s)[5])
+{
+  return uint32_t(uint8_t(s[0])) << 24 | uint32_t(uint8_t(s[1])) << 16 |
+         uint32_t(uint8_t(s[2])) << 8 | uint32_t(uint8_t(s[3]));
+}
+
+constexpr uint32_t kFileSignature = _signature("SDIF");
+constexpr uint32_t kTypesSignature = _signature("1TYP");
+constexpr uint32_t kNameValueSignature = _signature("1NVT");
+constexpr uint32_t kStreamIdSignature = _signature("1IDS");
+constexpr uint32_t kTracksSignature = _signature("1TRC");
+constexpr uint32_t kEnhancedSignature = _signature("RBEP");
+constexpr uint32_t kLabelsSignature = _signature("RBEL");
+constexpr uint32_t kMarkersSignature = _signature("RBEM");
+constexpr uint32_t kMarkerNamesSignature = _signature("RBEN");
+
+constexpr double kTwoPi = 2.0 * M_PI;
+
+constexpr uint32_t kSpecificationVersion = 3;
+constexpr uint32_t kStandardTypesVersion = 1;
+
+constexpr int32_t kFloat32 = 0x0004;
+constexpr int32_t kFloat64 = 0x0008;
+constexpr int32_t kText = 0x0301;
+
+constexpr size_t kFrameHeaderSize = 16;  // time, stream id, matrix count
+constexpr size_t kMatrixHeaderSize = 16;
+
+// columns of "RBEP" and "1TRC" matrices; "1TRC" stops after phase
+constexpr size_t kIndexColumn = 0;
+constexpr size_t kFrequencyColumn = 1;
+constexpr size_t kAmplitudeColumn = 2;
+constexpr size_t kPhaseColumn = 3;
+constexpr size_t kNoiseColumn = 4;
+constexpr size_t kTimeOffsetColumn = 5;
+
+constexpr char kTypeDeclarations[] =
+    "{\n"
+    "  1MTD RBEP {Index, Frequency, Amplitude, Phase, Noise, TimeOffset}\n"
+    "  1MTD RBEL {Index, Label}\n"
+    "  1MTD RBEM {Time}\n"
+    "  1MTD RBEN {Name}\n"
+    "  1FTD RBEP {RBEP reassignedBandwidthEnhancedPartials; RBEL partialLabels;}\n"
+    "  1FTD RBEM {RBEM markerTimes; RBEN markerNames;}\n"
+    "}\n";
+
+size_t _padded(size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+size_t _elementSize(int32_t dataType) { return static_cast<size_t>(dataType & 0xff); }
+
+class _Input
+{
+ public:
+  explicit _Input(std::istream& is) : _is(is) {}
+
+  bool bytes(void* dst, size_t count)
+  {
+    _is.read(static_cast<char*>(dst), static_cast<std::streamsize>(count));
+    return size_t(_is.gcount()) == count;
+  }
+
+  bool u32(uint32_t& v)
+  {
+    uint8_t b[4];
+    if (!bytes(b, sizeof(b))) {
+      return false;
+    }
+    v = uint32_t(b[0]) << 24 | uint32_t(b[1]) << 16 | uint32_t(b[2]) << 8 | uint32_t(b[3]);
+    return true;
+  }
+
+  bool i32(int32_t& v)
+  {
+    uint32_t u;
+    bool ok = u32(u);
+    v = static_cast<int32_t>(u);
+    return ok;
+  }
+
+  bool f64(double& v)
+  {
+    uint32_t hi, lo;
+    if (!u32(hi) || !u32(lo)) {
+      return false;
+    }
+    uint64_t u = uint64_t(hi) << 32 | lo;
+    std::memcpy(&v, &u, sizeof(v));
+    return true;
+  }
+
+  bool f32(float& v)
+  {
+    uint32_t u;
+    if (!u32(u)) {
+      return false;
+    }
+    std::memcpy(&v, &u, sizeof(v));
+    return true;
+  }
+
+  bool skip(size_t count)
+  {
+    _is.ignore(static_cast<std::streamsize>(count));
+    return size_t(_is.gcount()) == count;
+  }
+
+ private:
+  std::istream& _is;
+};
+
+class _Output
+{
+ public:
+  explicit _Output(std::ostream& os) : _os(os) {}
+
+  void bytes(const void* src, size_t count)
+  {
+    _os.write(static_cast<const char*>(src), static_cast<std::streamsize>(count));
+  }
+
+  void u32(uint32_t v)
+  {
+    uint8_t b[4] = {uint8_t(v >> 24), uint8_t(v >> 16), uint8_t(v >> 8), uint8_t(v)};
+    bytes(b, sizeof(b));
+  }
+
+  void i32(int32_t v) { u32(static_cast<uint32_t>(v)); }
+
+  void f64(double v)
+  {
+    uint64_t u;
+    std::memcpy(&u, &v, sizeof(u));
+    u32(uint32_t(u >> 32));
+    u32(uint32_t(u));
+  }
+
+  void pad(size_t bytes)
+  {
+    static const char zeros[8] = {};
+    this->bytes(zeros, _padded(bytes) - bytes);
+  }
+
+  void frameHeader(uint32_t signature, size_t matrixBytes, double time, int32_t matrices)
+  {
+    u32(signature);
+    i32(static_cast<int32_t>(kFrameHeaderSize + matrixBytes));
+    f64(time);
+    i32(0);  // stream id
+    i32(matrices);
+  }
+
+  void matrix(uint32_t signature, const std::vector<double>& values, size_t columns)
+  {
+    u32(signature);
+    i32(kFloat64);
+    i32(static_cast<int32_t>(values.size() / columns));
+    i32(static_cast<int32_t>(columns));
+    for (double v : values) {
+      f64(v);
+    }
+    pad(values.size() * sizeof(double));
+  }
+
+  void textMatrix(uint32_t signature, const std::string& text)
+  {
+    u32(signature);
+    i32(kText);
+    i32(static_cast<int32_t>(text.size()));
+    i32(1);
+    bytes(text.data(), text.size());
+    pad(text.size());
+  }
+
+ private:
+  std::ostream& _os;
+};
+
+size_t _matrixBytes(size_t values) { return kMatrixHeaderSize + _padded(values * sizeof(double)); }
+
+// A partial being assembled from the rows of successive frames
+struct Track {
+  Partial::Samples time;
+  Partial::Samples frequency;
+  Partial::Samples amplitude;
+  Partial::Samples bandwidth;
+  Partial::Samples phase;
+};
+
+// Read the values of a numeric matrix as doubles
+bool _readValues(_Input& in, int32_t dataType, size_t count, std::vector<double>& values)
+{
+  values.resize(count);
+  for (size_t i = 0; i < count; ++i) {
+    if (dataType == kFloat64) {
+      if (!in.f64(values[i])) {
+        return false;
+      }
+    } else {
+      float f;
+      if (!in.f32(f)) {
+        return false;
+      }
+      values[i] = static_cast<double>(f);
+    }
+  }
+  return in.skip(_padded(count * _elementSize(dataType)) - count * _elementSize(dataType));
+}
+
+// The envelope for a parameter or nullptr if the partial does not have one
+const Partial::Samples* _envelope(const Partial& p, const char* name)
+{
+  auto it = p.parameters.find(name);
+  return it == p.parameters.end() ? nullptr : &it->second;
+}
+
+double _at(const Partial::Samples* envelope, size_t i)
+{
+  return envelope && i < envelope->size() ? (*envelope)[i] : 0.0;
+}
+
+// The median interval between breakpoints, the analysis hop time for
+// partials straight from an analysis, or 0 if no partial has two.
+double _frameHop(const PartialData& data)
+{
+  std::vector<double> intervals;
+  for (const auto& p : data.partials) {
+    const Partial::Samples* time = _envelope(p, kTimeName);
+    for (size_t i = 1; time && i < time->size(); ++i) {
+      if ((*time)[i] > (*time)[i - 1]) {
+        intervals.push_back((*time)[i] - (*time)[i - 1]);
+      }
+    }
+  }
+  if (intervals.empty()) {
+    return 0.0;
+  }
+  auto middle = intervals.begin() + static_cast<std::ptrdiff_t>(intervals.size() / 2);
+  std::nth_element(intervals.begin(), middle, intervals.end());
+  return *middle;
+}
+
+// Phase of the partial at time t, advanced from the nearest earlier
+// breakpoint by the mean frequency over the interval.
+double _phaseAt(const Partial::Samples& time, const Partial::Samples* frequency,
+                const Partial::Samples* phase, double f, double t)
+{
+  auto j = static_cast<size_t>(std::upper_bound(time.begin(), time.end(), t) - time.begin());
+  j = j == 0 ? 0 : j - 1;
+  double dt = t - time[j];
+  double advanced = _at(phase, j) + kTwoPi * 0.5 * (_at(frequency, j) + f) * dt;
+  return std::remainder(advanced, kTwoPi);
+}
+
+// Write "1TRC" frames on a grid spaced by the frame hop from the earliest
+// breakpoint, each listing every track live at its time with parameters
+// interpolated between breakpoints. Partials spanning no grid time are
+// written to the nearest frame. Frames are written as they are reached, only
+// the rows of one frame and a cursor per live partial are held.
+template <typename WriteFrame>
+void _writeTracks(const PartialData& data, std::vector<double>& rows, WriteFrame writeFrame)
+{
+  double start = std::numeric_limits<double>::infinity();
+  for (const auto& p : data.partials) {
+    const Partial::Samples* time = _envelope(p, kTimeName);
+    if (time && !time->empty()) {
+      start = std::min(start, time->front());
+    }
+  }
+  if (!std::isfinite(start)) {
+    return;
+  }
+
+  // without intervals every partial is a single breakpoint at its own time
+  double hop = _frameHop(data);
+  auto frameAt = [&](double t, bool up) {
+    double x = (t - start) / hop;
+    constexpr double kTolerance = 1e-9;
+    return static_cast<size_t>(std::max(0.0, up ? std::ceil(x - kTolerance)
+                                                : std::floor(x + kTolerance)));
+  };
+
+  // the frames spanned by each partial in order of the first
+  struct Span {
+    size_t first;
+    size_t last;
+    size_t partial;
+  };
+  std::vector<Span> spans;
+  for (size_t i = 0; i < data.partials.size(); ++i) {
+    const Partial::Samples* time = _envelope(data.partials[i], kTimeName);
+    if (!time || time->empty()) {
+      continue;
+    }
+    Span span = {0, 0, i};
+    if (hop > 0) {
+      span.first = frameAt(time->front(), true);
+      span.last = frameAt(time->back(), false);
+      if (span.first > span.last) {
+        span.first = span.last =
+            static_cast<size_t>(std::max(0.0, std::round((time->front() - start) / hop)));
+      }
+    }
+    spans.push_back(span);
+  }
+
+  // frames are the distinct breakpoint times in order when there is no hop
+  std::vector<double> frameTimes;
+  auto front = [&](const Span& span) {
+    return _envelope(data.partials[span.partial], kTimeName)->front();
+  };
+  if (hop > 0) {
+    std::stable_sort(spans.begin(), spans.end(),
+                     [](const Span& x, const Span& y) { return x.first < y.first; });
+  } else {
+    std::stable_sort(spans.begin(), spans.end(),
+                     [&](const Span& x, const Span& y) { return front(x) < front(y); });
+    for (auto& span : spans) {
+      if (frameTimes.empty() || frameTimes.back() != front(span)) {
+        frameTimes.push_back(front(span));
+      }
+      span.first = span.last = frameTimes.size() - 1;
+    }
+  }
+
+  // partials live at the current frame by partial index, so rows are in
+  // partial order
+  struct Live {
+    size_t last;
+    EnvelopeCursor cursor;
+    const Partial::Samples* time;
+    const Partial::Samples* frequency;
+    const Partial::Samples* phase;
+  };
+  std::map<size_t, Live> live;
+  const std::vector<std::string> parameters = {kFrequencyName, kAmplitudeName};
+
+  size_t next = 0;
+  size_t frame = 0;
+  while (next < spans.size() || !live.empty()) {
+    if (live.empty()) {
+      frame = spans[next].first;  // skip frames without partials
+    }
+    for (; next < spans.size() && spans[next].first == frame; ++next) {
+      const Partial& p = data.partials[spans[next].partial];
+      live.emplace(spans[next].partial,
+                   Live{spans[next].last, EnvelopeCursor(p, parameters), _envelope(p, kTimeName),
+                        _envelope(p, kFrequencyName), _envelope(p, kPhaseName)});
+    }
+
+    double time = hop > 0 ? start + static_cast<double>(frame) * hop : frameTimes[frame];
+    rows.clear();
+    for (auto it = live.begin(); it != live.end();) {
+      Live& l = it->second;
+      double frequency, amplitude;
+      double* outputs[] = {&frequency, &amplitude};
+      l.cursor.evaluate(&time, 1, outputs);
+      rows.push_back(static_cast<double>(it->first));
+      rows.push_back(frequency);
+      rows.push_back(amplitude);
+      rows.push_back(_phaseAt(*l.time, l.frequency, l.phase, frequency, time));
+      it = l.last == frame ? live.erase(it) : std::next(it);
+    }
+    writeFrame(time);
+    ++frame;
+  }
+}
+
+}  // namespace
+
+namespace utu
+{
+
+std::optional<PartialData> PartialSdifReader::read(std::istream& is)
+{
+  _Input in(is);
+
+  uint32_t signature;
+  int32_t size;
+  if (!in.u32(signature) || signature != kFileSignature || !in.i32(size) ||
+      !in.skip(size_t(std::max(size, 0)))) {
+    return {};
+  }
+
+  // SDIF indices may be reused once a track has ended. A "1TRC" frame lists
+  // every live track so an index missing from one ends its track, "RBEP"
+  // frames only list the partials with a breakpoint there so an index ends
+  // its track when its rows stop advancing in time.
+  std::vector<Track> tracks;
+  std::vector<int64_t> trackIndices;              // SDIF index of each track
+  std::unordered_map<int64_t, size_t> trackIndex;  // SDIF index to its current track
+  std::unordered_map<int64_t, size_t> lastFrame;   // SDIF index to the last "1TRC" frame
+  size_t sinusoidalFrames = 0;
+  std::unordered_map<int64_t, int64_t> labels;
+  std::vector<double> markerTimes;
+  std::string markerNames;
+  std::vector<double> values;
+
+  while (in.u32(signature) && in.i32(size)) {
+    auto frameSize = size_t(std::max(size, 0));
+    if (signature == kTypesSignature || signature == kNameValueSignature ||
+        signature == kStreamIdSignature || frameSize < kFrameHeaderSize) {
+      in.skip(frameSize);
+      continue;
+    }
+
+    double time;
+    int32_t streamId, matrixCount;
+    if (!in.f64(time) || !in.i32(streamId) || !in.i32(matrixCount)) {
+      break;
+    }
+    size_t consumed = kFrameHeaderSize;
+
+    for (int32_t m = 0; m < matrixCount; ++m) {
+      uint32_t matrixSignature;
+      int32_t dataType, rows, columns;
+      if (!in.u32(matrixSignature) || !in.i32(dataType) || !in.i32(rows) || !in.i32(columns)) {
+        return {};
+      }
+      auto rowCount = size_t(std::max(rows, 0));
+      auto columnCount = size_t(std::max(columns, 0));
+      size_t dataBytes = _padded(rowCount * columnCount * _elementSize(dataType));
+      consumed += kMatrixHeaderSize + dataBytes;
+
+      bool numeric = dataType == kFloat32 || dataType == kFloat64;
+      bool partialRows = (matrixSignature == kEnhancedSignature ||
+                          matrixSignature == kTracksSignature) &&
+                         columnCount > kPhaseColumn;
+      bool enhanced = matrixSignature == kEnhancedSignature;
+
+      if (numeric && partialRows) {
+        if (!_readValues(in, dataType, rowCount * columnCount, values)) {
+          return {};
+        }
+        if (!enhanced) {
+          ++sinusoidalFrames;
+        }
+        for (size_t r = 0; r < rowCount; ++r) {
+          const double* row = &values[r * columnCount];
+          auto index = static_cast<int64_t>(std::llround(row[kIndexColumn]));
+          double offset = enhanced && columnCount > kTimeOffsetColumn ? row[kTimeOffsetColumn] : 0;
+
+          auto it = trackIndex.find(index);
+          bool ended = it != trackIndex.end() &&
+                       (enhanced ? !(time + offset > tracks[it->second].time.back())
+                                 : lastFrame[index] + 1 < sinusoidalFrames);
+          if (it == trackIndex.end() || ended) {
+            it = trackIndex.insert_or_assign(index, tracks.size()).first;
+            tracks.emplace_back();
+            trackIndices.push_back(index);
+          }
+          if (!enhanced) {
+            lastFrame[index] = sinusoidalFrames;
+          }
+
+          Track& t = tracks[it->second];
+          t.time.push_back(time + offset);
+          t.frequency.push_back(row[kFrequencyColumn]);
+          t.amplitude.push_back(row[kAmplitudeColumn]);
+          t.phase.push_back(row[kPhaseColumn]);
+          t.bandwidth.push_back(enhanced && columnCount > kNoiseColumn ? row[kNoiseColumn] : 0);
+        }
+      } else if (numeric && matrixSignature == kLabelsSignature && columnCount >= 2) {
+        if (!_readValues(in, dataType, rowCount * columnCount, values)) {
+          return {};
+        }
+        for (size_t r = 0; r < rowCount; ++r) {
+          labels[std::llround(values[r * columnCount])] =
+              std::llround(values[r * columnCount + 1]);
+        }
+      } else if (numeric && matrixSignature == kMarkersSignature && columnCount >= 1) {
+        if (!_readValues(in, dataType, rowCount * columnCount, values)) {
+          return {};
+        }
+        for (size_t r = 0; r < rowCount; ++r) {
+          markerTimes.push_back(values[r * columnCount]);
+        }
+      } else if (dataType == kText && matrixSignature == kMarkerNamesSignature) {
+        std::string text(dataBytes, '\0');
+        if (!in.bytes(text.data(), dataBytes)) {
+          return {};
+        }
+        text.resize(rowCount * columnCount);
+        markerNames += text;
+      } else if (!in.skip(dataBytes)) {
+        return {};
+      }
+    }
+
+    if (frameSize > consumed) {
+      in.skip(frameSize - consumed);
+    }
+  }
+
+  PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName, kBandwidthName, kPhaseName};
+
+  // marker names are NUL separated in marker order
+  size_t nameStart = 0;
+  for (double t : markerTimes) {
+    size_t nameEnd = std::min(markerNames.find('\0', nameStart), markerNames.size());
+    data.markers.push_back({t, markerNames.substr(nameStart, nameEnd - nameStart)});
+    nameStart = std::min(nameEnd + 1, markerNames.size());
+  }
+
+  data.partials.reserve(tracks.size());
+  for (size_t i = 0; i < tracks.size(); ++i) {
+    Partial& p = data.partials.emplace_back();
+    auto label = labels.find(trackIndices[i]);
+    if (label != labels.end() && label->second != 0) {
+      p.label = std::to_string(label->second);
+    }
+    p.parameters[kTimeName] = std::move(tracks[i].time);
+    p.parameters[kFrequencyName] = std::move(tracks[i].frequency);
+    p.parameters[kAmplitudeName] = std::move(tracks[i].amplitude);
+    p.parameters[kBandwidthName] = std::move(tracks[i].bandwidth);
+    p.parameters[kPhaseName] = std::move(tracks[i].phase);
+  }
+
+  return data;
+}
+
+void PartialSdifWriter::write(const PartialData& data, std::ostream& os, Type type)
+{
+  // SDIF has no place for the fundamental track
+  if (data.fundamental) {
+    PartialData absolute = data;
+    makeHarmonicAbsolute(absolute);
+    write(absolute, os, type);
+    return;
+  }
+
+  _Output out(os);
+
+  out.u32(kFileSignature);
+  out.i32(8);
+  out.u32(kSpecificationVersion);
+  out.u32(kStandardTypesVersion);
+
+  size_t declarations = std::strlen(kTypeDeclarations);
+  out.u32(kTypesSignature);
+  out.i32(static_cast<int32_t>(_padded(declarations)));
+  out.bytes(kTypeDeclarations, declarations);
+  out.pad(declarations);
+
+  if (!data.markers.empty()) {
+    std::vector<double> times;
+    std::string names;
+    for (const auto& m : data.markers) {
+      times.push_back(m.time);
+      names += m.name;
+      names += '\0';
+    }
+    out.frameHeader(kMarkersSignature,
+                    _matrixBytes(times.size()) + kMatrixHeaderSize + _padded(names.size()), 0.0,
+                    2);
+    out.matrix(kMarkersSignature, times, 1);
+    out.textMatrix(kMarkerNamesSignature, names);
+  }
+
+  bool enhanced = type == Type::BandwidthEnhanced;
+  uint32_t frameSignature = enhanced ? kEnhancedSignature : kTracksSignature;
+  size_t columns = enhanced ? kTimeOffsetColumn + 1 : kPhaseColumn + 1;
+
+  struct Envelopes {
+    const Partial::Samples* time;
+    const Partial::Samples* frequency;
+    const Partial::Samples* amplitude;
+    const Partial::Samples* bandwidth;
+    const Partial::Samples* phase;
+  };
+
+  std::vector<Envelopes> envelopes;
+  std::vector<double> labels;
+  for (size_t i = 0; i < data.partials.size(); ++i) {
+    const Partial& p = data.partials[i];
+    envelopes.push_back({_envelope(p, kTimeName), _envelope(p, kFrequencyName),
+                         _envelope(p, kAmplitudeName), _envelope(p, kBandwidthName),
+                         _envelope(p, kPhaseName)});
+    if (p.label) {
+      long label = std::strtol(p.label->c_str(), nullptr, 10);
+      if (label != 0) {
+        labels.push_back(static_cast<double>(i));
+        labels.push_back(static_cast<double>(label));
+      }
+    }
+  }
+
+  // labels ride along with the first frame
+  std::vector<double> rows;
+  auto writeFrame = [&](double time) {
+    bool withLabels = !labels.empty();
+    size_t bytes = _matrixBytes(rows.size()) + (withLabels ? _matrixBytes(labels.size()) : 0);
+    out.frameHeader(frameSignature, bytes, time, withLabels ? 2 : 1);
+    out.matrix(frameSignature, rows, columns);
+    if (withLabels) {
+      out.matrix(kLabelsSignature, labels, 2);
+      labels.clear();
+    }
+  };
+
+  if (!enhanced) {
+    _writeTracks(data, rows, writeFrame);
+    os.flush();
+    return;
+  }
+
+  // merge the breakpoints of all partials in time order, one frame per
+  // distinct breakpoint time with rows ordered by partial index
+  using Cursor = std::pair<double, std::pair<size_t, size_t>>;  // time, (partial, breakpoint)
+  std::priority_queue<Cursor, std::vector<Cursor>, std::greater<Cursor>> queue;
+  for (size_t i = 0; i < envelopes.size(); ++i) {
+    if (envelopes[i].time && !envelopes[i].time->empty()) {
+      queue.push({envelopes[i].time->front(), {i, 0}});
+    }
+  }
+
+  while (!queue.empty()) {
+    double time = queue.top().first;
+    rows.clear();
+    while (!queue.empty() && queue.top().first == time) {
+      auto [partial, breakpoint] = queue.top().second;
+      queue.pop();
+
+      const Envelopes& e = envelopes[partial];
+      rows.push_back(static_cast<double>(partial));
+      rows.push_back(_at(e.frequency, breakpoint));
+      rows.push_back(_at(e.amplitude, breakpoint));
+      rows.push_back(_at(e.phase, breakpoint));
+      rows.push_back(_at(e.bandwidth, breakpoint));
+      rows.push_back(0.0);  // time offset, frames are at exact breakpoint times
+
+      if (++breakpoint < e.time->size()) {
+        queue.push({(*e.time)[breakpoint], {partial, breakpoint}});
+      }
+    }
+    writeFrame(time);
+  }
+
+  os.flush();
+}
+
+}  // namespace utu
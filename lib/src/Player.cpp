@@ -0,0 +1,282 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <utu/Player.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace
+{
+
+constexpr double kTwoPi = 2.0 * M_PI;
+
+}  // namespace
+
+namespace utu
+{
+
+template <typename SampleType>
+BasicPartialPlayer<SampleType>::BasicPartialPlayer(const Data& data, const PlayerOptions& options)
+    : _options(options), _rampStep(1.0), _serial(0), _endTime(0)
+{
+  if (!(options.sampleRate > 0)) {
+    throw std::invalid_argument("player sample rate must be greater than 0");
+  }
+  if (options.voices == 0 || options.blockSize == 0) {
+    throw std::invalid_argument("player voices and block size must be greater than 0");
+  }
+  if (data.fundamental) {
+    // voices evaluate the envelopes of data in place
+    throw std::invalid_argument("player requires absolute frequencies, see makeHarmonicAbsolute");
+  }
+  if (options.rampTime > 0) {
+    _rampStep = std::min(1.0, 1.0 / (options.rampTime * options.sampleRate));
+  }
+
+  for (const auto& p : data.partials) {
+    auto time = p.parameters.find(kTimeName);
+    if (time == p.parameters.end() || time->second.empty()) {
+      _startTimes.push_back(std::numeric_limits<double>::infinity());
+      _endTimes.push_back(-std::numeric_limits<double>::infinity());
+    } else {
+      _startTimes.push_back(static_cast<double>(time->second.front()));
+      _endTimes.push_back(static_cast<double>(time->second.back()));
+      _endTime = std::max(_endTime, _endTimes.back());
+    }
+  }
+
+  const std::vector<std::string> parameters = {kFrequencyName, kAmplitudeName};
+  // stolen voices release alongside their replacements
+  _voices.resize(2 * options.voices);
+  for (auto& voice : _voices) {
+    voice.phases.assign(data.partials.size(), 0.0);
+    voice.cursors.reserve(data.partials.size());
+    for (const auto& p : data.partials) {
+      voice.cursors.emplace_back(p, parameters);
+    }
+  }
+
+  _events.reserve(options.events);
+  _times.resize(options.blockSize);
+  _levels.resize(options.blockSize);
+  _frequency.resize(options.blockSize);
+  _amplitude.resize(options.blockSize);
+}
+
+template <typename SampleType>
+bool BasicPartialPlayer<SampleType>::noteOn(int id, const VoiceParameters& parameters,
+                                            std::size_t offset)
+{
+  return _queue({offset, Event::Type::NoteOn, id, parameters, VoiceParameter::Gain, 0});
+}
+
+template <typename SampleType>
+bool BasicPartialPlayer<SampleType>::noteOff(int id, std::size_t offset)
+{
+  return _queue({offset, Event::Type::NoteOff, id, {}, VoiceParameter::Gain, 0});
+}
+
+template <typename SampleType>
+bool BasicPartialPlayer<SampleType>::set(int id, VoiceParameter parameter, double value,
+                                         std::size_t offset)
+{
+  return _queue({offset, Event::Type::Set, id, {}, parameter, value});
+}
+
+template <typename SampleType>
+void BasicPartialPlayer<SampleType>::render(double* output, std::size_t frames)
+{
+  std::fill(output, output + frames, 0.0);
+
+  std::size_t next = 0;
+  std::size_t done = 0;
+  while (done < frames) {
+    while (next < _events.size() && _events[next].offset <= done) {
+      _apply(_events[next++]);
+    }
+
+    // render up to the next event so it lands on its exact frame
+    std::size_t end = std::min(frames, done + _options.blockSize);
+    if (next < _events.size()) {
+      end = std::min(end, _events[next].offset);
+    }
+    for (auto& voice : _voices) {
+      if (voice.active) {
+        _renderVoice(voice, output + done, end - done);
+      }
+    }
+    done = end;
+  }
+
+  // events beyond this call are kept relative to the next
+  std::size_t kept = 0;
+  for (; next < _events.size(); ++next) {
+    _events[kept] = _events[next];
+    _events[kept++].offset -= frames;
+  }
+  _events.erase(_events.begin() + static_cast<std::ptrdiff_t>(kept), _events.end());
+}
+
+template <typename SampleType>
+std::size_t BasicPartialPlayer<SampleType>::activeVoices() const
+{
+  return static_cast<std::size_t>(
+      std::count_if(_voices.begin(), _voices.end(), [](const Voice& v) { return v.active; }));
+}
+
+template <typename SampleType>
+bool BasicPartialPlayer<SampleType>::_queue(const Event& event)
+{
+  if (_events.size() >= _options.events) {
+    return false;
+  }
+
+  // insertion keeps events with the same offset in the order queued
+  _events.push_back(event);
+  for (std::size_t i = _events.size() - 1; i > 0 && _events[i - 1].offset > event.offset; --i) {
+    std::swap(_events[i - 1], _events[i]);
+  }
+  return true;
+}
+
+template <typename SampleType>
+void BasicPartialPlayer<SampleType>::_apply(const Event& event)
+{
+  switch (event.type) {
+    case Event::Type::NoteOn: {
+      auto sounding = [](const Voice& v) { return v.active && !v.releasing; };
+      if (static_cast<std::size_t>(std::count_if(_voices.begin(), _voices.end(), sounding)) >=
+          _options.voices) {
+        // release the oldest note rather than cutting it off
+        auto oldest = _voices.end();
+        for (auto v = _voices.begin(); v != _voices.end(); ++v) {
+          if (sounding(*v) && (oldest == _voices.end() || v->serial < oldest->serial)) {
+            oldest = v;
+          }
+        }
+        oldest->releasing = true;
+      }
+
+      auto voice = std::find_if(_voices.begin(), _voices.end(),
+                                [](const Voice& v) { return !v.active; });
+      if (voice == _voices.end()) {
+        // every other voice is releasing, cut short the quietest
+        voice = std::min_element(
+            _voices.begin(), _voices.end(),
+            [](const Voice& a, const Voice& b) { return a.level < b.level; });
+      }
+
+      voice->active = true;
+      voice->releasing = false;
+      voice->id = event.id;
+      voice->serial = ++_serial;
+      voice->level = 0;
+      std::fill(voice->phases.begin(), voice->phases.end(), 0.0);
+      for (auto& cursor : voice->cursors) {
+        cursor.reset();
+      }
+      _set(*voice, VoiceParameter::Position, event.parameters.position);
+      _set(*voice, VoiceParameter::PitchShift, event.parameters.pitchShift);
+      _set(*voice, VoiceParameter::TimeStretch, event.parameters.timeStretch);
+      _set(*voice, VoiceParameter::Gain, event.parameters.gain);
+      break;
+    }
+    case Event::Type::NoteOff:
+      for (auto& voice : _voices) {
+        if (voice.active && voice.id == event.id) {
+          voice.releasing = true;
+        }
+      }
+      break;
+    case Event::Type::Set:
+      for (auto& voice : _voices) {
+        if (voice.active && voice.id == event.id) {
+          _set(voice, event.parameter, event.value);
+        }
+      }
+      break;
+  }
+}
+
+template <typename SampleType>
+void BasicPartialPlayer<SampleType>::_set(Voice& voice, VoiceParameter parameter,
+                                          double value) const
+{
+  switch (parameter) {
+    case VoiceParameter::Position:
+      voice.position = value;
+      break;
+    case VoiceParameter::PitchShift:
+      voice.ratio = std::pow(2.0, value / 1200.0);
+      break;
+    case VoiceParameter::TimeStretch:
+      // non-positive stretches are ignored rather than reported, there is no
+      // one to report to on the audio thread
+      if (value > 0) {
+        voice.step = 1.0 / (value * _options.sampleRate);
+      }
+      break;
+    case VoiceParameter::Gain:
+      voice.gain = std::pow(10.0, value / 20.0);
+      break;
+  }
+}
+
+template <typename SampleType>
+void BasicPartialPlayer<SampleType>::_renderVoice(Voice& voice, double* output,
+                                                  std::size_t frames)
+{
+  double target = voice.releasing ? 0.0 : 1.0;
+  double level = voice.level;
+  for (std::size_t i = 0; i < frames; ++i) {
+    _times[i] = voice.position + static_cast<double>(i) * voice.step;
+    level = level < target ? std::min(target, level + _rampStep)
+                           : std::max(target, level - _rampStep);
+    _levels[i] = voice.gain * level;
+  }
+  voice.level = level;
+
+  double first = _times[0];
+  double last = _times[frames - 1];
+  double nyquist = 0.5 * _options.sampleRate;
+  double omega = kTwoPi / _options.sampleRate;
+  SampleType* envelopes[] = {_frequency.data(), _amplitude.data()};
+
+  for (std::size_t p = 0; p < voice.cursors.size(); ++p) {
+    double start = _startTimes[p];
+    double end = _endTimes[p];
+    if (end < first || start > last) {
+      continue;
+    }
+
+    voice.cursors[p].evaluate(_times.data(), frames, envelopes);
+
+    double phase = voice.phases[p];
+    for (std::size_t i = 0; i < frames; ++i) {
+      double t = _times[i];
+      double f = voice.ratio * static_cast<double>(_frequency[i]);
+      if (t >= start && t <= end && f < nyquist) {
+        output[i] += _levels[i] * static_cast<double>(_amplitude[i]) * std::sin(phase);
+      }
+      phase += omega * f;
+    }
+    voice.phases[p] = std::remainder(phase, kTwoPi);
+  }
+
+  voice.position += static_cast<double>(frames) * voice.step;
+  if ((voice.releasing && voice.level <= 0) || voice.position > _endTime) {
+    voice.active = false;
+  }
+}
+
+template class BasicPartialPlayer<double>;
+template class BasicPartialPlayer<float>;
+
+}  // namespace utu
@@ -4,18 +4,102 @@
 // SPDX-License-Identifier: MIT
 //
 
+#pragma once
+
 #include <utu/PartialIO.h>
 
+#include <cstdint>
+#include <map>
 #include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <vector>
+
+// file_info kind and version of documents. Version 2 added the sample
+// encodings and binary formats, version 1 documents read the same way.
+constexpr char kFileKind[] = "utu-partial-data";
+constexpr uint16_t kFileVersion = 2;
+
+// file_info encoding values, see SampleEncoding
+constexpr char kBase64Float64Encoding[] = "base64-float64le";
+constexpr char kBase64Float32Encoding[] = "base64-float32le";
+
+// file_info encoding values of binary documents, whose envelopes are byte
+// strings of little endian samples
+constexpr char kFloat64Encoding[] = "float64le";
+constexpr char kFloat32Encoding[] = "float32le";
 
 namespace utu
 {
+inline void to_json(nlohmann::json& j, const Summary& s)
+{
+  j["partial_count"] = s.partials;
+  j["breakpoint_count"] = s.breakpoints;
+  nlohmann::json& ranges = j["ranges"] = nlohmann::json::object();
+  for (const auto& [name, range] : s.ranges) {
+    ranges[name] = {range.min, range.max};
+  }
+  if (s.fingerprint) {
+    j["fingerprint"] = *s.fingerprint;
+  }
+}
+
+inline void from_json(const nlohmann::json& j, Summary& s)
+{
+  s.partials = j.at("partial_count").get<std::size_t>();
+  s.breakpoints = j.at("breakpoint_count").get<std::size_t>();
+  s.ranges.clear();
+  for (const auto& [name, range] : j.at("ranges").items()) {
+    s.ranges[name] = {range.at(0).get<double>(), range.at(1).get<double>()};
+  }
+  s.fingerprint.reset();
+  if (j.contains("fingerprint")) {
+    s.fingerprint = j["fingerprint"].get<std::string>();
+  }
+}
+
 struct FileInfo {
   std::string kind;
   uint16_t version;
 
-  NLOHMANN_DEFINE_TYPE_INTRUSIVE(FileInfo, kind, version)
+  // sample encoding, absent for numbers
+  std::optional<std::string> encoding = {};
+
+  std::optional<Summary> summary = {};
+
+  friend void to_json(nlohmann::json& j, const FileInfo& info)
+  {
+    j["kind"] = info.kind;
+    j["version"] = info.version;
+    if (info.encoding) {
+      j["encoding"] = *info.encoding;
+    }
+    if (info.summary) {
+      j["summary"] = *info.summary;
+    }
+  }
+
+  friend void from_json(const nlohmann::json& j, FileInfo& info)
+  {
+    info.kind = j.at("kind").get<std::string>();
+    info.version = j.at("version").get<uint16_t>();
+    info.encoding.reset();
+    if (j.contains("encoding")) {
+      info.encoding = j["encoding"].get<std::string>();
+    }
+    info.summary.reset();
+    if (j.contains("summary")) {
+      info.summary = j["summary"].get<Summary>();
+    }
+  }
 };
+
+// JSON value type storing numbers in the given sample precision. Partials of
+// float samples are dumped with it so numbers are written as the shortest
+// representation of the float rather than of the double it widens to.
+template <typename SampleType>
+using BasicJson = nlohmann::basic_json<std::map, std::vector, std::string, bool, std::int64_t,
+                                       std::uint64_t, SampleType>;
 }  // namespace utu
 
 //
@@ -49,9 +133,12 @@ struct adl_serializer<std::optional<T>> {
   }
 };
 
-template <>
-struct adl_serializer<utu::Partial> {
-  static void to_json(json& j, const utu::Partial& p)
+template <typename SampleType>
+struct adl_serializer<utu::BasicPartial<SampleType>> {
+  using Partial = utu::BasicPartial<SampleType>;
+
+  template <typename BasicJsonType>
+  static void to_json(BasicJsonType& j, const Partial& p)
   {
     if (p.label) {
       j["label"] = *p.label;
@@ -59,10 +146,11 @@ struct adl_serializer<utu::Partial> {
     j["parameters"] = p.parameters;
   }
 
-  static void from_json(const json& j, utu::Partial& p)
+  template <typename BasicJsonType>
+  static void from_json(const BasicJsonType& j, Partial& p)
   {
     p.label = j.value("label", std::optional<std::string>({}));
-    p.parameters = j["parameters"].get<utu::Partial::Parameters>();
+    p.parameters = j["parameters"].template get<typename Partial::Parameters>();
     // TODO: ensure there is at least one envelope
   }
 };
@@ -85,8 +173,40 @@ struct adl_serializer<utu::PartialData::Source> {
 };
 
 template <>
-struct adl_serializer<utu::PartialData> {
-  static void to_json(json& j, const utu::PartialData& d)
+struct adl_serializer<utu::PartialData::Marker> {
+  static void to_json(json& j, const utu::PartialData::Marker& m)
+  {
+    j["time"] = m.time;
+    j["name"] = m.name;
+  }
+
+  static void from_json(const json& j, utu::PartialData::Marker& m)
+  {
+    m.time = j["time"].get<double>();
+    m.name = j.value("name", std::string());
+  }
+};
+
+template <>
+struct adl_serializer<utu::PartialData::Fundamental> {
+  static void to_json(json& j, const utu::PartialData::Fundamental& f)
+  {
+    j["time"] = f.time;
+    j["frequency"] = f.frequency;
+  }
+
+  static void from_json(const json& j, utu::PartialData::Fundamental& f)
+  {
+    f.time = j["time"].get<std::vector<double>>();
+    f.frequency = j["frequency"].get<std::vector<double>>();
+  }
+};
+
+template <typename SampleType>
+struct adl_serializer<utu::BasicPartialData<SampleType>> {
+  using PartialData = utu::BasicPartialData<SampleType>;
+
+  static void to_json(json& j, const PartialData& d)
   {
     if (d.description) {
       j["description"] = *d.description;
@@ -94,18 +214,30 @@ struct adl_serializer<utu::PartialData> {
     if (d.source) {
       j["source"] = *d.source;
     }
+    if (!d.markers.empty()) {
+      j["markers"] = d.markers;
+    }
+    if (d.fundamental) {
+      j["fundamental"] = *d.fundamental;
+    }
     j["parameters"] = d.parameters;
     j["partials"] = d.partials;
   }
 
-  static void from_json(const json& j, utu::PartialData& d)
+  static void from_json(const json& j, PartialData& d)
   {
     d.description = j.value("description", std::optional<std::string>({}));
     d.source = j.value("source", std::optional<utu::PartialData::Source>({}));
+    d.markers = j.value("markers", utu::PartialData::Markers());
+    d.fundamental = j.value("fundamental", std::optional<utu::PartialData::Fundamental>({}));
     d.parameters = j["parameters"].get<std::vector<std::string>>();
 
     // FIXME: should validate that parameters match up
-    d.partials = j["partials"].get<std::vector<utu::Partial>>();
+    // decode in place so partials are allocated from the resource of d
+    d.partials.clear();
+    for (const auto& p : j["partials"]) {
+      p.get_to(d.partials.emplace_back());
+    }
   }
 };
 
@@ -0,0 +1,342 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include "Splice.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <optional>
+
+namespace
+{
+
+using utu::Partial;
+
+const Partial::Samples& _samples(const Partial& p, const char* name)
+{
+  static const Partial::Samples kEmpty;
+  auto it = p.parameters.find(name);
+  return it == p.parameters.end() ? kEmpty : it->second;
+}
+
+const Partial::Samples& _times(const Partial& p) { return _samples(p, kTimeName); }
+
+double _value(const Partial& p, const char* name, bool last)
+{
+  auto it = p.parameters.find(name);
+  if (it == p.parameters.end() || it->second.empty()) {
+    return 0.0;
+  }
+  return last ? it->second.back() : it->second.front();
+}
+
+// The breakpoints [begin, end) of every envelope of p
+Partial _slice(const Partial& p, std::size_t begin, std::size_t end)
+{
+  Partial result;
+  result.label = p.label;
+  for (const auto& [name, samples] : p.parameters) {
+    auto& out = result.parameters[name];
+    std::size_t last = std::min(end, samples.size());
+    if (begin < last) {
+      out.assign(samples.begin() + static_cast<std::ptrdiff_t>(begin),
+                 samples.begin() + static_cast<std::ptrdiff_t>(last));
+    }
+  }
+  return result;
+}
+
+void _append(Partial& to, const Partial& from)
+{
+  for (const auto& [name, samples] : from.parameters) {
+    auto& out = to.parameters[name];
+    out.insert(out.end(), samples.begin(), samples.end());
+  }
+  if (!to.label) {
+    to.label = from.label;
+  }
+}
+
+// Index of the unused candidate which best continues, or is continued by,
+// the partial: within maxGap seconds and maxDrift Hz at the joint and with
+// matching labels when both are labeled. Candidates are matched on the
+// smallest frequency difference.
+std::optional<std::size_t> _match(const Partial& p, bool pFirst,
+                                  const std::vector<Partial>& candidates,
+                                  const std::vector<bool>& used, double maxGap, double maxDrift)
+{
+  std::optional<std::size_t> best;
+  double bestDrift = std::numeric_limits<double>::infinity();
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    const Partial& c = candidates[i];
+    if (used[i] || (p.label && c.label && *p.label != *c.label)) {
+      continue;
+    }
+    // the joint is between the end of the earlier and start of the later
+    const Partial& earlier = pFirst ? p : c;
+    const Partial& later = pFirst ? c : p;
+    double gap = _times(later).front() - _times(earlier).back();
+    double drift = std::abs(_value(later, kFrequencyName, false) -
+                            _value(earlier, kFrequencyName, true));
+    if (gap >= 0 && gap <= maxGap && drift <= maxDrift && drift < bestDrift) {
+      best = i;
+      bestDrift = drift;
+    }
+  }
+  return best;
+}
+
+// Frequency of p at time t interpolating between breakpoints, no value
+// outside of its span.
+std::optional<double> _frequencyAt(const Partial& p, double t)
+{
+  const auto& time = _times(p);
+  const auto& frequency = _samples(p, kFrequencyName);
+  std::size_t size = std::min(time.size(), frequency.size());
+  if (size == 0 || t < time.front() || t > time[size - 1]) {
+    return {};
+  }
+
+  auto j = static_cast<std::size_t>(
+      std::lower_bound(time.begin(), time.begin() + static_cast<std::ptrdiff_t>(size), t) -
+      time.begin());
+  if (j == 0 || time[j] == t) {
+    return frequency[j];
+  }
+  double x = (t - time[j - 1]) / (time[j] - time[j - 1]);
+  return frequency[j - 1] + x * (frequency[j] - frequency[j - 1]);
+}
+
+// Whether any breakpoint of p is within [lower, upper)
+bool _within(const Partial& p, double lower, double upper)
+{
+  const auto& frequency = _samples(p, kFrequencyName);
+  return std::any_of(frequency.begin(), frequency.end(),
+                     [&](double f) { return f >= lower && f < upper; });
+}
+
+// Mean frequency difference of a and b compared at the breakpoints of each
+// within the span of the other where either is within [lower, upper), no
+// value when there are none.
+std::optional<double> _distance(const Partial& a, const Partial& b, double lower, double upper)
+{
+  double total = 0;
+  std::size_t count = 0;
+  auto compare = [&](const Partial& from, const Partial& other) {
+    const auto& time = _times(from);
+    const auto& frequency = _samples(from, kFrequencyName);
+    for (std::size_t i = 0; i < std::min(time.size(), frequency.size()); ++i) {
+      std::optional<double> g = _frequencyAt(other, time[i]);
+      double f = frequency[i];
+      if (g && ((f >= lower && f < upper) || (*g >= lower && *g < upper))) {
+        total += std::abs(f - *g);
+        ++count;
+      }
+    }
+  };
+  compare(a, b);
+  compare(b, a);
+  if (count == 0) {
+    return {};
+  }
+  return total / static_cast<double>(count);
+}
+
+// Join duplicates found below and above edge. Where both are present the
+// breakpoints come from the one on the side of the edge which the pair is on,
+// elsewhere from whichever is present.
+Partial _join(const Partial& below, const Partial& above, double edge)
+{
+  struct Pick {
+    double time;
+    const Partial* from;
+    std::size_t index;
+  };
+  std::vector<Pick> picks;
+  auto pick = [&](const Partial& from, const Partial& other, bool isBelow) {
+    const auto& time = _times(from);
+    const auto& frequency = _samples(from, kFrequencyName);
+    for (std::size_t i = 0; i < std::min(time.size(), frequency.size()); ++i) {
+      std::optional<double> g = _frequencyAt(other, time[i]);
+      if (g && ((frequency[i] + *g) / 2 < edge) != isBelow) {
+        continue;
+      }
+      picks.push_back({time[i], &from, i});
+    }
+  };
+  pick(below, above, true);
+  pick(above, below, false);
+  std::stable_sort(picks.begin(), picks.end(),
+                   [](const Pick& a, const Pick& b) { return a.time < b.time; });
+
+  // only the envelopes both have
+  Partial result;
+  result.label = below.label ? below.label : above.label;
+  for (const auto& entry : below.parameters) {
+    if (above.parameters.count(entry.first)) {
+      result.parameters[entry.first];
+    }
+  }
+
+  double last = -std::numeric_limits<double>::infinity();
+  for (const Pick& p : picks) {
+    if (p.time <= last) {
+      continue;
+    }
+    last = p.time;
+    for (auto& [name, samples] : result.parameters) {
+      const auto& from = p.from->parameters.at(name);
+      if (p.index < from.size()) {
+        samples.push_back(from[p.index]);
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+namespace utu
+{
+
+PartialData::Partials mergeBands(std::vector<BandPartials>& bands, double overlap)
+{
+  PartialData::Partials merged;
+  for (std::size_t b = 0; b < bands.size(); ++b) {
+    BandPartials& band = bands[b];
+
+    PartialData::Partials found;
+    for (auto& p : band.partials) {
+      if (_within(p, band.lower, band.upper)) {
+        found.push_back(std::move(p));
+      }
+    }
+    band.partials.clear();
+    if (b == 0) {
+      merged = std::move(found);
+      continue;
+    }
+
+    // duplicates are only looked for near the edge
+    double edge = band.lower;
+    double lower = edge * (1.0 - overlap);
+    double upper = edge * (1.0 + overlap);
+    double tolerance = 0.5 * std::max(bands[b - 1].freqResolution, band.freqResolution);
+
+    struct Duplicate {
+      double distance;
+      std::size_t below;
+      std::size_t above;
+    };
+    std::vector<Duplicate> duplicates;
+    for (std::size_t i = 0; i < merged.size(); ++i) {
+      if (!_within(merged[i], lower, upper)) {
+        continue;
+      }
+      for (std::size_t j = 0; j < found.size(); ++j) {
+        if (!_within(found[j], lower, upper)) {
+          continue;
+        }
+        std::optional<double> d = _distance(merged[i], found[j], lower, upper);
+        if (d && *d <= tolerance) {
+          duplicates.push_back({*d, i, j});
+        }
+      }
+    }
+    std::stable_sort(
+        duplicates.begin(), duplicates.end(),
+        [](const Duplicate& x, const Duplicate& y) { return x.distance < y.distance; });
+
+    std::vector<bool> belowUsed(merged.size(), false);
+    std::vector<bool> aboveUsed(found.size(), false);
+    for (const Duplicate& d : duplicates) {
+      if (belowUsed[d.below] || aboveUsed[d.above]) {
+        continue;
+      }
+      belowUsed[d.below] = aboveUsed[d.above] = true;
+      merged[d.below] = _join(merged[d.below], found[d.above], edge);
+    }
+    for (std::size_t j = 0; j < found.size(); ++j) {
+      if (!aboveUsed[j]) {
+        merged.push_back(std::move(found[j]));
+      }
+    }
+  }
+  return merged;
+}
+
+PartialData spliceRegion(const PartialData& previous, const PartialData::Partials& region,
+                         double startTime, double endTime, double maxGap, double maxDrift)
+{
+  PartialData result;
+  static_cast<PartialDataHeader&>(result) = previous;
+
+  // previous partials are kept, or cut into the pieces before and after the
+  // region which are candidates for splicing
+  std::vector<Partial> heads;
+  std::vector<Partial> tails;
+  for (const auto& p : previous.partials) {
+    const auto& t = _times(p);
+    if (t.empty() || t.back() < startTime || t.front() > endTime) {
+      result.partials.push_back(p);
+      continue;
+    }
+    auto begin = static_cast<std::size_t>(
+        std::lower_bound(t.begin(), t.end(), startTime) - t.begin());
+    auto end = static_cast<std::size_t>(std::upper_bound(t.begin(), t.end(), endTime) - t.begin());
+    if (begin > 0) {
+      heads.push_back(_slice(p, 0, begin));
+    }
+    if (end < t.size()) {
+      tails.push_back(_slice(p, end, t.size()));
+    }
+  }
+
+  std::vector<bool> headUsed(heads.size(), false);
+  std::vector<bool> tailUsed(tails.size(), false);
+  for (const auto& p : region) {
+    const auto& t = _times(p);
+
+    // only the region itself is taken from the new analysis
+    auto begin = static_cast<std::size_t>(
+        std::lower_bound(t.begin(), t.end(), startTime) - t.begin());
+    auto end = static_cast<std::size_t>(std::upper_bound(t.begin(), t.end(), endTime) - t.begin());
+    if (begin >= end) {
+      continue;
+    }
+    Partial piece = _slice(p, begin, end);
+
+    if (auto h = _match(piece, false, heads, headUsed, maxGap, maxDrift)) {
+      headUsed[*h] = true;
+      Partial joined = heads[*h];
+      _append(joined, piece);
+      piece = std::move(joined);
+    }
+    if (auto e = _match(piece, true, tails, tailUsed, maxGap, maxDrift)) {
+      tailUsed[*e] = true;
+      _append(piece, tails[*e]);
+    }
+    result.partials.push_back(std::move(piece));
+  }
+
+  // pieces which were not spliced end or start at the region boundary
+  for (std::size_t i = 0; i < heads.size(); ++i) {
+    if (!headUsed[i]) {
+      result.partials.push_back(std::move(heads[i]));
+    }
+  }
+  for (std::size_t i = 0; i < tails.size(); ++i) {
+    if (!tailUsed[i]) {
+      result.partials.push_back(std::move(tails[i]));
+    }
+  }
+
+
+  return result;
+}
+
+}  // namespace utu
@@ -0,0 +1,42 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#pragma once
+
+#include <utu/PartialData.h>
+
+#include <vector>
+
+namespace utu
+{
+
+// Partials found by the analysis of one band, see AnalyzeOptions::bands.
+struct BandPartials {
+  double lower;           // Hz
+  double upper;           // Hz, infinity for the highest band
+  double freqResolution;  // Hz
+  PartialData::Partials partials;
+};
+
+// Combine the partials of adjacent ascending bands, each analyzed overlap (a
+// fraction of the edge frequency) beyond its upper edge. Partials with no
+// breakpoint within their own band are left to its neighbours. Partials
+// either side of an edge are duplicates when they overlap in time and, within
+// the overlap of the edge, their frequencies are on average within half the
+// coarser resolution of each other. The closest duplicates are joined,
+// taking breakpoints from the band on the side of the edge where they are,
+// so glides crossing an edge are kept whole. Partials are expected to have
+// time and frequency envelopes; the partials of bands are moved from.
+PartialData::Partials mergeBands(std::vector<BandPartials>& bands, double overlap);
+
+// Replace [startTime, endTime] of previous with the partials of a new
+// analysis of the region, see Analyzer::reanalyze. Region partials are cut to
+// the region and spliced onto the pieces of previous partials cut at its
+// edges when the joint is within maxGap seconds and maxDrift Hz.
+PartialData spliceRegion(const PartialData& previous, const PartialData::Partials& region,
+                         double startTime, double endTime, double maxGap, double maxDrift);
+
+}  // namespace utu
@@ -0,0 +1,140 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+//
+
+#include <loris/Partial.h>
+#include <loris/Synthesizer.h>
+#include <utu/Harmonic.h>
+#include <utu/Synthesis.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace
+{
+
+using namespace utu;
+
+// The synthesis transforms composed into per breakpoint factors
+struct Transform {
+  double frequency;
+  double amplitude;
+  double time;
+  const std::vector<std::string>& muted;
+
+  explicit Transform(const SynthOptions& options)
+      : frequency(options.frequencyScale * std::pow(2.0, options.pitchShift / 1200.0)),
+        amplitude(std::pow(10.0, options.gain / 20.0)),
+        time(options.timeStretch),
+        muted(options.mutedLabels)
+  {
+  }
+
+  template <typename P>
+  bool isMuted(const P& p) const
+  {
+    return p.label && std::find(muted.begin(), muted.end(), *p.label) != muted.end();
+  }
+};
+
+template <typename P>
+const typename P::Samples* _envelope(const P& p, const char* name)
+{
+  auto it = p.parameters.find(name);
+  return it == p.parameters.end() ? nullptr : &it->second;
+}
+
+template <typename SampleType>
+std::vector<double> _synthesize(const BasicPartialData<SampleType>& data,
+                                const SynthOptions& options)
+{
+  Loris::Synthesizer::Parameters params;
+  params.sampleRate = options.sampleRate;
+  if (options.fadeTime) {
+    params.fadeTime = *options.fadeTime;
+  }
+
+  std::vector<double> samples;
+  Loris::Synthesizer synth(params, samples);
+
+  // Each partial is transformed while it is converted to the synthesizer's
+  // breakpoint representation and rendered immediately, so only a single
+  // transformed partial exists at a time.
+  Transform transform(options);
+  std::vector<double> absolute;
+  for (const auto& partial : data.partials) {
+    if (transform.isMuted(partial)) {
+      continue;
+    }
+
+    const auto* t = _envelope(partial, kTimeName);
+    const auto* f = _envelope(partial, kFrequencyName);
+    const auto* a = _envelope(partial, kAmplitudeName);
+    if (!t || !f || !a) {
+      throw std::invalid_argument(
+          "synthesis requires time, frequency and amplitude envelopes for every partial");
+    }
+
+    // bandwidth and phase are optional, for example after export to a grid
+    const auto* b = _envelope(partial, kBandwidthName);
+    const auto* p = _envelope(partial, kPhaseName);
+
+    std::size_t count = t->size();
+    if (f->size() != count || a->size() != count || (b && b->size() != count) ||
+        (p && p->size() != count)) {
+      throw std::invalid_argument("synthesis requires envelopes of equal length for every partial");
+    }
+
+    // harmonic relative frequencies are restored a partial at a time
+    bool relative = data.fundamental && absoluteFrequencies(*data.fundamental, partial, absolute);
+
+    Loris::Partial out;
+    for (std::size_t i = 0; i < count; ++i) {
+      double time = (*t)[i];
+      double frequency = relative ? absolute[i] : static_cast<double>((*f)[i]);
+      double amplitude = (*a)[i];
+      double bandwidth = b ? static_cast<double>((*b)[i]) : 0.0;
+      double phase = p ? static_cast<double>((*p)[i]) : 0.0;
+      out.insert(time * transform.time,
+                 Loris::Breakpoint(frequency * transform.frequency, amplitude * transform.amplitude,
+                                   bandwidth, phase));
+    }
+    synth.synthesize(out);
+  }
+
+  return samples;
+}
+
+}  // namespace
+
+namespace utu
+{
+
+std::vector<double> synthesize(const PartialData& data, const SynthOptions& options)
+{
+  return _synthesize(data, options);
+}
+
+std::vector<double> synthesize(const FloatPartialData& data, const SynthOptions& options)
+{
+  return _synthesize(data, options);
+}
+
+std::size_t synthesize(const PartialData& data, const SynthOptions& options, double* output,
+                       std::size_t count)
+{
+  // NOTE: Loris::Synthesizer grows its own buffer as partials are rendered so
+  // the result is copied out rather than rendered in place.
+  std::vector<double> samples = synthesize(data, options);
+
+  auto copied = std::min(count, samples.size());
+  std::copy_n(samples.begin(), copied, output);
+  std::fill(output + copied, output + count, 0.0);
+
+  return samples.size();
+}
+
+}  // namespace utu
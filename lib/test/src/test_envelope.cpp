@@ -0,0 +1,102 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <utu/Envelope.h>
+#include <utu/PartialData.h>
+#include <vector>
+
+namespace
+{
+
+template <typename SampleType>
+utu::BasicPartial<SampleType> makePartial()
+{
+  utu::BasicPartial<SampleType> p;
+  p.parameters[kTimeName] = {0.1, 0.2, 0.4};
+  p.parameters[kFrequencyName] = {100, 200, 200};
+  p.parameters[kAmplitudeName] = {0, 1, 0};
+  return p;
+}
+
+}  // namespace
+
+TEST(envelope, InterpolatesAndHolds)
+{
+  utu::Partial p = makePartial<double>();
+  utu::EnvelopeCursor cursor(p, {kFrequencyName, kAmplitudeName});
+
+  std::vector<double> times = {0.0, 0.1, 0.15, 0.2, 0.3, 0.4, 1.0};
+  std::vector<double> frequency(times.size());
+  std::vector<double> amplitude(times.size());
+  double* outputs[] = {frequency.data(), amplitude.data()};
+  cursor.evaluate(times.data(), times.size(), outputs);
+
+  EXPECT_EQ(frequency, std::vector<double>({100, 100, 150, 200, 200, 200, 200}));
+  std::vector<double> expected = {0, 0, 0.5, 1, 0.5, 0, 0};
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    EXPECT_NEAR(amplitude[i], expected[i], 1e-12) << times[i];
+  }
+}
+
+TEST(envelope, ContinuesAcrossBlocks)
+{
+  utu::Partial p = makePartial<double>();
+  utu::EnvelopeCursor streamed(p, {kAmplitudeName});
+  utu::EnvelopeCursor whole(p, {kAmplitudeName});
+
+  // more queries than a single internal block
+  std::vector<double> times(1000);
+  for (std::size_t i = 0; i < times.size(); ++i) {
+    times[i] = 0.05 + 0.0004 * static_cast<double>(i);
+  }
+
+  std::vector<double> expected(times.size());
+  double* all[] = {expected.data()};
+  whole.evaluate(times.data(), times.size(), all);
+
+  std::vector<double> actual(times.size());
+  for (std::size_t i = 0; i < times.size(); i += 37) {
+    std::size_t n = std::min<std::size_t>(37, times.size() - i);
+    double* block[] = {actual.data() + i};
+    streamed.evaluate(times.data() + i, n, block);
+  }
+  EXPECT_EQ(actual, expected);
+
+  // seeking backwards relocates the cursor
+  double t = 0.15;
+  double value = -1;
+  double* out[] = {&value};
+  streamed.evaluate(&t, 1, out);
+  EXPECT_DOUBLE_EQ(value, 0.5);
+}
+
+TEST(envelope, MissingParameters)
+{
+  utu::FloatPartial p = makePartial<float>();
+  utu::FloatEnvelopeCursor cursor(p, {kBandwidthName, kFrequencyName});
+  EXPECT_EQ(cursor.parameterCount(), 2u);
+
+  double t = 0.3;
+  float bandwidth = -1;
+  float frequency = -1;
+  float* outputs[] = {&bandwidth, &frequency};
+  cursor.evaluate(&t, 1, outputs);
+  EXPECT_EQ(bandwidth, 0.0f);
+  EXPECT_EQ(frequency, 200.0f);
+
+  utu::FloatPartial empty;
+  utu::FloatEnvelopeCursor none(empty, {kFrequencyName});
+  none.evaluate(&t, 1, outputs);
+  EXPECT_EQ(bandwidth, 0.0f);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
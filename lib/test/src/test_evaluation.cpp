@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <utu/Evaluation.h>
+#include <vector>
+
+namespace
+{
+
+constexpr double kSampleRate = 8000;
+
+std::vector<double> sine(double frequency, double amplitude, std::size_t count)
+{
+  std::vector<double> out(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    out[i] = amplitude * std::sin(2.0 * M_PI * frequency * static_cast<double>(i) / kSampleRate);
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST(Evaluation, PerfectReconstruction)
+{
+  auto source = sine(440, 0.5, 8000);
+  auto e = utu::evaluate(source.data(), source.data(), source.size(), kSampleRate);
+
+  EXPECT_EQ(e.snr, -utu::kEvaluationFloorDb);
+  EXPECT_EQ(e.errorCurve.size(), 100u);
+  for (double level : e.errorCurve) {
+    EXPECT_EQ(level, utu::kEvaluationFloorDb);
+  }
+  for (const auto& band : e.bands) {
+    EXPECT_EQ(band.error, utu::kEvaluationFloorDb);
+  }
+}
+
+TEST(Evaluation, ScaledReconstruction)
+{
+  auto source = sine(440, 0.5, 8000);
+  auto rendered = sine(440, 0.45, 8000);
+  auto e = utu::evaluate(source.data(), rendered.data(), source.size(), kSampleRate);
+
+  // residual is a tenth of the source
+  EXPECT_NEAR(e.snr, 20.0, 1e-6);
+  EXPECT_NEAR(utu::signalToNoise(source.data(), rendered.data(), source.size()), e.snr, 1e-9);
+
+  // the error is confined to the band containing the sine
+  for (const auto& band : e.bands) {
+    if (band.lowFrequency <= 440 && 440 < band.highFrequency) {
+      EXPECT_NEAR(band.error, -20.0, 0.1);
+    }
+  }
+}
+
+TEST(Evaluation, ErrorCurveLocalizesError)
+{
+  auto source = sine(1000, 0.5, 8000);
+  auto rendered = source;
+  // drop the second half second
+  std::fill(rendered.begin() + 4000, rendered.end(), 0.0);
+
+  utu::EvaluateOptions options;
+  options.blockTime = 0.1;
+  auto e = utu::evaluate(source.data(), rendered.data(), source.size(), kSampleRate, options);
+
+  ASSERT_EQ(e.errorCurve.size(), 10u);
+  for (std::size_t b = 0; b < 5; ++b) {
+    EXPECT_EQ(e.errorCurve[b], utu::kEvaluationFloorDb);
+  }
+  for (std::size_t b = 5; b < 10; ++b) {
+    // RMS of a 0.5 amplitude sine
+    EXPECT_NEAR(e.errorCurve[b], 20.0 * std::log10(0.5 / std::sqrt(2.0)), 0.01);
+  }
+}
+
+TEST(Evaluation, Bands)
+{
+  auto source = sine(440, 0.5, 4096);
+  auto rendered = sine(2000, 0.1, 4096);
+
+  utu::EvaluateOptions options;
+  options.bandEdges = {0, 1000, 4000};
+  auto e = utu::evaluate(source.data(), rendered.data(), source.size(), kSampleRate, options);
+
+  ASSERT_EQ(e.bands.size(), 2u);
+  EXPECT_EQ(e.bands[0].highFrequency, 1000);
+  // the source has little energy above 1 kHz so the error dominates there
+  EXPECT_LT(e.bands[0].error, 1.0);
+  EXPECT_GT(e.bands[1].error, 20.0);
+}
+
+TEST(Evaluation, IndependentOfThreads)
+{
+  auto source = sine(440, 0.5, 50000);
+  auto rendered = sine(445, 0.5, 50000);
+
+  utu::EvaluateOptions single;
+  single.threads = 1;
+  utu::EvaluateOptions many;
+  many.threads = 4;
+  auto a = utu::evaluate(source.data(), rendered.data(), source.size(), kSampleRate, single);
+  auto b = utu::evaluate(source.data(), rendered.data(), source.size(), kSampleRate, many);
+
+  EXPECT_EQ(a.snr, b.snr);
+  EXPECT_EQ(a.errorCurve, b.errorCurve);
+  ASSERT_EQ(a.bands.size(), b.bands.size());
+  for (std::size_t i = 0; i < a.bands.size(); ++i) {
+    EXPECT_EQ(a.bands[i].error, b.bands[i].error);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
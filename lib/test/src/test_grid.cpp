@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <initializer_list>
+#include <utu/Grid.h>
+#include <utu/PartialData.h>
+
+namespace
+{
+
+utu::Partial partial(utu::Partial::Samples time, utu::Partial::Samples frequency,
+                     utu::Partial::Samples amplitude, utu::Partial::Samples bandwidth,
+                     utu::Partial::Samples phase)
+{
+  utu::Partial p;
+  p.parameters[kTimeName] = std::move(time);
+  p.parameters[kFrequencyName] = std::move(frequency);
+  p.parameters[kAmplitudeName] = std::move(amplitude);
+  p.parameters[kBandwidthName] = std::move(bandwidth);
+  p.parameters[kPhaseName] = std::move(phase);
+  return p;
+}
+
+utu::PartialData withPartials(std::initializer_list<utu::Partial> partials)
+{
+  utu::PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName, kBandwidthName, kPhaseName};
+  for (const auto& p : partials) {
+    data.partials.push_back(p);
+  }
+  return data;
+}
+
+}  // namespace
+
+TEST(grid, ResamplesFrameMajor)
+{
+  utu::GridOptions options;
+  options.hop = 0.025;
+  utu::PartialData data = withPartials({
+      partial({0.0, 0.1}, {100.0, 200.0}, {0.0, 1.0}, {0.0, 0.5}, {0.0, 0.0}),
+      partial({0.05, 0.2}, {440.0, 440.0}, {0.5, 0.5}, {0.0, 0.0}, {1.0, 1.0}),
+  });
+  utu::Grid g = utu::grid(data, options);
+
+  ASSERT_EQ(g.frames, 9u);
+  ASSERT_EQ(g.partials, 2u);
+  ASSERT_EQ(g.frequency.size(), 18u);
+
+  // partial a spans frames 0 through 4
+  for (std::size_t f = 0; f < g.frames; ++f) {
+    EXPECT_EQ(g.active[f * 2], f <= 4 ? 1 : 0) << f;
+  }
+  EXPECT_DOUBLE_EQ(g.frequency[1 * 2], 125.0);
+  EXPECT_DOUBLE_EQ(g.amplitude[2 * 2], 0.5);
+  EXPECT_DOUBLE_EQ(g.bandwidth[4 * 2], 0.5);
+  EXPECT_EQ(g.frequency[5 * 2], 0.0);
+
+  // partial b spans frames 2 through 8
+  EXPECT_EQ(g.active[1 * 2 + 1], 0);
+  EXPECT_EQ(g.active[2 * 2 + 1], 1);
+  EXPECT_EQ(g.active[8 * 2 + 1], 1);
+  EXPECT_DOUBLE_EQ(g.frequency[6 * 2 + 1], 440.0);
+}
+
+TEST(grid, AdvancesPhase)
+{
+  utu::GridOptions options;
+  options.hop = 0.025;
+  utu::Grid g = utu::grid(
+      withPartials({partial({0.05, 0.2}, {440.0, 440.0}, {0.5, 0.5}, {0.0, 0.0}, {1.0, 1.0})}),
+      options);
+
+  // a constant 440 Hz from phase 1 at 0.05 s, 0.025 s later
+  double expected = std::remainder(1.0 + 2.0 * M_PI * 440.0 * 0.025, 2.0 * M_PI);
+  EXPECT_NEAR(g.phase[3], expected, 1e-9);
+}
+
+TEST(grid, IndependentOfThreads)
+{
+  // overlapping partials so frames split across threads hold several
+  utu::PartialData data = withPartials({
+      partial({0.0, 0.1}, {100.0, 200.0}, {0.0, 1.0}, {0.0, 0.5}, {0.0, 0.0}),
+      partial({0.02, 0.07, 0.15}, {330.0, 335.0, 320.0}, {0.2, 0.3, 0.0}, {0.1, 0.1, 0.1},
+              {0.5, -1.0, 2.0}),
+      partial({0.12, 0.2}, {880.0, 900.0}, {0.1, 0.0}, {0.0, 0.0}, {-2.0, 1.5}),
+  });
+  utu::GridOptions options;
+  options.hop = 0.0001;
+  options.threads = 1;
+  utu::Grid single = utu::grid(data, options);
+  options.threads = 4;
+  utu::Grid many = utu::grid(data, options);
+
+  ASSERT_GT(single.frames, 1000u);
+  EXPECT_EQ(single.frequency, many.frequency);
+  EXPECT_EQ(single.phase, many.phase);
+  EXPECT_EQ(single.active, many.active);
+}
+
+TEST(grid, TimeRange)
+{
+  utu::GridOptions options;
+  options.hop = 0.05;
+  options.startTime = 0.1;
+  options.endTime = 0.3;
+  utu::PartialData data = withPartials({
+      partial({0.0, 0.1}, {100.0, 200.0}, {0.0, 1.0}, {0.0, 0.5}, {0.0, 0.0}),
+      partial({0.05, 0.2}, {440.0, 440.0}, {0.5, 0.5}, {0.0, 0.0}, {1.0, 1.0}),
+  });
+  utu::Grid g = utu::grid(utu::convert<float>(data), options);
+
+  // the first partial ends on the first frame, the second before the last
+  EXPECT_EQ(g.frames, 5u);
+  EXPECT_EQ(g.active[0], 1);
+  EXPECT_EQ(g.active[4 * 2 + 1], 0);
+
+  EXPECT_THROW(utu::grid(data, utu::GridOptions({0.0, 0.0, {}, 0})), std::invalid_argument);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <optional>
+#include <sstream>
+#include <utu/Harmonic.h>
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+namespace
+{
+
+double fundamentalAt(double t) { return 100.0 + 100.0 * t; }
+
+utu::Partial partial(std::optional<std::string> label, utu::Partial::Samples time,
+                     utu::Partial::Samples frequency, utu::Partial::Samples amplitude)
+{
+  utu::Partial p;
+  p.label = std::move(label);
+  p.parameters[kTimeName] = std::move(time);
+  p.parameters[kFrequencyName] = std::move(frequency);
+  p.parameters[kAmplitudeName] = std::move(amplitude);
+  return p;
+}
+
+// Harmonics 1 to 3 of a glide from 100 to 200 Hz over a second, the third
+// slightly sharp
+utu::PartialData glide()
+{
+  utu::PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  data.partials.push_back(partial("1", {0.0, 0.5, 1.0}, {100.0, 150.0, 200.0}, {0.5, 0.5, 0.5}));
+  data.partials.push_back(
+      partial("2", {0.0, 0.5, 1.0}, {200.0, 300.0, 400.0}, {0.25, 0.25, 0.25}));
+  data.partials.push_back(
+      partial("3", {0.0, 0.5, 1.0}, {303.0, 454.5, 606.0}, {0.01, 0.01, 0.01}));
+  return data;
+}
+
+template <typename Data>
+void expectFrequencies(const Data& actual, const utu::PartialData& expected, double tolerance)
+{
+  ASSERT_EQ(actual.partials.size(), expected.partials.size());
+  for (std::size_t i = 0; i < expected.partials.size(); ++i) {
+    const auto& a = actual.partials[i].parameters.at(kFrequencyName);
+    const auto& e = expected.partials[i].parameters.at(kFrequencyName);
+    ASSERT_EQ(a.size(), e.size());
+    for (std::size_t j = 0; j < e.size(); ++j) {
+      EXPECT_NEAR(static_cast<double>(a[j]), e[j], e[j] * tolerance) << i << ", " << j;
+    }
+  }
+}
+
+}  // namespace
+
+TEST(harmonic, HarmonicNumber)
+{
+  utu::Partial p;
+  EXPECT_FALSE(utu::harmonicNumber(p));
+  p.label = "3";
+  EXPECT_EQ(utu::harmonicNumber(p), 3u);
+  for (const char* label : {"0", "-2", "+2", " 2", "2a", "a", ""}) {
+    p.label = label;
+    EXPECT_FALSE(utu::harmonicNumber(p)) << label;
+  }
+}
+
+TEST(harmonic, RoundTrip)
+{
+  // an unlabeled partial is left alone
+  utu::PartialData expected = glide();
+  expected.partials.push_back(partial({}, {0.2, 0.4}, {777.0, 778.0}, {0.1, 0.1}));
+  utu::PartialData data = expected;
+
+  utu::makeHarmonicRelative(data);
+  ASSERT_TRUE(data.fundamental);
+  EXPECT_EQ(data.fundamental->time.front(), 0.0);
+  EXPECT_NEAR(data.fundamental->time.back(), 1.0, 1e-9);
+
+  // the estimate is dominated by the loudest harmonics, the sharp third
+  // raises it by about 1e-4
+  for (std::size_t i = 0; i < data.fundamental->time.size(); ++i) {
+    double t = data.fundamental->time[i];
+    EXPECT_NEAR(data.fundamental->frequency[i], fundamentalAt(t), fundamentalAt(t) * 5e-4) << t;
+  }
+  for (double d : data.partials[1].parameters[kFrequencyName]) {
+    EXPECT_NEAR(d, 0.0, 5e-4);
+  }
+  for (double d : data.partials[2].parameters[kFrequencyName]) {
+    EXPECT_NEAR(d, 0.01, 5e-4);
+  }
+  EXPECT_EQ(data.partials[3].parameters[kFrequencyName],
+            expected.partials[3].parameters[kFrequencyName]);
+
+  // relative data is left unchanged
+  utu::PartialData again = data;
+  utu::makeHarmonicRelative(again);
+  EXPECT_EQ(again.partials[2].parameters, data.partials[2].parameters);
+
+  utu::makeHarmonicAbsolute(data);
+  EXPECT_FALSE(data.fundamental);
+  expectFrequencies(data, expected, 1e-12);
+
+  utu::FloatPartialData floats = utu::convert<float>(expected);
+  utu::makeHarmonicRelative(floats);
+  utu::makeHarmonicAbsolute(floats);
+  expectFrequencies(floats, expected, 1e-6);
+}
+
+TEST(harmonic, ReadsAndWritesRelative)
+{
+  utu::PartialData expected = glide();
+  utu::WriteOptions writeOptions;
+  writeOptions.harmonicRelative = true;
+  std::string json = *utu::PartialWriter::write(expected, writeOptions);
+  EXPECT_NE(json.find("\"fundamental\""), std::string::npos);
+
+  // absolute frequencies are restored on load, and stored in the summary
+  std::istringstream is(json);
+  std::optional<utu::PartialHeader> header = utu::PartialHeaderReader::read(is);
+  ASSERT_TRUE(header && header->summary && header->fields.fundamental);
+  EXPECT_NEAR(header->summary->ranges.at(kFrequencyName).min, 100.0, 1e-9);
+  EXPECT_NEAR(header->summary->ranges.at(kFrequencyName).max, 606.0, 1e-9);
+
+  std::optional<utu::PartialData> data = utu::PartialReader::read(json);
+  ASSERT_TRUE(data);
+  EXPECT_FALSE(data->fundamental);
+  expectFrequencies(*data, expected, 1e-12);
+
+  // frequencies without times
+  utu::ReadOptions options;
+  options.parameters = {kFrequencyName};
+  data = utu::PartialReader::read(json, options);
+  ASSERT_TRUE(data);
+  EXPECT_EQ(data->parameters, std::vector<std::string>({kFrequencyName}));
+  EXPECT_EQ(data->partials[0].parameters.count(kTimeName), 0u);
+  expectFrequencies(*data, expected, 1e-12);
+
+  // or kept relative
+  options = {};
+  options.harmonicRelative = true;
+  data = utu::PartialReader::read(json, options);
+  ASSERT_TRUE(data && data->fundamental);
+  EXPECT_NEAR(data->partials[1].parameters[kFrequencyName][0], 0.0, 5e-4);
+
+  // line delimited and binary documents keep the track of relative data
+  std::ostringstream lines;
+  utu::PartialLineWriter::write(*data, lines);
+  std::istringstream linesIn(lines.str());
+  std::optional<utu::PartialData> fromLines = utu::PartialLineReader::read(linesIn);
+  ASSERT_TRUE(fromLines);
+  expectFrequencies(*fromLines, expected, 1e-12);
+
+  auto cbor = utu::PartialWriter::write(*data, utu::BinaryFormat::Cbor);
+  std::optional<utu::PartialData> fromCbor =
+      utu::PartialReader::read(cbor, utu::BinaryFormat::Cbor);
+  ASSERT_TRUE(fromCbor);
+  expectFrequencies(*fromCbor, expected, 1e-12);
+
+  // and convert absolute data when asked to
+  lines.str("");
+  utu::PartialLineWriter::write(expected, lines, writeOptions);
+  EXPECT_NE(lines.str().find("\"fundamental\""), std::string::npos);
+  cbor = utu::PartialWriter::write(expected, utu::BinaryFormat::Cbor, writeOptions);
+  fromCbor = utu::PartialReader::read(cbor, utu::BinaryFormat::Cbor, options);
+  ASSERT_TRUE(fromCbor && fromCbor->fundamental);
+}
+
+TEST(harmonic, Transpose)
+{
+  // the second harmonic alone, and an unlabeled partial
+  utu::PartialData source;
+  source.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  source.partials.push_back(partial("2", {0.0, 1.0}, {200.0, 400.0}, {0.25, 0.25}));
+  source.partials.push_back(partial({}, {0.2, 0.4}, {777.0, 778.0}, {0.1, 0.1}));
+
+  utu::PartialData expected = source;
+  utu::transpose(expected, 1200.0);
+  EXPECT_EQ(expected.partials[1].parameters[kFrequencyName][0], 2 * 777.0);
+
+  // a relative transposition only moves the fundamental track
+  utu::PartialData data = source;
+  utu::makeHarmonicRelative(data);
+  utu::PartialData relative = data;
+  utu::transpose(data, 1200.0);
+  EXPECT_EQ(data.partials[0].parameters, relative.partials[0].parameters);
+  EXPECT_NEAR(data.fundamental->frequency[0], 2 * relative.fundamental->frequency[0], 1e-9);
+
+  utu::makeHarmonicAbsolute(data);
+  expectFrequencies(data, expected, 1e-12);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utu/Partial.h>
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+namespace
+{
+
+// Document metadata shared by the tests, partials are added per test
+utu::PartialData header()
+{
+  utu::PartialData data;
+  data.description = "lines";
+  data.source = utu::PartialData::Source({"source.wav", "abc123"});
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  return data;
+}
+
+utu::Partial partial(std::optional<std::string> label, utu::Partial::Samples time,
+                     utu::Partial::Samples frequency, utu::Partial::Samples amplitude)
+{
+  utu::Partial p;
+  p.label = std::move(label);
+  p.parameters[kTimeName] = std::move(time);
+  p.parameters[kFrequencyName] = std::move(frequency);
+  p.parameters[kAmplitudeName] = std::move(amplitude);
+  return p;
+}
+
+void expectEqual(const utu::PartialData& a, const utu::PartialData& b)
+{
+  EXPECT_EQ(a.description, b.description);
+  ASSERT_EQ(a.source.has_value(), b.source.has_value());
+  EXPECT_EQ(a.source->location, b.source->location);
+  EXPECT_EQ(a.source->fingerprint, b.source->fingerprint);
+  EXPECT_EQ(a.parameters, b.parameters);
+  ASSERT_EQ(a.partials.size(), b.partials.size());
+  for (size_t i = 0; i < a.partials.size(); ++i) {
+    EXPECT_EQ(a.partials[i].label, b.partials[i].label);
+    EXPECT_EQ(a.partials[i].parameters, b.partials[i].parameters);
+  }
+}
+
+}  // namespace
+
+TEST(lines, OnePartialPerLine)
+{
+  utu::PartialData data = header();
+  data.partials.push_back(partial("1", {0.0, 0.1}, {100.0, 101.0}, {0.5, 0.25}));
+  data.partials.push_back(partial("2", {0.05}, {200.0}, {0.1}));
+  data.partials.push_back(partial({}, {0.2, 0.3}, {300.0, 300.0}, {0.0, 0.0}));
+
+  std::ostringstream os;
+  utu::PartialLineWriter::write(data, os);
+
+  std::string text = os.str();
+  EXPECT_EQ(std::count(text.begin(), text.end(), '\n'), 4);
+  EXPECT_NE(text.find("\"utu-partial-lines\""), std::string::npos);
+  EXPECT_EQ(text.find("\"partials\""), std::string::npos);
+}
+
+TEST(lines, RoundTrip)
+{
+  utu::PartialData data = header();
+  data.partials.push_back(
+      partial("1", {0.0, 0.01, 0.02}, {110.0, 110.5, 109.75}, {0.5, 1.0, 0.125}));
+  data.partials.push_back(partial({}, {0.015}, {2500.0}, {1e-5}));
+  std::stringstream ss;
+  utu::PartialLineWriter::write(data, ss);
+
+  auto result = utu::PartialLineReader::read(ss);
+  ASSERT_TRUE(result);
+  expectEqual(*result, data);
+}
+
+TEST(lines, Appends)
+{
+  utu::PartialData data = header();
+  data.partials.push_back(partial("1", {0.0, 0.1}, {100.0, 100.0}, {0.5, 0.5}));
+  data.partials.push_back(partial("2", {0.1, 0.2}, {200.0, 210.0}, {0.25, 0.0}));
+  data.partials.push_back(partial("1", {0.3, 0.4}, {100.0, 99.0}, {0.5, 0.0}));
+  data.partials.push_back(partial({}, {0.35}, {800.0}, {0.01}));
+  std::stringstream ss;
+  {
+    utu::PartialLineWriter writer(ss, data);
+    writer.append(data.partials[0]);
+    writer.append(data.partials[1]);
+  }
+  {
+    utu::PartialLineWriter writer(ss);
+    writer.append(data.partials[2]);
+    writer.append(data.partials[3]);
+  }
+
+  auto result = utu::PartialLineReader::read(ss);
+  ASSERT_TRUE(result);
+  expectEqual(*result, data);
+}
+
+TEST(lines, ParallelMatchesSerial)
+{
+  // large enough to be parsed in parallel, each copy offset so the chunks differ
+  utu::PartialData data = header();
+  for (int i = 0; i < 20000; ++i) {
+    double offset = 0.01 * i;
+    data.partials.push_back(partial(std::to_string(i % 4 + 1), {offset, offset + 0.01},
+                                    {100.0 + i, 101.0 + i}, {0.5, 0.25}));
+  }
+  std::ostringstream os;
+  utu::PartialLineWriter::write(data, os);
+  std::string text = os.str() + "\n\n";
+
+  for (unsigned threads : {1u, 3u, 8u}) {
+    auto result = utu::PartialLineReader::read(text, utu::ReadOptions(), threads);
+    ASSERT_TRUE(result);
+    expectEqual(*result, data);
+  }
+}
+
+TEST(lines, AppliesReadOptions)
+{
+  utu::PartialData data = header();
+  data.partials.push_back(partial("1", {0.0}, {100.0}, {0.5}));
+  data.partials.push_back(partial("2", {0.1}, {200.0}, {0.5}));
+  data.partials.push_back(partial({}, {0.2}, {300.0}, {0.5}));
+  data.partials.push_back(partial("2", {0.3}, {200.0}, {0.5}));
+  std::ostringstream os;
+  utu::PartialLineWriter::write(data, os);
+
+  utu::ReadOptions options;
+  options.labels = {"2"};
+  options.parameters = {kFrequencyName};
+  auto result = utu::PartialLineReader::read(os.str(), options);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(result->parameters, std::vector<std::string>({kFrequencyName}));
+  ASSERT_EQ(result->partials.size(), 2u);
+  for (auto& p : result->partials) {
+    EXPECT_EQ(*p.label, "2");
+    EXPECT_EQ(p.parameters.size(), 1u);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
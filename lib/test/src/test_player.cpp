@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <utu/Player.h>
+#include <vector>
+
+namespace
+{
+
+constexpr double kSampleRate = 1000;
+
+// A single steady partial from 0 to `duration` seconds
+utu::PartialData steady(double frequency, double amplitude, double duration)
+{
+  utu::PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  utu::Partial& p = data.partials.emplace_back();
+  p.parameters[kTimeName] = {0.0, duration};
+  p.parameters[kFrequencyName] = {frequency, frequency};
+  p.parameters[kAmplitudeName] = {amplitude, amplitude};
+  return data;
+}
+
+utu::PlayerOptions makeOptions()
+{
+  utu::PlayerOptions options;
+  options.sampleRate = kSampleRate;
+  options.voices = 2;
+  options.blockSize = 16;
+  options.events = 4;
+  options.rampTime = 0;
+  return options;
+}
+
+}  // namespace
+
+TEST(player, RendersSinusoid)
+{
+  utu::PartialData data = steady(100, 0.5, 1);
+  utu::PartialPlayer player(data, makeOptions());
+  ASSERT_TRUE(player.noteOn(1));
+
+  std::vector<double> output(100, 1.0);
+  player.render(output.data(), output.size());
+  for (std::size_t i = 0; i < output.size(); ++i) {
+    double expected = 0.5 * std::sin(2.0 * M_PI * 100.0 * static_cast<double>(i) / kSampleRate);
+    EXPECT_NEAR(output[i], expected, 1e-9) << i;
+  }
+  EXPECT_EQ(player.activeVoices(), 1u);
+}
+
+TEST(player, SampleAccurateEvents)
+{
+  utu::PartialData data = steady(100, 0.5, 1);
+  utu::PartialPlayer player(data, makeOptions());
+
+  // the note off lands in the following call
+  ASSERT_TRUE(player.noteOn(7, {}, 5));
+  ASSERT_TRUE(player.set(7, utu::VoiceParameter::PitchShift, 1200, 10));
+  ASSERT_TRUE(player.noteOff(7, 40));
+
+  std::vector<double> output(32);
+  player.render(output.data(), output.size());
+  for (std::size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(output[i], 0.0) << i;
+  }
+  // 100 Hz from frame 5, 200 Hz from frame 10; the phase at frame 10 is pi
+  EXPECT_NEAR(output[5], 0.0, 1e-9);
+  EXPECT_NEAR(output[6], 0.5 * std::sin(2.0 * M_PI * 0.1), 1e-9);
+  EXPECT_NEAR(output[11], 0.5 * std::sin(M_PI + 2.0 * M_PI * 0.2), 1e-9);
+
+  player.render(output.data(), output.size());
+  EXPECT_NE(output[7], 0.0);
+  for (std::size_t i = 8; i < output.size(); ++i) {
+    EXPECT_EQ(output[i], 0.0) << i;
+  }
+  EXPECT_EQ(player.activeVoices(), 0u);
+}
+
+TEST(player, StealsOldestVoice)
+{
+  // outlasts every render so only stealing and note offs end voices
+  utu::FloatPartialData data = utu::convert<float>(steady(250, 0.25, 10));
+  utu::FloatPartialPlayer player(data, makeOptions());
+
+  std::vector<double> output(8);
+  ASSERT_TRUE(player.noteOn(1));
+  ASSERT_TRUE(player.noteOn(2, {0.5, 0, 1, -6}));
+  ASSERT_TRUE(player.noteOn(3));
+  ASSERT_TRUE(player.noteOn(4));
+  EXPECT_FALSE(player.noteOn(5));  // queue full
+  player.render(output.data(), output.size());
+  EXPECT_EQ(player.activeVoices(), 2u);
+
+  // voices 3 and 4 remain, voice 1 was stolen
+  ASSERT_TRUE(player.noteOff(1));
+  player.render(output.data(), output.size());
+  EXPECT_EQ(player.activeVoices(), 2u);
+  ASSERT_TRUE(player.noteOff(3));
+  ASSERT_TRUE(player.noteOff(4));
+  player.render(output.data(), output.size());
+  EXPECT_EQ(player.activeVoices(), 0u);
+}
+
+TEST(player, ReleasesStolenVoice)
+{
+  utu::PartialData data = steady(100, 0.5, 1);
+  utu::PlayerOptions options = makeOptions();
+  options.voices = 1;
+  options.rampTime = 0.01;
+  utu::PartialPlayer player(data, options);
+
+  std::vector<double> output(32);
+  ASSERT_TRUE(player.noteOn(1));
+  player.render(output.data(), output.size());
+
+  // the first note fades out over 10 frames while the second, starting at
+  // zero phase, fades in
+  ASSERT_TRUE(player.noteOn(2));
+  player.render(output.data(), 5);
+  EXPECT_NEAR(output[0], 0.9 * 0.5 * std::sin(2.0 * M_PI * 100.0 * 32 / kSampleRate), 1e-9);
+  EXPECT_EQ(player.activeVoices(), 2u);
+
+  player.render(output.data(), output.size());
+  EXPECT_EQ(player.activeVoices(), 1u);
+  ASSERT_TRUE(player.noteOff(1));
+  player.render(output.data(), output.size());
+  EXPECT_EQ(player.activeVoices(), 1u);
+}
+
+TEST(player, StopsAtEnd)
+{
+  // started 10ms before the end and stretched twice as long, 20 frames remain
+  utu::PartialData data = steady(100, 0.5, 1);
+  utu::PartialPlayer player(data, makeOptions());
+  ASSERT_TRUE(player.noteOn(1, {0.99, 0, 2, 0}));
+
+  std::vector<double> output(64);
+  player.render(output.data(), output.size());
+  EXPECT_EQ(player.activeVoices(), 0u);
+  EXPECT_NE(output[1], 0.0);
+  EXPECT_EQ(output[63], 0.0);
+
+  EXPECT_THROW(utu::PartialPlayer(data, utu::PlayerOptions({kSampleRate, 0, 16, 4, 0})),
+               std::invalid_argument);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,323 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <memory_resource>
+#include <sstream>
+#include <utu/Partial.h>
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+#include "SerializerImpl.h"
+
+namespace
+{
+
+const std::string kPartials = R"({
+  "file_info": { "kind": "utu-partial-data", "version": 1 },
+  "description": "three partials",
+  "source": { "location": "source.wav" },
+  "parameters": ["time", "frequency", "amplitude", "bandwidth", "phase"],
+  "partials": [
+    {
+      "label": "1",
+      "parameters": {
+        "time": [0.0, 0.5, 1.0],
+        "frequency": [440.0, 441.0, 442.0],
+        "amplitude": [0.1, 0.5, 0.2],
+        "bandwidth": [0.0, 0.0, 0.0],
+        "phase": [0.0, 0.1, 0.2]
+      }
+    },
+    {
+      "label": "2",
+      "parameters": {
+        "time": [1.5, 2.0],
+        "frequency": [880.0, 882.0],
+        "amplitude": [0.01, 0.02],
+        "bandwidth": [0.1, 0.1],
+        "phase": [0.0, 0.3]
+      }
+    },
+    {
+      "parameters": {
+        "time": [0.75, 1.25],
+        "frequency": [1320.0, 1321.0],
+        "amplitude": [0.3, 0.1],
+        "bandwidth": [0.0, 0.2],
+        "phase": [0.5, 0.6]
+      }
+    }
+  ]
+})";
+
+}  // namespace
+
+TEST(reader, ReadsAllByDefault)
+{
+  std::istringstream is(kPartials);
+  auto data = utu::PartialReader::read(is);
+  ASSERT_TRUE(data);
+  EXPECT_EQ(*data->description, "three partials");
+  EXPECT_EQ(data->source->location, "source.wav");
+  EXPECT_FALSE(data->source->fingerprint);
+  EXPECT_EQ(data->parameters.size(), 5);
+  ASSERT_EQ(data->partials.size(), 3);
+  EXPECT_EQ(*data->partials[0].label, "1");
+  EXPECT_FALSE(data->partials[2].label);
+  EXPECT_DOUBLE_EQ(data->partials[1].parameters["frequency"][1], 882.0);
+}
+
+TEST(reader, ProjectsParameters)
+{
+  utu::ReadOptions options;
+  options.parameters = {kTimeName, kFrequencyName};
+
+  auto data = utu::PartialReader::read(kPartials, options);
+  ASSERT_TRUE(data);
+  EXPECT_EQ(data->parameters, std::vector<std::string>({"time", "frequency"}));
+  ASSERT_EQ(data->partials.size(), 3);
+  for (auto& p : data->partials) {
+    EXPECT_EQ(p.parameters.size(), 2);
+    EXPECT_EQ(p.parameters.count(kAmplitudeName), 0);
+  }
+}
+
+TEST(reader, FiltersLabels)
+{
+  utu::ReadOptions options;
+  options.labels = {"2"};
+
+  auto data = utu::PartialReader::read(kPartials, options);
+  ASSERT_TRUE(data);
+  ASSERT_EQ(data->partials.size(), 1);
+  EXPECT_EQ(*data->partials[0].label, "2");
+}
+
+TEST(reader, FiltersTimeWindow)
+{
+  utu::ReadOptions options;
+  options.startTime = 1.1;
+  options.endTime = 1.6;
+  options.parameters = {kFrequencyName};
+
+  auto data = utu::PartialReader::read(kPartials, options);
+  ASSERT_TRUE(data);
+  ASSERT_EQ(data->partials.size(), 2);
+  EXPECT_DOUBLE_EQ(data->partials[0].parameters["frequency"][0], 880.0);
+  EXPECT_DOUBLE_EQ(data->partials[1].parameters["frequency"][0], 1320.0);
+  // time was needed for the filter but was not selected
+  EXPECT_EQ(data->partials[0].parameters.count(kTimeName), 0);
+}
+
+TEST(reader, FiltersPeakAmplitude)
+{
+  utu::ReadOptions options;
+  options.minPeakAmplitude = 0.25;
+
+  auto data = utu::PartialReader::read(kPartials, options);
+  ASSERT_TRUE(data);
+  ASSERT_EQ(data->partials.size(), 2);
+  EXPECT_EQ(*data->partials[0].label, "1");
+  EXPECT_FALSE(data->partials[1].label);
+}
+
+TEST(reader, RejectsMalformedInput)
+{
+  EXPECT_ANY_THROW(utu::PartialReader::read(std::string("{ \"partials\": [ ")));
+  EXPECT_FALSE(utu::PartialReader::read(std::string("[]")));
+}
+
+TEST(reader, ReadsBase64Samples)
+{
+  utu::WriteOptions writeOptions;
+  writeOptions.encoding = utu::SampleEncoding::Base64Float64;
+  std::string text = *utu::PartialWriter::write(*utu::PartialReader::read(kPartials), writeOptions);
+
+  // filters apply to decoded envelopes as they do to numbers
+  utu::ReadOptions options;
+  options.parameters = {kFrequencyName};
+  options.startTime = 1.4;
+  auto data = utu::PartialReader::read(text, options);
+  ASSERT_TRUE(data);
+  ASSERT_EQ(data->partials.size(), 1);
+  EXPECT_EQ(data->partials[0].parameters.size(), 1);
+  EXPECT_EQ(data->partials[0].parameters[kFrequencyName][1], 882.0);
+
+  const std::string header = R"({ "file_info": { "kind": "utu-partial-data", "version": 1)";
+  const std::string float64 = header + R"(, "encoding": "base64-float64le" })";
+  auto partials = [](const char* time) {
+    return std::string(R"(, "partials": [ { "parameters": { "time": ")") + time + "\" } } ] }";
+  };
+
+  // unflagged, and not a whole number of samples
+  EXPECT_THROW(utu::PartialReader::read(header + " }" + partials("AAAAAAAA4D8=")),
+               std::runtime_error);
+  EXPECT_THROW(utu::PartialReader::read(float64 + partials("AAAA")), std::runtime_error);
+
+  auto half = utu::PartialReader::read(float64 + partials("AAAAAAAA4D8="));
+  ASSERT_TRUE(half);
+  EXPECT_EQ(half->partials[0].parameters[kTimeName], utu::Partial::Samples({0.5}));
+
+  // documents later than the current version are rejected
+  const std::string later = R"({ "file_info": { "kind": "utu-partial-data", "version": )" +
+                            std::to_string(kFileVersion + 1) + " } }";
+  EXPECT_THROW(utu::PartialReader::read(later), std::runtime_error);
+}
+
+TEST(reader, ReadsBinaryFormats)
+{
+  auto source = utu::PartialReader::read(kPartials);
+  ASSERT_TRUE(source);
+
+  utu::ReadOptions options;
+  options.labels = {"2"};
+  options.parameters = {kAmplitudeName};
+  for (auto format : {utu::BinaryFormat::Cbor, utu::BinaryFormat::MessagePack}) {
+    auto data = utu::PartialReader::read(utu::PartialWriter::write(*source, format), format,
+                                         options);
+    ASSERT_TRUE(data);
+    EXPECT_EQ(data->parameters, std::vector<std::string>({kAmplitudeName}));
+    ASSERT_EQ(data->partials.size(), 1);
+    EXPECT_EQ(data->partials[0].parameters.size(), 1);
+    EXPECT_EQ(data->partials[0].parameters[kAmplitudeName][1], 0.02);
+  }
+
+  EXPECT_ANY_THROW(utu::PartialReader::read({0xa1, 0x61}, utu::BinaryFormat::Cbor));
+}
+
+TEST(reader, ReadsHeaderOnly)
+{
+  auto data = utu::PartialReader::read(kPartials);
+  ASSERT_TRUE(data);
+  data->source->fingerprint = "abc123";
+
+  utu::Summary summary = utu::summarize(*data);
+  EXPECT_EQ(summary.partials, 3);
+  EXPECT_EQ(summary.breakpoints, 7);
+  EXPECT_EQ(summary.ranges[kTimeName].min, 0.0);
+  EXPECT_EQ(summary.ranges[kTimeName].max, 2.0);
+  EXPECT_EQ(summary.ranges[kFrequencyName].min, 440.0);
+  EXPECT_EQ(summary.ranges[kFrequencyName].max, 1321.0);
+
+  // parsing stops at the partials so what follows is never read
+  std::string text = *utu::PartialWriter::write(*data);
+  text.resize(text.find("\"partials\": [") + 13);
+  std::istringstream is(text + "not json");
+  auto header = utu::PartialHeaderReader::read(is);
+  ASSERT_TRUE(header);
+  EXPECT_EQ(header->kind, "utu-partial-data");
+  EXPECT_EQ(header->version, kFileVersion);
+  EXPECT_EQ(*header->fields.description, "three partials");
+  EXPECT_EQ(header->fields.parameters.size(), 5);
+  ASSERT_TRUE(header->summary);
+  EXPECT_EQ(header->summary->partials, 3);
+  EXPECT_EQ(header->summary->breakpoints, 7);
+  EXPECT_EQ(header->summary->ranges.size(), 5);
+  EXPECT_EQ(header->summary->ranges[kAmplitudeName].max, 0.5);
+  EXPECT_EQ(header->summary->fingerprint, "abc123");
+
+  std::ostringstream os;
+  utu::PartialWriter::write(*data, os, utu::BinaryFormat::Cbor);
+  std::istringstream binary(os.str());
+  header = utu::PartialHeaderReader::read(binary, utu::BinaryFormat::Cbor);
+  ASSERT_TRUE(header && header->summary);
+  EXPECT_EQ(header->summary->ranges[kTimeName].max, 2.0);
+
+  utu::WriteOptions options;
+  options.summary = false;
+  std::istringstream plain(*utu::PartialWriter::write(*data, options));
+  header = utu::PartialHeaderReader::read(plain);
+  ASSERT_TRUE(header);
+  EXPECT_FALSE(header->summary);
+}
+
+TEST(reader, RoundTripsMarkers)
+{
+  utu::PartialData data;
+  data.parameters = {kTimeName};
+  data.markers = {{0.5, "onset"}, {1.25, ""}};
+
+  auto result = utu::PartialReader::read(*utu::PartialWriter::write(data));
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->markers.size(), 2);
+  EXPECT_DOUBLE_EQ(result->markers[0].time, 0.5);
+  EXPECT_EQ(result->markers[0].name, "onset");
+  EXPECT_DOUBLE_EQ(result->markers[1].time, 1.25);
+}
+
+TEST(reader, AllocatesFromResource)
+{
+  std::pmr::monotonic_buffer_resource arena;
+  auto data = utu::PartialReader::read(kPartials, utu::ReadOptions(), &arena);
+  ASSERT_TRUE(data);
+  ASSERT_EQ(data->partials.size(), 3);
+  EXPECT_EQ(data->partials.get_allocator().resource(), &arena);
+  for (auto& p : data->partials) {
+    EXPECT_EQ(p.parameters.get_allocator().resource(), &arena);
+    EXPECT_EQ(p.parameters.at(kFrequencyName).get_allocator().resource(), &arena);
+  }
+
+  // copies leave the arena
+  utu::PartialData copy = *data;
+  EXPECT_EQ(copy.partials.get_allocator().resource(), std::pmr::get_default_resource());
+  EXPECT_EQ(copy.partials[0].parameters.at(kFrequencyName).get_allocator().resource(),
+            std::pmr::get_default_resource());
+
+  // to and from the std containers of earlier versions
+  std::unordered_map<std::string, std::vector<double>> parameters =
+      utu::toStdParameters<double>(data->partials[1].parameters);
+  EXPECT_EQ(parameters.at(kFrequencyName), std::vector<double>({880.0, 882.0}));
+  utu::Partial::Parameters back = utu::toParameters(parameters, &arena);
+  EXPECT_EQ(back, data->partials[1].parameters);
+  EXPECT_EQ(back.at(kTimeName).get_allocator().resource(), &arena);
+}
+
+TEST(reader, ReadsFloatSamples)
+{
+  auto data = utu::FloatPartialReader::read(kPartials);
+  ASSERT_TRUE(data);
+  ASSERT_EQ(data->partials.size(), 3);
+  EXPECT_EQ(*data->description, "three partials");
+  EXPECT_EQ(data->partials[0].parameters[kAmplitudeName][2], 0.2f);
+  EXPECT_EQ(data->partials[1].parameters[kFrequencyName][1], 882.0f);
+
+  utu::ReadOptions options;
+  options.minPeakAmplitude = 0.25;
+  auto loud = utu::FloatPartialReader::read(kPartials, options);
+  ASSERT_TRUE(loud);
+  EXPECT_EQ(loud->partials.size(), 2);
+}
+
+TEST(reader, ConvertsPrecision)
+{
+  auto data = utu::PartialReader::read(kPartials);
+  ASSERT_TRUE(data);
+
+  utu::FloatPartialData narrow = utu::convert<float>(*data);
+  EXPECT_EQ(narrow.description, data->description);
+  ASSERT_EQ(narrow.partials.size(), data->partials.size());
+  for (std::size_t i = 0; i < narrow.partials.size(); ++i) {
+    EXPECT_EQ(narrow.partials[i].label, data->partials[i].label);
+    for (const auto& [name, samples] : data->partials[i].parameters) {
+      const auto& converted = narrow.partials[i].parameters.at(name);
+      ASSERT_EQ(converted.size(), samples.size());
+      for (std::size_t s = 0; s < samples.size(); ++s) {
+        EXPECT_EQ(converted[s], static_cast<float>(samples[s]));
+      }
+    }
+  }
+
+  utu::PartialData wide = utu::convert<double>(narrow);
+  EXPECT_EQ(wide.partials[0].parameters.at(kAmplitudeName)[1], 0.5);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,365 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+#include <loris/Marker.h>
+#include <loris/PartialList.h>
+#include <loris/SdifFile.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <utu/Partial.h>
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+namespace
+{
+
+utu::Partial partial(std::optional<std::string> label, utu::Partial::Samples time,
+                     utu::Partial::Samples frequency, utu::Partial::Samples amplitude,
+                     utu::Partial::Samples bandwidth, utu::Partial::Samples phase)
+{
+  utu::Partial p;
+  p.label = std::move(label);
+  p.parameters[kTimeName] = std::move(time);
+  p.parameters[kFrequencyName] = std::move(frequency);
+  p.parameters[kAmplitudeName] = std::move(amplitude);
+  p.parameters[kBandwidthName] = std::move(bandwidth);
+  p.parameters[kPhaseName] = std::move(phase);
+  return p;
+}
+
+// Big endian SDIF frames of partial rows as written by other tools
+struct SdifBuilder {
+  std::string bytes;
+
+  SdifBuilder()
+  {
+    u32("SDIF");
+    i32(8);
+    i32(3);
+    i32(1);
+  }
+
+  void u32(const char* signature) { bytes.append(signature, 4); }
+
+  void i32(int32_t v)
+  {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      bytes.push_back(static_cast<char>((static_cast<uint32_t>(v) >> shift) & 0xff));
+    }
+  }
+
+  void f64(double v)
+  {
+    uint64_t u;
+    std::memcpy(&u, &v, sizeof(u));
+    i32(static_cast<int32_t>(u >> 32));
+    i32(static_cast<int32_t>(u & 0xffffffff));
+  }
+
+  // rows of index, frequency, amplitude and phase, then noise and time
+  // offset for "RBEP"
+  void frame(const char* signature, double time, const std::vector<std::vector<double>>& rows)
+  {
+    size_t columns = rows.empty() ? 4 : rows[0].size();
+    u32(signature);
+    i32(static_cast<int32_t>(16 + 16 + rows.size() * columns * 8));
+    f64(time);
+    i32(0);
+    i32(1);
+    u32(signature);
+    i32(0x0008);
+    i32(static_cast<int32_t>(rows.size()));
+    i32(static_cast<int32_t>(columns));
+    for (const auto& row : rows) {
+      for (double v : row) {
+        f64(v);
+      }
+    }
+  }
+};
+
+// A file in the temporary directory, removed when done
+struct TempFile {
+  std::filesystem::path path;
+
+  explicit TempFile(const char* name)
+      : path(std::filesystem::temp_directory_path() / ("utu-test-" + std::string(name)))
+  {
+  }
+  ~TempFile() { std::filesystem::remove(path); }
+};
+
+// Steady 220 and 440 Hz partials over [0, 0.5] and [0.1, 0.3]
+Loris::PartialList lorisPartials()
+{
+  Loris::Partial low;
+  low.setLabel(1);
+  low.insert(0.0, Loris::Breakpoint(220.0, 0.1, 0.25, 0.0));
+  low.insert(0.1, Loris::Breakpoint(220.0, 0.2, 0.25, 1.0));
+  low.insert(0.3, Loris::Breakpoint(220.0, 0.2, 0.1, -1.0));
+  low.insert(0.5, Loris::Breakpoint(220.0, 0.0, 0.1, 2.0));
+
+  Loris::Partial high;
+  high.setLabel(2);
+  high.insert(0.1, Loris::Breakpoint(440.0, 0.05, 0.0, 0.5));
+  high.insert(0.2, Loris::Breakpoint(440.0, 0.1, 0.0, -0.5));
+  high.insert(0.3, Loris::Breakpoint(440.0, 0.0, 0.0, 1.5));
+
+  return {low, high};
+}
+
+const utu::Partial* findLabel(const utu::PartialData& data, const std::string& label)
+{
+  auto it = std::find_if(data.partials.begin(), data.partials.end(),
+                         [&](const utu::Partial& p) { return p.label == label; });
+  return it == data.partials.end() ? nullptr : &*it;
+}
+
+void expectBreakpoints(const utu::Partial& p, const Loris::Partial& expected)
+{
+  const auto& time = p.parameters.at(kTimeName);
+  ASSERT_EQ(time.size(), static_cast<std::size_t>(expected.numBreakpoints()));
+  size_t i = 0;
+  for (auto it = expected.begin(); it != expected.end(); ++it, ++i) {
+    EXPECT_NEAR(time[i], it.time(), 1e-9);
+    EXPECT_NEAR(p.parameters.at(kFrequencyName)[i], it.breakpoint().frequency(), 1e-6);
+    EXPECT_NEAR(p.parameters.at(kAmplitudeName)[i], it.breakpoint().amplitude(), 1e-6);
+    EXPECT_NEAR(p.parameters.at(kBandwidthName)[i], it.breakpoint().bandwidth(), 1e-6);
+    EXPECT_NEAR(p.parameters.at(kPhaseName)[i], it.breakpoint().phase(), 1e-6);
+  }
+}
+
+}  // namespace
+
+TEST(sdif, RoundTripsEnhancedPartials)
+{
+  // partials of different lengths, with and without labels
+  utu::PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName, kBandwidthName, kPhaseName};
+  data.markers = {{0.25, "attack"}, {1.5, "release"}};
+  data.partials.push_back(partial("3", {0.0, 0.1, 0.2, 0.3}, {220.0, 220.5, 219.75, 220.0},
+                                  {0.5, 0.49, 0.48, 0.0}, {0.0, 0.025, 0.05, 0.075},
+                                  {0.0, 0.2, -0.4, 0.6}));
+  data.partials.push_back(
+      partial({}, {0.1, 0.15, 0.3}, {440.1, 440.15, 440.3}, {0.1, 0.2, 0.0}, {0.5, 0.5, 0.5},
+              {3.0, -3.0, 1.0}));
+  data.partials.push_back(partial("12", {0.2}, {660.2}, {0.48}, {0.05}, {0.4}));
+  std::stringstream ss;
+  utu::PartialSdifWriter::write(data, ss);
+
+  auto result = utu::PartialSdifReader::read(ss);
+  ASSERT_TRUE(result);
+  EXPECT_EQ(result->parameters, data.parameters);
+
+  ASSERT_EQ(result->markers.size(), 2u);
+  EXPECT_DOUBLE_EQ(result->markers[1].time, 1.5);
+  EXPECT_EQ(result->markers[1].name, "release");
+
+  ASSERT_EQ(result->partials.size(), data.partials.size());
+  for (size_t i = 0; i < data.partials.size(); ++i) {
+    EXPECT_EQ(result->partials[i].label, data.partials[i].label);
+    EXPECT_EQ(result->partials[i].parameters, data.partials[i].parameters);
+  }
+}
+
+TEST(sdif, SinusoidalTracksDropBandwidth)
+{
+  // breakpoints on the frame grid are kept as they are
+  utu::PartialData data;
+  data.partials.push_back(partial("1", {0.0, 0.1, 0.2, 0.3}, {220.0, 220.5, 219.75, 220.0},
+                                  {0.5, 0.49, 0.48, 0.0}, {0.0, 0.025, 0.05, 0.075},
+                                  {0.0, 0.2, -0.4, 0.6}));
+  std::stringstream ss;
+  utu::PartialSdifWriter::write(data, ss, utu::PartialSdifWriter::Type::Sinusoidal);
+
+  auto result = utu::PartialSdifReader::read(ss);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), 1u);
+  auto& p = result->partials[0].parameters;
+  ASSERT_EQ(p[kTimeName].size(), 4u);
+  for (size_t i = 0; i < 4; ++i) {
+    EXPECT_NEAR(p[kTimeName][i], data.partials[0].parameters[kTimeName][i], 1e-12);
+    EXPECT_NEAR(p[kFrequencyName][i], data.partials[0].parameters[kFrequencyName][i], 1e-9);
+  }
+  for (double bw : p[kBandwidthName]) {
+    EXPECT_EQ(bw, 0.0);
+  }
+}
+
+TEST(sdif, SinusoidalFramesListLiveTracks)
+{
+  // breakpoints every 0.1s, one partial off the grid and one between frames
+  utu::PartialData data;
+  data.partials.push_back(partial({}, {0.0, 0.1, 0.2, 0.3, 0.4},
+                                  {220.0, 220.0, 220.0, 220.0, 220.0}, {0.5, 0.5, 0.5, 0.5, 0.5},
+                                  {0.0, 0.0, 0.0, 0.0, 0.0}, {0.0, 0.0, 0.0, 0.0, 0.0}));
+  data.partials.push_back(partial({}, {0.05, 0.25, 0.33}, {440.05, 440.25, 440.33},
+                                  {0.495, 0.475, 0.467}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}));
+  data.partials.push_back(
+      partial({}, {0.12, 0.14}, {660.12, 660.14}, {0.3, 0.3}, {0.0, 0.0}, {0.0, 0.0}));
+  std::stringstream ss;
+  utu::PartialSdifWriter::write(data, ss, utu::PartialSdifWriter::Type::Sinusoidal);
+
+  auto result = utu::PartialSdifReader::read(ss);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), 3u);
+
+  // resampled onto the frames within the partial
+  auto& p = result->partials[1].parameters;
+  utu::Partial::Samples times = {0.1, 0.2, 0.3};
+  utu::Partial::Samples frequencies = {440.1, 440.2, 440.3};
+  utu::Partial::Samples amplitudes = {0.49, 0.48, 0.47};
+  ASSERT_EQ(p[kTimeName].size(), 3u);
+  for (size_t i = 0; i < 3; ++i) {
+    EXPECT_NEAR(p[kTimeName][i], times[i], 1e-12);
+    EXPECT_NEAR(p[kFrequencyName][i], frequencies[i], 1e-9);
+    EXPECT_NEAR(p[kAmplitudeName][i], amplitudes[i], 1e-9);
+  }
+
+  // and the short partial to the nearest frame
+  auto& q = result->partials[2].parameters;
+  ASSERT_EQ(q[kTimeName].size(), 1u);
+  EXPECT_NEAR(q[kTimeName][0], 0.1, 1e-12);
+  EXPECT_NEAR(q[kFrequencyName][0], 660.12, 1e-9);
+}
+
+TEST(sdif, ReusedIndicesStartNewTracks)
+{
+  // index 1 ends after the second frame and comes back for a new track
+  SdifBuilder tracks;
+  tracks.frame("1TRC", 0.0, {{1, 100, 0.1, 0}, {2, 200, 0.1, 0}});
+  tracks.frame("1TRC", 0.1, {{1, 110, 0.1, 0}, {2, 200, 0.1, 0}});
+  tracks.frame("1TRC", 0.2, {{2, 200, 0.1, 0}});
+  tracks.frame("1TRC", 0.3, {{1, 300, 0.1, 0}, {2, 200, 0.1, 0}});
+  std::istringstream is(tracks.bytes);
+  auto result = utu::PartialSdifReader::read(is);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), 3u);
+  EXPECT_EQ(result->partials[0].parameters[kFrequencyName], utu::Partial::Samples({100, 110}));
+  EXPECT_EQ(result->partials[1].parameters[kTimeName].size(), 4u);
+  EXPECT_EQ(result->partials[2].parameters[kFrequencyName], utu::Partial::Samples({300}));
+
+  // bandwidth enhanced frames only hold partials with a breakpoint there, an
+  // index continues its partial until its times stop advancing
+  SdifBuilder enhanced;
+  enhanced.frame("RBEP", 0.0, {{1, 100, 0.1, 0, 0, 0}});
+  enhanced.frame("RBEP", 0.2, {{2, 200, 0.1, 0, 0, 0}});
+  enhanced.frame("RBEP", 0.4, {{1, 120, 0.1, 0, 0, 0}, {2, 200, 0.1, 0, 0, -0.2}});
+  is.clear();
+  is.str(enhanced.bytes);
+  result = utu::PartialSdifReader::read(is);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), 3u);
+  EXPECT_EQ(result->partials[0].parameters[kFrequencyName], utu::Partial::Samples({100, 120}));
+  EXPECT_EQ(result->partials[1].parameters[kTimeName], utu::Partial::Samples({0.2}));
+  EXPECT_EQ(result->partials[2].parameters[kTimeName], utu::Partial::Samples({0.2}));
+}
+
+TEST(sdif, ReadsFilesWrittenByLoris)
+{
+  Loris::PartialList partials = lorisPartials();
+  Loris::SdifFile out(partials.begin(), partials.end());
+  out.markers().push_back(Loris::Marker(0.25, "attack"));
+  TempFile enhanced("loris.sdif");
+  out.write(enhanced.path.string());
+
+  std::ifstream is(enhanced.path, std::ios::binary);
+  auto result = utu::PartialSdifReader::read(is);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), 2u);
+  ASSERT_EQ(result->markers.size(), 1u);
+  EXPECT_DOUBLE_EQ(result->markers[0].time, 0.25);
+  EXPECT_EQ(result->markers[0].name, "attack");
+  for (const auto& expected : partials) {
+    const utu::Partial* p = findLabel(*result, std::to_string(expected.label()));
+    ASSERT_TRUE(p) << expected.label();
+    expectBreakpoints(*p, expected);
+  }
+
+  // sinusoidal tracks keep the frequencies of both partials
+  TempFile sinusoidal("loris-1trc.sdif");
+  out.write1TRC(sinusoidal.path.string());
+  std::ifstream tracks(sinusoidal.path, std::ios::binary);
+  result = utu::PartialSdifReader::read(tracks);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), 2u);
+  for (const auto& p : result->partials) {
+    const auto& frequency = p.parameters.at(kFrequencyName);
+    ASSERT_FALSE(frequency.empty());
+    double expected = frequency.front() < 330 ? 220.0 : 440.0;
+    for (double f : frequency) {
+      EXPECT_NEAR(f, expected, 1e-6);
+    }
+  }
+}
+
+TEST(sdif, LorisReadsNativeFiles)
+{
+  // the partials and markers of a Loris file, written natively
+  Loris::PartialList expected = lorisPartials();
+  utu::PartialData data;
+  data.markers = {{0.25, "attack"}};
+  for (const auto& q : expected) {
+    utu::Partial& p = data.partials.emplace_back();
+    p.label = std::to_string(q.label());
+    for (auto it = q.begin(); it != q.end(); ++it) {
+      p.parameters[kTimeName].push_back(it.time());
+      p.parameters[kFrequencyName].push_back(it.breakpoint().frequency());
+      p.parameters[kAmplitudeName].push_back(it.breakpoint().amplitude());
+      p.parameters[kBandwidthName].push_back(it.breakpoint().bandwidth());
+      p.parameters[kPhaseName].push_back(it.breakpoint().phase());
+    }
+  }
+
+  TempFile enhanced("native.sdif");
+  {
+    std::ofstream os(enhanced.path, std::ios::binary);
+    utu::PartialSdifWriter::write(data, os);
+  }
+  Loris::SdifFile in(enhanced.path.string());
+  ASSERT_EQ(in.partials().size(), 2u);
+  ASSERT_EQ(in.markers().size(), 1u);
+  EXPECT_DOUBLE_EQ(in.markers()[0].time(), 0.25);
+  EXPECT_EQ(in.markers()[0].name(), "attack");
+
+  // compared through the native representation of what Loris read
+  for (const auto& q : in.partials()) {
+    const utu::Partial* p = findLabel(data, std::to_string(q.label()));
+    ASSERT_TRUE(p) << q.label();
+    expectBreakpoints(*p, q);
+  }
+
+  TempFile sinusoidal("native-1trc.sdif");
+  {
+    std::ofstream os(sinusoidal.path, std::ios::binary);
+    utu::PartialSdifWriter::write(data, os, utu::PartialSdifWriter::Type::Sinusoidal);
+  }
+  Loris::SdifFile tracks(sinusoidal.path.string());
+  ASSERT_EQ(tracks.partials().size(), 2u);
+  for (const auto& q : tracks.partials()) {
+    ASSERT_NE(q.begin(), q.end());
+    double frequency = q.begin().breakpoint().frequency();
+    EXPECT_NEAR(frequency, frequency < 330 ? 220.0 : 440.0, 1e-6);
+    EXPECT_NEAR(q.duration(), frequency < 330 ? 0.5 : 0.2, 0.011);
+  }
+}
+
+TEST(sdif, RejectsOtherFormats)
+{
+  std::istringstream is("{\"partials\": []}");
+  EXPECT_FALSE(utu::PartialSdifReader::read(is));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <utu/PartialData.h>
+
+#include "Splice.h"
+
+namespace
+{
+
+constexpr double kOverlap = 0.1;
+
+// A partial gliding linearly from f0 to f1 between t0 and t1 with
+// breakpoints every step seconds.
+utu::Partial glide(double t0, double t1, double f0, double f1, double step = 0.01)
+{
+  utu::Partial p;
+  auto count = static_cast<int>((t1 - t0) / step + 0.5);
+  for (int i = 0; i <= count; ++i) {
+    double x = static_cast<double>(i) / count;
+    p.parameters[kTimeName].push_back(t0 + x * (t1 - t0));
+    p.parameters[kFrequencyName].push_back(f0 + x * (f1 - f0));
+    p.parameters[kAmplitudeName].push_back(0.1);
+  }
+  return p;
+}
+
+// Two bands split at 1000 Hz
+std::vector<utu::BandPartials> split(utu::PartialData::Partials below,
+                                     utu::PartialData::Partials above)
+{
+  return {{0, 1000, 40, std::move(below)},
+          {1000, std::numeric_limits<double>::infinity(), 80, std::move(above)}};
+}
+
+}  // namespace
+
+TEST(splice, KeepsPartialsWithinTheirBand)
+{
+  // the upper band resolves the low partial as well, the lower band sees
+  // the start of the high one within its overlap
+  auto bands = split({glide(0, 1, 500, 500), glide(0, 1, 1080, 1080)},
+                     {glide(0, 1, 505, 505), glide(0, 1, 2000, 2000)});
+  utu::PartialData::Partials merged = utu::mergeBands(bands, kOverlap);
+  ASSERT_EQ(merged.size(), 2u);
+  EXPECT_EQ(merged[0].parameters[kFrequencyName].front(), 500);
+  EXPECT_EQ(merged[1].parameters[kFrequencyName].front(), 2000);
+}
+
+TEST(splice, RemovesDuplicatesAtEdge)
+{
+  // one partial tracked on both sides of the edge, its estimates straddling
+  // it, and partials in the overlap which are not duplicates: at a different
+  // time, and at the same time further apart than the resolution allows
+  auto bands = split({glide(0, 1, 995, 995), glide(0, 1, 960, 960)},
+                     {glide(0, 1, 1003, 1003, 0.0125), glide(2, 3, 1001, 1001),
+                      glide(0, 1, 1050, 1050)});
+  utu::PartialData::Partials merged = utu::mergeBands(bands, kOverlap);
+  ASSERT_EQ(merged.size(), 4u);
+
+  // the lower band keeps its own estimate of the duplicate
+  const auto& frequency = merged[0].parameters[kFrequencyName];
+  EXPECT_EQ(frequency.front(), 995);
+  EXPECT_EQ(frequency.back(), 995);
+  EXPECT_EQ(merged[0].parameters[kTimeName].size(), frequency.size());
+
+  EXPECT_EQ(merged[1].parameters[kFrequencyName].front(), 960);
+  EXPECT_EQ(merged[2].parameters[kFrequencyName].front(), 1001);
+  EXPECT_EQ(merged[3].parameters[kFrequencyName].front(), 1050);
+}
+
+TEST(splice, JoinsGlideAcrossEdge)
+{
+  // a glide from 800 to 1200 Hz over a second, the lower band loses it at the
+  // top of its overlap and the upper band only finds it near the edge
+  auto bands = split({glide(0, 0.75, 800, 1100)}, {glide(0.3, 1, 922, 1202, 0.0125)});
+  utu::PartialData::Partials merged = utu::mergeBands(bands, kOverlap);
+  ASSERT_EQ(merged.size(), 1u);
+
+  const auto& time = merged[0].parameters[kTimeName];
+  const auto& frequency = merged[0].parameters[kFrequencyName];
+  ASSERT_EQ(frequency.size(), time.size());
+  ASSERT_EQ(merged[0].parameters[kAmplitudeName].size(), time.size());
+  EXPECT_EQ(time.front(), 0);
+  EXPECT_EQ(time.back(), 1);
+  EXPECT_EQ(frequency.front(), 800);
+  EXPECT_EQ(frequency.back(), 1202);
+
+  for (std::size_t i = 1; i < time.size(); ++i) {
+    EXPECT_LT(time[i - 1], time[i]);
+    // below the edge the breakpoints are those of the lower band which is
+    // exact, above it those of the upper band 2 Hz sharp
+    double expected = 800 + 400 * time[i];
+    EXPECT_NEAR(frequency[i], expected < 1000 ? expected : expected + 2, 1e-9) << time[i];
+  }
+}
+
+TEST(splice, SplicesAcrossRegionEdges)
+{
+  // a steady partial crossing both edges of the region [1, 1.5], one before
+  // the region which is kept and one within it which is replaced
+  utu::PartialData previous;
+  previous.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  previous.partials = {glide(0, 2, 440, 440), glide(0.5, 0.8, 660, 660),
+                       glide(1.1, 1.4, 880, 880)};
+
+  // the new analysis of the padded region finds the partial slightly sharp
+  // and a new one too far from the previous partials to continue them
+  utu::PartialData::Partials region = {glide(0.9, 1.6, 440.5, 440.5), glide(0.9, 1.6, 500, 500)};
+  utu::PartialData data = utu::spliceRegion(previous, region, 1, 1.5, 0.011, 30);
+  EXPECT_EQ(data.parameters, previous.parameters);
+  ASSERT_EQ(data.partials.size(), 3u);
+  EXPECT_EQ(data.partials[0].parameters, previous.partials[1].parameters);
+
+  const auto& time = data.partials[1].parameters[kTimeName];
+  const auto& frequency = data.partials[1].parameters[kFrequencyName];
+  ASSERT_EQ(frequency.size(), time.size());
+  EXPECT_EQ(time.front(), 0);
+  EXPECT_EQ(time.back(), 2);
+  for (std::size_t i = 0; i < time.size(); ++i) {
+    if (i > 0) {
+      EXPECT_LT(time[i - 1], time[i]);
+    }
+    bool inside = time[i] >= 1 && time[i] <= 1.5;
+    EXPECT_EQ(frequency[i], inside ? 440.5 : 440) << time[i];
+  }
+
+  const auto& added = data.partials[2].parameters[kTimeName];
+  EXPECT_EQ(added.front(), 1);
+  EXPECT_EQ(added.back(), 1.5);
+}
+
+TEST(splice, SplicesRegionAtEnd)
+{
+  utu::PartialData previous;
+  previous.partials = {glide(0, 2, 440, 440)};
+
+  // nothing follows the region so the new partial only continues the head,
+  // a partial whose joint drifts too far starts afresh
+  utu::PartialData::Partials region = {glide(1.7, 2, 441, 441), glide(1.7, 2, 480, 480)};
+  utu::PartialData data = utu::spliceRegion(previous, region, 1.8, 2, 0.011, 30);
+  ASSERT_EQ(data.partials.size(), 2u);
+
+  const auto& time = data.partials[0].parameters[kTimeName];
+  const auto& frequency = data.partials[0].parameters[kFrequencyName];
+  ASSERT_EQ(frequency.size(), time.size());
+  EXPECT_EQ(time.front(), 0);
+  EXPECT_EQ(time.back(), 2);
+  EXPECT_EQ(frequency.front(), 440);
+  EXPECT_EQ(frequency.back(), 441);
+
+  EXPECT_EQ(data.partials[1].parameters[kFrequencyName].front(), 480);
+  EXPECT_GE(data.partials[1].parameters[kTimeName].front(), 1.8);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,168 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <initializer_list>
+#include <stdexcept>
+#include <utu/Harmonic.h>
+#include <utu/Synthesis.h>
+#include <vector>
+
+namespace
+{
+
+constexpr double kSampleRate = 8000;
+
+// A steady partial from 0 to 1 second, without bandwidth or phase
+utu::Partial steady(const std::string& label, double frequency, double amplitude)
+{
+  utu::Partial p;
+  p.label = label;
+  p.parameters[kTimeName] = {0.0, 0.5, 1.0};
+  p.parameters[kFrequencyName] = {frequency, frequency, frequency};
+  p.parameters[kAmplitudeName] = {amplitude, amplitude, amplitude};
+  return p;
+}
+
+utu::PartialData withPartials(std::initializer_list<utu::Partial> partials)
+{
+  utu::PartialData data;
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  for (const auto& p : partials) {
+    data.partials.push_back(p);
+  }
+  return data;
+}
+
+utu::SynthOptions makeOptions()
+{
+  utu::SynthOptions options;
+  options.sampleRate = kSampleRate;
+  return options;
+}
+
+// RMS level of [start, end) seconds
+double rms(const std::vector<double>& samples, double start, double end)
+{
+  auto first = static_cast<std::size_t>(start * kSampleRate);
+  auto last = static_cast<std::size_t>(end * kSampleRate);
+  double total = 0;
+  for (std::size_t i = first; i < last; ++i) {
+    total += samples[i] * samples[i];
+  }
+  return std::sqrt(total / static_cast<double>(last - first));
+}
+
+// Frequency of a sinusoid over [start, end) seconds from its zero crossings
+double frequency(const std::vector<double>& samples, double start, double end)
+{
+  auto first = static_cast<std::size_t>(start * kSampleRate);
+  auto last = static_cast<std::size_t>(end * kSampleRate);
+  std::size_t crossings = 0;
+  for (std::size_t i = first + 1; i < last; ++i) {
+    if ((samples[i - 1] < 0) != (samples[i] < 0)) {
+      ++crossings;
+    }
+  }
+  return static_cast<double>(crossings) / (2 * (end - start));
+}
+
+}  // namespace
+
+TEST(synthesis, RendersPartials)
+{
+  utu::PartialData data = withPartials({steady("1", 200, 0.5)});
+  std::vector<double> samples = utu::synthesize(data, makeOptions());
+  EXPECT_NEAR(static_cast<double>(samples.size()), kSampleRate, 0.01 * kSampleRate);
+  EXPECT_NEAR(rms(samples, 0.25, 0.75), 0.5 / std::sqrt(2.0), 0.01);
+  EXPECT_NEAR(frequency(samples, 0.25, 0.75), 200, 4);
+
+  // float data renders the same
+  std::vector<double> floats = utu::synthesize(utu::convert<float>(data), makeOptions());
+  ASSERT_EQ(floats.size(), samples.size());
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_NEAR(floats[i], samples[i], 1e-6) << i;
+  }
+}
+
+TEST(synthesis, AppliesTransforms)
+{
+  utu::PartialData data = withPartials({steady("1", 200, 0.5), steady("noise", 1000, 0.5)});
+
+  utu::SynthOptions options = makeOptions();
+  options.pitchShift = 1200;
+  options.timeStretch = 2;
+  options.gain = -20 * std::log10(2.0);
+  options.mutedLabels = {"noise"};
+  std::vector<double> samples = utu::synthesize(data, options);
+
+  EXPECT_NEAR(static_cast<double>(samples.size()), 2 * kSampleRate, 0.01 * kSampleRate);
+  EXPECT_NEAR(rms(samples, 0.5, 1.5), 0.25 / std::sqrt(2.0), 0.01);
+  EXPECT_NEAR(frequency(samples, 0.5, 1.5), 400, 4);
+}
+
+TEST(synthesis, RendersHarmonicRelative)
+{
+  utu::PartialData data = withPartials({steady("1", 200, 0.5), steady("2", 400, 0.25)});
+  std::vector<double> expected = utu::synthesize(data, makeOptions());
+
+  utu::makeHarmonicRelative(data);
+  ASSERT_TRUE(data.fundamental);
+  std::vector<double> samples = utu::synthesize(data, makeOptions());
+  ASSERT_EQ(samples.size(), expected.size());
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_NEAR(samples[i], expected[i], 1e-6) << i;
+  }
+}
+
+TEST(synthesis, RendersIntoBuffer)
+{
+  utu::PartialData data = withPartials({steady("1", 200, 0.5)});
+  std::vector<double> expected = utu::synthesize(data, makeOptions());
+
+  std::vector<double> samples(expected.size() + 100, 1.0);
+  EXPECT_EQ(utu::synthesize(data, makeOptions(), samples.data(), samples.size()), expected.size());
+  for (std::size_t i = 0; i < samples.size(); ++i) {
+    EXPECT_EQ(samples[i], i < expected.size() ? expected[i] : 0.0) << i;
+  }
+
+  // shorter buffers are truncated
+  EXPECT_EQ(utu::synthesize(data, makeOptions(), samples.data(), 10), expected.size());
+  EXPECT_EQ(samples[9], expected[9]);
+}
+
+TEST(synthesis, RejectsMissingEnvelopes)
+{
+  utu::PartialData data = withPartials({steady("1", 200, 0.5), steady("2", 400, 0.25)});
+  data.partials.back().parameters.erase(kAmplitudeName);
+  EXPECT_THROW(utu::synthesize(data, makeOptions()), std::invalid_argument);
+
+  // unless muted
+  utu::SynthOptions options = makeOptions();
+  options.mutedLabels = {"2"};
+  EXPECT_EQ(utu::synthesize(data, options).size(),
+            utu::synthesize(withPartials({steady("1", 200, 0.5)}), makeOptions()).size());
+}
+
+TEST(synthesis, RejectsMismatchedEnvelopes)
+{
+  utu::PartialData data = withPartials({steady("1", 200, 0.5)});
+  data.partials.back().parameters[kAmplitudeName].pop_back();
+  EXPECT_THROW(utu::synthesize(data, makeOptions()), std::invalid_argument);
+
+  // optional envelopes must match too
+  data.partials.back() = steady("1", 200, 0.5);
+  data.partials.back().parameters[kPhaseName] = {0.0, 1.0};
+  EXPECT_THROW(utu::synthesize(data, makeOptions()), std::invalid_argument);
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
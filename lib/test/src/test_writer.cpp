@@ -0,0 +1,197 @@
+//
+// Copyright (c) 2021 Greg Wuller.
+//
+// SPDX-License-Identifier: MIT
+//
+
+#include <gtest/gtest.h>
+#include <nlohmann/json.hpp>
+
+#include <sstream>
+#include <utu/Partial.h>
+#include <utu/PartialData.h>
+#include <utu/PartialIO.h>
+
+#include "Base64.h"
+#include "SerializerImpl.h"
+
+using json = nlohmann::json;
+
+namespace
+{
+
+utu::PartialData makeData(size_t count, size_t breakpoints)
+{
+  utu::PartialData data;
+  data.description = "writer \"test\"\n";
+  data.source = utu::PartialData::Source({"source.wav", {}});
+  data.parameters = {kTimeName, kFrequencyName, kAmplitudeName};
+  for (size_t i = 0; i < count; ++i) {
+    utu::Partial& p = data.partials.emplace_back();
+    if (i % 3) {
+      p.label = std::to_string(i);
+    }
+    for (size_t b = 0; b < breakpoints + i % 7; ++b) {
+      double x = static_cast<double>(i * breakpoints + b);
+      p.parameters[kTimeName].push_back(x * 0.001);
+      p.parameters[kFrequencyName].push_back(440.0 + x / 3.0);
+      p.parameters[kAmplitudeName].push_back(1.0 / (x + 1.0));
+    }
+  }
+  return data;
+}
+
+// The document as produced by dumping the whole json DOM at once
+std::string reference(const utu::PartialData& data)
+{
+  json j = data;
+  utu::FileInfo info({kFileKind, kFileVersion});
+  info.summary = utu::summarize(data);
+  j["file_info"] = info;
+  return j.dump(2);
+}
+
+}  // namespace
+
+TEST(writer, MatchesDocumentDump)
+{
+  for (size_t count : {0u, 1u, 2u, 10u}) {
+    utu::PartialData data = makeData(count, 4);
+    EXPECT_EQ(*utu::PartialWriter::write(data), reference(data));
+  }
+
+  utu::PartialData empty;
+  EXPECT_EQ(*utu::PartialWriter::write(empty), reference(empty));
+}
+
+TEST(writer, ParallelMatchesSerial)
+{
+  // large enough to take the parallel path
+  utu::PartialData data = makeData(3000, 40);
+  std::string expected = reference(data);
+
+  for (unsigned threads : {1u, 2u, 3u, 8u}) {
+    utu::WriteOptions options;
+    options.threads = threads;
+    EXPECT_EQ(*utu::PartialWriter::write(data, options), expected);
+
+    std::ostringstream os;
+    utu::PartialWriter::write(data, os, options);
+    EXPECT_EQ(os.str(), expected + "\n");
+  }
+}
+
+TEST(writer, WritesShortestFloats)
+{
+  utu::FloatPartialData data = utu::convert<float>(makeData(5, 4));
+  std::string text = *utu::FloatPartialWriter::write(data);
+
+  // 0.1f widened to double would be written as 0.10000000149011612
+  utu::FloatPartialData tenth;
+  tenth.parameters = {kTimeName};
+  tenth.partials.emplace_back().parameters[kTimeName] = {0.1f};
+  EXPECT_NE(utu::FloatPartialWriter::write(tenth)->find("0.1\n"), std::string::npos);
+
+  auto result = utu::FloatPartialReader::read(text);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), data.partials.size());
+  for (std::size_t i = 0; i < data.partials.size(); ++i) {
+    EXPECT_EQ(result->partials[i].label, data.partials[i].label);
+    EXPECT_EQ(result->partials[i].parameters, data.partials[i].parameters);
+  }
+}
+
+TEST(writer, WritesBase64Samples)
+{
+  utu::PartialData data = makeData(20, 6);
+  utu::WriteOptions options;
+  options.encoding = utu::SampleEncoding::Base64Float64;
+  std::string text = *utu::PartialWriter::write(data, options);
+
+  json j = json::parse(text);
+  EXPECT_EQ(j["file_info"]["encoding"], "base64-float64le");
+  EXPECT_TRUE(j["partials"][0]["parameters"][kTimeName].is_string());
+
+  auto result = utu::PartialReader::read(text);
+  ASSERT_TRUE(result);
+  ASSERT_EQ(result->partials.size(), data.partials.size());
+  for (std::size_t i = 0; i < data.partials.size(); ++i) {
+    EXPECT_EQ(result->partials[i].label, data.partials[i].label);
+    EXPECT_EQ(result->partials[i].parameters, data.partials[i].parameters);
+  }
+
+  // float32 samples narrow on write and widen on read
+  options.encoding = utu::SampleEncoding::Base64Float32;
+  auto narrow = utu::FloatPartialReader::read(*utu::PartialWriter::write(data, options));
+  ASSERT_TRUE(narrow);
+  EXPECT_EQ(narrow->partials[3].parameters, utu::convert<float>(data).partials[3].parameters);
+}
+
+TEST(writer, WritesBinaryFormats)
+{
+  utu::PartialData data = makeData(20, 6);
+  utu::FloatPartialData narrow = utu::convert<float>(data);
+
+  for (auto format : {utu::BinaryFormat::Cbor, utu::BinaryFormat::MessagePack}) {
+    std::vector<std::uint8_t> bytes = utu::PartialWriter::write(data, format);
+    auto result = utu::PartialReader::read(bytes, format);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(*result->description, *data.description);
+    ASSERT_EQ(result->partials.size(), data.partials.size());
+    for (std::size_t i = 0; i < data.partials.size(); ++i) {
+      EXPECT_EQ(result->partials[i].label, data.partials[i].label);
+      EXPECT_EQ(result->partials[i].parameters, data.partials[i].parameters);
+    }
+
+    // float data is written as float32 arrays, widened when read as double
+    std::ostringstream os;
+    utu::FloatPartialWriter::write(narrow, os, format);
+    std::istringstream is(os.str());
+    auto wide = utu::PartialReader::read(is, format);
+    ASSERT_TRUE(wide);
+    EXPECT_EQ(utu::convert<float>(*wide).partials[5].parameters, narrow.partials[5].parameters);
+  }
+
+  // envelopes are untagged byte strings of little endian float64 samples
+  json j = json::from_cbor(utu::PartialWriter::write(data, utu::BinaryFormat::Cbor));
+  EXPECT_EQ(j["file_info"]["encoding"], "float64le");
+  const auto& time = j["partials"][0]["parameters"][kTimeName];
+  ASSERT_TRUE(time.is_binary());
+  EXPECT_FALSE(time.get_binary().has_subtype());
+  EXPECT_EQ(time.get_binary().size(), 6 * sizeof(double));
+
+  // the summary is optional, the sample encoding does not apply
+  utu::WriteOptions options;
+  options.summary = false;
+  j = json::from_msgpack(utu::PartialWriter::write(data, utu::BinaryFormat::MessagePack, options));
+  EXPECT_FALSE(j["file_info"].contains("summary"));
+  options.encoding = utu::SampleEncoding::Base64Float64;
+  EXPECT_THROW(utu::PartialWriter::write(data, utu::BinaryFormat::Cbor, options),
+               std::invalid_argument);
+}
+
+TEST(writer, Base64Vectors)
+{
+  // RFC 4648 test vectors
+  const std::pair<std::string, std::string> vectors[] = {
+      {"", ""},         {"f", "Zg=="},         {"fo", "Zm8="},         {"foo", "Zm9v"},
+      {"foob", "Zm9vYg=="}, {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"},
+  };
+  std::vector<std::uint8_t> bytes;
+  for (const auto& [plain, encoded] : vectors) {
+    std::string out;
+    utu::base64Encode(reinterpret_cast<const std::uint8_t*>(plain.data()), plain.size(), out);
+    EXPECT_EQ(out, encoded);
+    ASSERT_TRUE(utu::base64Decode(encoded, bytes));
+    EXPECT_EQ(std::string(bytes.begin(), bytes.end()), plain);
+  }
+
+  EXPECT_FALSE(utu::base64Decode("Zm9", bytes));
+  EXPECT_FALSE(utu::base64Decode("Zm9v!A==", bytes));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}